@@ -0,0 +1,47 @@
+﻿#pragma once
+
+#include "mll/mll_defines.h"
+#include "mll/mll_interfaces.h"
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+
+
+namespace bench
+{
+	/**
+	 * @brief measure average time of function.
+	 *
+	 * @param[in]	iterations		call count.
+	 * @param[in]	func			function to measure.
+	 * @return						nanoseconds per call.
+	*/
+	template <typename TFunc>
+	double MeasureNs(mll::u32 iterations, TFunc func)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for (mll::u32 i = 0; i < iterations; i++)
+		{
+			func(i);
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(iterations);
+	}
+
+	//! keep result from optimization.
+	extern volatile mll::u64 g_sink;
+
+	void RunHashBench();
+	void RunDeviceBench();
+	void RunCpuExecuteBench();
+	void RunFrameRingBench();
+	void RunRecordBench();
+	void RunCaptureBench();
+	void RunSortBench();
+	void RunRenderThreadBench();
+
+}	// namespace bench
+
+
+//	EOF
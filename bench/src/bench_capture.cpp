@@ -0,0 +1,109 @@
+﻿#include "bench.h"
+#include "mll/mll_command_capture.h"
+
+#include <cstdio>
+#include <vector>
+
+
+namespace bench
+{
+	//-----------------------------------------------------------
+	// capture synthetic frame and compare replay with live recording.
+	//-----------------------------------------------------------
+	void RunCaptureBench()
+	{
+		using namespace mll;
+
+		auto device = IDevice::CreateGraphicsDevice(DeviceDesc());
+		if (!device.IsValid())
+		{
+			printf("failed to create device.\n");
+			return;
+		}
+
+		printf("--- command capture ---\n");
+
+		const char* kCapturePath = "mll_bench_capture.bin";
+		const u32 kTextureCount = 8;
+		const u32 kListCount = 4;
+		const u32 kPacketsPerList = 1000;
+		const u32 kIterations = 100;
+
+		TextureDesc desc;
+		desc.SetDimension(ResourceDimension::Texture2D)
+			.SetWidth(16).SetHeight(16)
+			.SetFormat(ResourceFormat::R8G8B8A8_Unorm)
+			.SetUsageFlags(ResourceUsageFlag::RenderTarget);
+		std::vector<ObjPtr<ITexture>> textures(kTextureCount);
+		for (auto&& tex : textures)
+		{
+			device->CreateTexture(desc, tex);
+		}
+
+		std::vector<ObjPtr<ICommandList>> cmds(kListCount);
+		std::vector<ICommandList*> p_cmds(kListCount);
+		for (u32 i = 0; i < kListCount; i++)
+		{
+			device->CreateCommandList(CommandListDesc(), cmds[i]);
+			p_cmds[i] = cmds[i];
+		}
+
+		// two batched submissions of two command lists.
+		const f32 kColor[] = { 0.25f, 0.5f, 0.75f, 1.0f };
+		auto frame = [&]()
+		{
+			for (u32 i = 0; i < kListCount; i++)
+			{
+				auto&& cmd = cmds[i];
+				cmd->Begin();
+				for (u32 j = 0; j < kPacketsPerList; j += 2)
+				{
+					ITexture* p_dst = textures[(i + j) % kTextureCount];
+					ITexture* p_src = textures[(i + j + 1) % kTextureCount];
+					cmd->ClearTexture(p_src, 0, kColor);
+					cmd->CopyTexture(p_dst, 0, p_src, 0);
+				}
+				cmd->End();
+			}
+			device->Submit(CommandQueueType::Graphics, p_cmds.data(), kListCount / 2);
+			device->Submit(CommandQueueType::Graphics, p_cmds.data() + kListCount / 2, kListCount / 2);
+		};
+
+		frame();		// warm up arena pages.
+		f64 live_ns = MeasureNs(kIterations, [&](u32) { frame(); });
+
+		if (IsFailed(device->BeginCapture(kCapturePath)))
+		{
+			printf("failed to begin capture.\n");
+			return;
+		}
+		frame();
+		device->EndCapture();
+
+		{
+			CommandCaptureReplay replay;
+			if (IsFailed(replay.Open(kCapturePath)) || IsFailed(replay.Prepare(device)))
+			{
+				printf("failed to open capture.\n");
+				return;
+			}
+			auto&& header = replay.GetHeader();
+
+			auto ticket = replay.Replay();		// warm up arena pages.
+			f64 replay_ns = MeasureNs(kIterations, [&](u32) { ticket = replay.Replay(); });
+			device->WaitTicket(ticket);
+
+			printf("capture: %u textures, %u submits, %u lists, %llu packets in %llu bytes\n",
+				header.textureCount, header.submitCount, header.listCount,
+				static_cast<unsigned long long>(header.packetCount), static_cast<unsigned long long>(header.recordBytes));
+			printf("live frame: %.2f us, replay frame: %.2f us (%.2f ns/packet)\n",
+				live_ns / 1000.0, replay_ns / 1000.0, replay_ns / static_cast<f64>(header.packetCount));
+		}
+
+		remove(kCapturePath);
+	}
+
+}	// namespace bench
+
+
+//	EOF
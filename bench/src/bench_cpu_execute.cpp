@@ -0,0 +1,66 @@
+﻿#include "bench.h"
+
+
+namespace bench
+{
+	//-----------------------------------------------------------
+	// measure memory bandwidth of CPU command execution.
+	//-----------------------------------------------------------
+	void RunCpuExecuteBench()
+	{
+		using namespace mll;
+
+		auto device = IDevice::CreateGraphicsDevice(DeviceDesc());
+		if (!device.IsValid())
+		{
+			printf("failed to create device.\n");
+			return;
+		}
+
+		printf("--- cpu execute ---\n");
+
+		const u32 kWidth = 3840;
+		const u32 kHeight = 2160;
+		const u32 kIterations = 8;
+
+		TextureDesc desc;
+		desc.SetDimension(ResourceDimension::Texture2D)
+			.SetWidth(kWidth).SetHeight(kHeight)
+			.SetFormat(ResourceFormat::R8G8B8A8_Unorm)
+			.SetUsageFlags(ResourceUsageFlag::RenderTarget);
+		ObjPtr<ITexture> rgba8_a, rgba8_b, rgba16f, msaa;
+		device->CreateTexture(desc, rgba8_a);
+		device->CreateTexture(desc, rgba8_b);
+		device->CreateTexture(TextureDesc(desc).SetFormat(ResourceFormat::R16G16B16A16_Float), rgba16f);
+		device->CreateTexture(TextureDesc(desc).SetSampleCount(4), msaa);
+
+		ObjPtr<ICommandList> cmd;
+		device->CreateCommandList(CommandListDesc(), cmd);
+
+		// returns GB/s of bytes read and written.
+		auto measure = [&](f64 bytes, const std::function<void()>& record)
+		{
+			f64 ns = MeasureNs(kIterations, [&](u32)
+			{
+				cmd->Begin();
+				record();
+				cmd->End();
+				device->Submit(cmd);
+			});
+			return bytes / ns;
+		};
+
+		const f32 kColor[] = { 0.25f, 0.5f, 0.75f, 1.0f };
+		f64 texels = static_cast<f64>(kWidth) * kHeight;
+		f64 clear = measure(texels * 4, [&] { cmd->ClearTexture(rgba8_a, 0, kColor); });
+		f64 copy = measure(texels * 8, [&] { cmd->CopyTexture(rgba8_b, 0, rgba8_a, 0); });
+		f64 convert = measure(texels * 12, [&] { cmd->CopyTexture(rgba16f, 0, rgba8_a, 0); });
+		f64 resolve = measure(texels * 20, [&] { cmd->ResolveTexture(rgba8_b, 0, msaa, 0); });
+
+		printf("%ux%u rgba8 (GB/s): clear %.2f, copy %.2f, convert to rgba16f %.2f, resolve 4x %.2f\n", kWidth, kHeight, clear, copy, convert, resolve);
+	}
+
+}	// namespace bench
+
+
+//	EOF
@@ -0,0 +1,111 @@
+﻿#include "bench.h"
+
+#include <vector>
+#include <string>
+
+
+namespace bench
+{
+	//-----------------------------------------------------------
+	// measure CPU side API overhead.
+	//-----------------------------------------------------------
+	void RunDeviceBench()
+	{
+		using namespace mll;
+
+		DeviceDesc device_desc;
+		auto device = IDevice::CreateGraphicsDevice(device_desc);
+		if (!device.IsValid())
+		{
+			printf("failed to create device.\n");
+			return;
+		}
+
+		printf("--- device ---\n");
+
+		const u32 kIterations = 100000;
+
+		// create and kill.
+		TextureDesc tex_desc;
+		tex_desc.SetDimension(ResourceDimension::Texture2D)
+			.SetWidth(16).SetHeight(16)
+			.SetFormat(ResourceFormat::R8G8B8A8_Unorm)
+			.SetUsageFlags(ResourceUsageFlag::ShaderResource);
+		double create_tex = MeasureNs(kIterations, [&](u32 i)
+		{
+			ObjPtr<ITexture> tex;
+			device->CreateTexture(tex_desc, tex);
+			g_sink += tex->GetObjectId();
+		});
+		double proc_death = MeasureNs(1, [&](u32) { device->ProcDeathList(); });
+		printf("create/release texture: %.1f ns, death list: %.1f ns/object\n", create_tex, proc_death / kIterations);
+
+		CommandListDesc cmd_desc;
+		double create_cmd = MeasureNs(kIterations, [&](u32 i)
+		{
+			ObjPtr<ICommandList> cmd;
+			device->CreateCommandList(cmd_desc, cmd);
+			g_sink += cmd->GetObjectId();
+		});
+		device->ProcDeathList();
+		printf("create/release command list: %.1f ns\n", create_cmd);
+
+		// record.
+		ObjPtr<ICommandList> cmd;
+		device->CreateCommandList(cmd_desc, cmd);
+		double begin_end = MeasureNs(kIterations, [&](u32 i)
+		{
+			cmd->Begin();
+			cmd->End();
+		});
+		printf("command list begin/end: %.1f ns\n", begin_end);
+
+		// submit.
+		{
+			const u32 kListCount = 1000;
+			std::vector<ObjPtr<ICommandList>> lists(kListCount);
+			std::vector<ICommandList*> p_lists(kListCount);
+			for (u32 i = 0; i < kListCount; i++)
+			{
+				device->CreateCommandList(cmd_desc, lists[i]);
+				lists[i]->Begin();
+				lists[i]->End();
+				p_lists[i] = lists[i];
+			}
+			double single = MeasureNs(kListCount, [&](u32 i) { g_sink += device->Submit(p_lists[i]); });
+			double batch = MeasureNs(1, [&](u32) { g_sink += device->Submit(CommandQueueType::Graphics, p_lists.data(), kListCount).fenceValue; });
+			printf("submit %u lists: %.1f ns/list one by one, %.1f ns/list batched\n", kListCount, single, batch / kListCount);
+		}
+
+		// naming.
+		std::vector<std::string> names;
+		for (u32 i = 0; i < 1024; i++)
+		{
+			names.push_back("Transient_" + std::to_string(i));
+		}
+		double set_name = MeasureNs(kIterations, [&](u32 i) { cmd->SetObjectName(names[i % names.size()].c_str()); });
+		printf("set object name: %.1f ns\n", set_name);
+
+		// weak pointer and stats.
+		ObjWeakPtr<ICommandList> weak(cmd);
+		double weak_lock = MeasureNs(kIterations, [&](u32 i) { g_sink += weak.Lock()->GetObjectId(); });
+		double stats = MeasureNs(kIterations, [&](u32 i) { g_sink += device->GetStats().pendingDeathCount; });
+		printf("weak pointer lock: %.1f ns, get stats: %.1f ns\n", weak_lock, stats);
+
+		// frame.
+		SwapchainDesc sc_desc;
+		sc_desc.SetWidth(1280).SetHeight(720).SetFormat(ResourceFormat::R8G8B8A8_Unorm).SetBackBufferCount(2);
+		ObjPtr<ISwapchain> swapchain;
+		device->CreateSwapchain(sc_desc, swapchain);
+		double present = MeasureNs(kIterations, [&](u32 i)
+		{
+			swapchain->Present(1);
+			device->ProcDeathList();
+		});
+		printf("present + death list: %.1f ns\n", present);
+	}
+
+}	// namespace bench
+
+
+//	EOF
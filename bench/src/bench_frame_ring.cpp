@@ -0,0 +1,90 @@
+﻿#include "bench.h"
+#include "mll/mll_frame_ring.h"
+
+#include <atomic>
+#include <thread>
+
+
+namespace bench
+{
+	//-----------------------------------------------------------
+	// measure offscreen present into shared memory frame ring.
+	//-----------------------------------------------------------
+	void RunFrameRingBench()
+	{
+		using namespace mll;
+
+		DeviceDesc device_desc;
+		auto device = IDevice::CreateGraphicsDevice(device_desc);
+		if (!device.IsValid())
+		{
+			printf("failed to create device.\n");
+			return;
+		}
+
+		printf("--- frame ring ---\n");
+
+		const u32 kFrames = 2000;
+		const char* kPolicyNames[] = { "drop oldest", "backpressure" };
+		for (u32 policy = 0; policy < FrameRingPolicy::MAX; policy++)
+		{
+			SwapchainDesc sc_desc;
+			sc_desc.SetWidth(1280).SetHeight(720).SetFormat(ResourceFormat::R8G8B8A8_Unorm).SetBackBufferCount(3)
+				.SetFrameRingName("mll_bench_frame_ring")
+				.SetFrameRingPolicy(static_cast<FrameRingPolicy::Type>(policy));
+			ObjPtr<ISwapchain> swapchain;
+			if (IsFailed(device->CreateSwapchain(sc_desc, swapchain)))
+			{
+				printf("failed to create frame ring swapchain.\n");
+				return;
+			}
+
+			// consumer reads one byte per row as encoder would touch frame.
+			std::atomic<bool> is_done{ false };
+			u64 consumed = 0;
+			std::thread consumer([&]
+			{
+				FrameRingReader reader;
+				if (IsFailed(reader.Open("mll_bench_frame_ring")))
+				{
+					return;
+				}
+				while (true)
+				{
+					FrameRingFrame frame;
+					if (reader.AcquireFrame(frame))
+					{
+						u64 sum = 0;
+						for (u32 y = 0; y < frame.height; y++)
+						{
+							sum += frame.pData[y * frame.rowPitch];
+						}
+						g_sink += sum;
+						reader.ReleaseFrame(frame);
+						consumed++;
+					}
+					else if (is_done.load())
+					{
+						break;
+					}
+					else
+					{
+						std::this_thread::yield();
+					}
+				}
+			});
+
+			double present = MeasureNs(kFrames, [&](u32 i) { swapchain->Present(0); });
+			is_done.store(true);
+			consumer.join();
+
+			printf("present (%s): %.1f ns, consumed %llu / %u frames\n", kPolicyNames[policy], present, static_cast<unsigned long long>(consumed), kFrames);
+			swapchain.Reset();
+			device->ProcDeathList();
+		}
+	}
+
+}	// namespace bench
+
+
+//	EOF
@@ -0,0 +1,71 @@
+﻿#include "bench.h"
+
+#include <vector>
+#include <algorithm>
+
+
+namespace bench
+{
+	namespace
+	{
+		//! same layout as D3D12_CPU_DESCRIPTOR_HANDLE array used by descriptor stacks.
+		struct DescriptorTable
+		{
+			mll::u64	handles[16];
+		};	// struct DescriptorTable
+	}
+
+	//-----------------------------------------------------------
+	// compare hash functions.
+	//-----------------------------------------------------------
+	void RunHashBench()
+	{
+		using namespace mll;
+
+		static const size_t kSizes[] = { 8, 32, 128, 1024, 64 * 1024 };
+
+		std::vector<u8> data(64 * 1024);
+		for (size_t i = 0; i < data.size(); i++)
+		{
+			data[i] = static_cast<u8>(i * 31 + 7);
+		}
+
+		printf("--- hash ---\n");
+		printf("%10s %14s %14s %14s\n", "bytes", "fnv1a32(GB/s)", "fnv1a64(GB/s)", "hash64(GB/s)");
+		for (auto size : kSizes)
+		{
+			u32 iterations = static_cast<u32>(std::max<size_t>(256 * 1024 * 1024 / size / 16, 16));
+
+			double fnv32 = MeasureNs(iterations, [&](u32 i) { g_sink += CalcFnv1a32(data.data(), size, i); });
+			double fnv64 = MeasureNs(iterations, [&](u32 i) { g_sink += CalcFnv1a64(data.data(), size, i); });
+			double h64 = MeasureNs(iterations, [&](u32 i) { g_sink += CalcHash64(data.data(), size, i); });
+
+			printf("%10zu %14.2f %14.2f %14.2f\n", size, size / fnv32, size / fnv64, size / h64);
+		}
+
+		// streaming hash of descriptor tables, like sampler cache keys.
+		DescriptorTable table{};
+		for (u32 i = 0; i < 16; i++)
+		{
+			table.handles[i] = 0x10000 + i * 32;
+		}
+		const u32 kIterations = 1000000;
+		double one_shot = MeasureNs(kIterations, [&](u32 i) { table.handles[0] = i; g_sink += CalcValueHash64(table); });
+		double streaming = MeasureNs(kIterations, [&](u32 i)
+		{
+			table.handles[0] = i;
+			Hasher64 hasher;
+			for (auto&& h : table.handles)
+			{
+				hasher.UpdateValue(h);
+			}
+			g_sink += hasher.Finalize();
+		});
+		double fnv = MeasureNs(kIterations, [&](u32 i) { table.handles[0] = i; g_sink += CalcFnv1a32(&table, sizeof(table)); });
+		printf("descriptor table(128 bytes): fnv1a32 %.1f ns, hash64 %.1f ns, hash64 streaming %.1f ns\n", fnv, one_shot, streaming);
+	}
+
+}	// namespace bench
+
+
+//	EOF
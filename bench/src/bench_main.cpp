@@ -0,0 +1,23 @@
+﻿#include "bench.h"
+
+
+namespace bench
+{
+	volatile mll::u64 g_sink = 0;
+}
+
+int main()
+{
+	bench::RunHashBench();
+	bench::RunDeviceBench();
+	bench::RunRecordBench();
+	bench::RunCaptureBench();
+	bench::RunSortBench();
+	bench::RunRenderThreadBench();
+	bench::RunCpuExecuteBench();
+	bench::RunFrameRingBench();
+
+	return 0;
+}
+
+//	EOF
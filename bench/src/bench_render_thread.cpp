@@ -0,0 +1,121 @@
+﻿#include "bench.h"
+#include "mll/mll_render_thread.h"
+
+
+namespace bench
+{
+	namespace
+	{
+		//-----------------------------------------------------------
+		// stand in for game simulation.
+		//-----------------------------------------------------------
+		mll::u64 Simulate(mll::u32 steps)
+		{
+			mll::u64 v = 0x9e3779b97f4a7c15ull;
+			for (mll::u32 i = 0; i < steps; i++)
+			{
+				v ^= v << 13;
+				v ^= v >> 7;
+				v ^= v << 17;
+			}
+			return v;
+		}
+	}
+
+	//-----------------------------------------------------------
+	// compare serial frame loop with render thread pipelining.
+	//-----------------------------------------------------------
+	void RunRenderThreadBench()
+	{
+		using namespace mll;
+
+		printf("--- render thread ---\n");
+
+		auto device = IDevice::CreateGraphicsDevice(DeviceDesc());
+		if (!device.IsValid())
+		{
+			printf("failed to create device.\n");
+			return;
+		}
+
+		SwapchainDesc sc_desc;
+		sc_desc.SetWidth(256).SetHeight(256).SetFormat(ResourceFormat::R8G8B8A8_Unorm).SetBackBufferCount(3);
+		ObjPtr<ISwapchain> swapchain;
+		if (IsFailed(device->CreateSwapchain(sc_desc, swapchain)))
+		{
+			printf("failed to create swapchain.\n");
+			return;
+		}
+
+		const u32 kFrames = 200;
+		const u32 kSimulateSteps = 200 * 1000;
+		const u32 kClearCount = 8;
+
+		// serial, simulation waits recording and present.
+		ObjPtr<ICommandList> cmd;
+		device->CreateCommandList(CommandListDesc(), cmd);
+		f64 serial_ns = MeasureNs(kFrames, [&](u32 frame)
+		{
+			g_sink = g_sink + Simulate(kSimulateSteps);
+			cmd->Begin();
+			auto back_buffer = swapchain->GetBackBuffer(swapchain->GetBackBufferIndex());
+			for (u32 i = 0; i < kClearCount; i++)
+			{
+				f32 color[4] = { static_cast<f32>(frame % 256) / 255.0f, 0.0f, 0.0f, 1.0f };
+				cmd->ClearTexture(back_buffer, 0, color);
+			}
+			cmd->End();
+			ICommandList* p_cmd = cmd;
+			device->WaitTicket(device->Submit(CommandQueueType::Graphics, &p_cmd, 1));
+			swapchain->Present(1);
+		});
+		printf("serial frame: %.1f us\n", serial_ns / 1e3);
+
+		// pipelined, render thread records frame N while simulation builds frame N + 1.
+		{
+			RenderThread render_thread;
+			if (IsFailed(render_thread.Initialize(device, swapchain, RenderThreadDesc())))
+			{
+				printf("failed to initialize render thread.\n");
+				return;
+			}
+
+			f64 pipelined_ns = MeasureNs(kFrames, [&](u32 frame)
+			{
+				render_thread.BeginFrame();
+				g_sink = g_sink + Simulate(kSimulateSteps);
+				auto p_color = render_thread.AllocateFrameData<f32>(4);
+				p_color[0] = static_cast<f32>(frame % 256) / 255.0f;
+				p_color[1] = p_color[2] = 0.0f;
+				p_color[3] = 1.0f;
+				render_thread.Enqueue([p_color](RenderContext& context)
+				{
+					for (u32 i = 0; i < kClearCount; i++)
+					{
+						context.pCmdList->ClearTexture(context.pBackBuffer, 0, p_color);
+					}
+				});
+				render_thread.EndFrame();
+			});
+			render_thread.Flush();
+			auto stats = render_thread.GetStats();
+			printf("pipelined frame: %.1f us (%u frames in flight, frame waits %llu, gpu waits %llu)\n",
+				pipelined_ns / 1e3, render_thread.GetFrameCount(),
+				static_cast<unsigned long long>(stats.frameWaitCount), static_cast<unsigned long long>(stats.gpuWaitCount));
+
+			// game thread cost of one command.
+			const u32 kEnqueueCount = 100 * 1000;
+			f64 enqueue_ns = MeasureNs(kEnqueueCount, [&](u32 i)
+			{
+				render_thread.Enqueue([i](RenderContext&) { g_sink = g_sink + i; });
+			});
+			render_thread.Flush();
+			printf("enqueue: %.1f ns (ring full waits %llu)\n", enqueue_ns,
+				static_cast<unsigned long long>(render_thread.GetStats().ringFullWaitCount));
+		}
+	}
+
+}	// namespace bench
+
+
+//	EOF
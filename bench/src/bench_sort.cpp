@@ -0,0 +1,133 @@
+﻿#include "bench.h"
+#include "mll/mll_command_sort.h"
+#include "mll/mll_thread_pool.h"
+
+#include <algorithm>
+#include <vector>
+
+
+namespace bench
+{
+	namespace
+	{
+		mll::u64 XorShift(mll::u64& state)
+		{
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			return state;
+		}
+	}
+
+	//-----------------------------------------------------------
+	// compare radix sort of sort keys with std::sort.
+	//-----------------------------------------------------------
+	void RunSortBench()
+	{
+		using namespace mll;
+
+		printf("--- sort keys ---\n");
+
+		ThreadPool pool;
+		pool.Initialize(0);
+
+		// keys of draw like distribution, few passes and heaps, many materials and depths.
+		auto make_items = [](u32 count, std::vector<SortItem>& outItems)
+		{
+			u64 state = 0x9e3779b97f4a7c15ull;
+			outItems.resize(count);
+			for (u32 i = 0; i < count; i++)
+			{
+				u64 r = XorShift(state);
+				u32 pass = static_cast<u32>(r % 4);
+				u32 pipeline = static_cast<u32>((r >> 8) % 256);
+				u32 heap = static_cast<u32>((r >> 16) % 2);
+				u32 material = static_cast<u32>((r >> 24) % 4096);
+				u32 depth = static_cast<u32>(r >> 40) & ((1u << SortKey::kDepthBits) - 1);
+				outItems[i].key = SortKey::Make(pass, pipeline, heap, material, depth);
+				outItems[i].payload = i;
+			}
+		};
+
+		const u32 kCounts[] = { 10 * 1000, 100 * 1000, 1000 * 1000 };
+		for (auto count : kCounts)
+		{
+			std::vector<SortItem> source, items;
+			make_items(count, source);
+			u32 iterations = std::max<u32>(1, 2000000 / count);
+
+			RadixSorter sorter;
+			items = source;
+			sorter.Sort(items.data(), count);		// warm up work buffers.
+
+			f64 radix_ns = MeasureNs(iterations, [&](u32)
+			{
+				items = source;
+				sorter.Sort(items.data(), count);
+			});
+			f64 parallel_ns = MeasureNs(iterations, [&](u32)
+			{
+				items = source;
+				sorter.Sort(items.data(), count, &pool);
+			});
+			bool sorted = std::is_sorted(items.begin(), items.end(), [](const SortItem& a, const SortItem& b) { return a.key < b.key; });
+			f64 std_ns = MeasureNs(iterations, [&](u32)
+			{
+				items = source;
+				std::stable_sort(items.begin(), items.end(), [](const SortItem& a, const SortItem& b) { return a.key < b.key; });
+			});
+			f64 copy_ns = MeasureNs(iterations, [&](u32) { items = source; });
+			g_sink = g_sink + items[count / 2].payload;
+
+			printf("%7u keys: radix %.2f ms, radix %u threads %.2f ms, std::stable_sort %.2f ms%s\n",
+				count, (radix_ns - copy_ns) / 1e6, pool.GetThreadCount() + 1, (parallel_ns - copy_ns) / 1e6, (std_ns - copy_ns) / 1e6,
+				sorted ? "" : " (NOT SORTED)");
+		}
+
+		// emit, sort and record packets.
+		{
+			auto device = IDevice::CreateGraphicsDevice(DeviceDesc());
+			if (!device.IsValid())
+			{
+				printf("failed to create device.\n");
+				return;
+			}
+
+			TextureDesc desc;
+			desc.SetDimension(ResourceDimension::Texture2D)
+				.SetWidth(16).SetHeight(16)
+				.SetFormat(ResourceFormat::R8G8B8A8_Unorm)
+				.SetUsageFlags(ResourceUsageFlag::RenderTarget);
+			ObjPtr<ITexture> tex;
+			device->CreateTexture(desc, tex);
+			ObjPtr<ICommandList> cmd;
+			device->CreateCommandList(CommandListDesc(), cmd);
+
+			const u32 kPacketCount = 100 * 1000;
+			std::vector<SortItem> keys;
+			make_items(kPacketCount, keys);
+
+			SortedCommandQueue queue;
+			f64 ns = MeasureNs(10, [&](u32)
+			{
+				queue.Reset();
+				for (auto&& key : keys)
+				{
+					auto p = queue.Push<ClearTexturePacket>(key.key);
+					p->pTexture = tex;
+					p->subresource = 0;
+					p->color[0] = p->color[1] = p->color[2] = p->color[3] = 0.0f;
+				}
+				queue.Sort(&pool);
+				cmd->Begin();
+				queue.Record(cmd);
+				cmd->End();
+			});
+			printf("%u packets emit + sort + record: %.2f ms\n", kPacketCount, ns / 1e6);
+		}
+	}
+
+}	// namespace bench
+
+
+//	EOF
@@ -0,0 +1,224 @@
+﻿#pragma once
+
+#include "mll_defines.h"
+
+#include <cstddef>
+#include <cassert>
+#include <mutex>
+#include <vector>
+
+
+namespace mll
+{
+	//-----------------------------------------------------------
+	//! @brief Allocation category.
+	//-----------------------------------------------------------
+	MLL_ENUM_START(AllocCategory)
+		General,
+		Device,
+		Object,
+		CommandList,
+		Texture,
+		Swapchain,
+		Descriptor,
+		Transient,
+	MLL_ENUM_END_WITH_MAX;
+
+	static const size_t		kDefaultAllocAlignment = 16;
+
+	//-----------------------------------------------------------
+	//! @brief User allocator callbacks.
+	//-----------------------------------------------------------
+	struct AllocatorCallbacks
+	{
+		void* (*pfnAllocate)(void* pUserData, size_t size, size_t alignment, AllocCategory::Type category) = nullptr;
+		void (*pfnFree)(void* pUserData, void* ptr, size_t size, AllocCategory::Type category) = nullptr;
+		void* pUserData = nullptr;
+	};	// struct AllocatorCallbacks
+
+	//-----------------------------------------------------------
+	//! @brief Allocation statistics of a category.
+	//-----------------------------------------------------------
+	struct AllocatorStats
+	{
+		u64		reservedBytes = 0;			// bytes allocated from backing allocator.
+		u64		usedBytes = 0;				// bytes handed out to users.
+		u64		peakUsedBytes = 0;
+		u64		allocationCount = 0;		// live allocation count.
+		u64		totalAllocationCount = 0;
+	};	// struct AllocatorStats
+
+	/**
+	 * @brief set user allocator callbacks.
+	 *
+	 * @param[in]	callbacks		allocator callbacks. (nullptr functions use default allocator)
+	 * @note Call this before any allocation.
+	*/
+	void SetAllocatorCallbacks(const AllocatorCallbacks& callbacks);
+
+	/**
+	 * @brief allocate memory.
+	*/
+	void* MemoryAllocate(size_t size, size_t alignment, AllocCategory::Type category);
+
+	/**
+	 * @brief free memory allocated by MemoryAllocate.
+	*/
+	void MemoryFree(void* ptr, size_t size, AllocCategory::Type category);
+
+	/**
+	 * @brief get allocation statistics.
+	*/
+	void GetAllocatorStats(AllocCategory::Type category, AllocatorStats& outStats);
+
+	//-----------------------------------------------------------
+	//! @brief Thread safe fixed size block pool.
+	//-----------------------------------------------------------
+	class FixedSizePool
+	{
+	public:
+		FixedSizePool(size_t blockSize, size_t alignment, AllocCategory::Type category, u32 blocksPerPage = 64);
+		~FixedSizePool();
+
+		FixedSizePool(const FixedSizePool&) = delete;
+		FixedSizePool& operator=(const FixedSizePool&) = delete;
+
+		/**
+		 * @brief allocate one block.
+		*/
+		void* Allocate();
+
+		/**
+		 * @brief free one block.
+		*/
+		void Free(void* ptr);
+
+		// getter
+		u32 GetUsedCount() const
+		{
+			return usedCount_;
+		}
+
+	private:
+		struct FreeBlock
+		{
+			FreeBlock*	pNext;
+		};	// struct FreeBlock
+
+		std::mutex			mutex_;
+		FreeBlock*			pFreeList_ = nullptr;
+		std::vector<void*>	pages_;
+		size_t				blockSize_ = 0;
+		size_t				alignment_ = 0;
+		u32					blocksPerPage_ = 0;
+		u32					usedCount_ = 0;
+		AllocCategory::Type	category_ = AllocCategory::General;
+	};	// class FixedSizePool
+
+	//-----------------------------------------------------------
+	//! @brief Linear arena for transient allocations.
+	//!
+	//! Allocations are released at once by Reset, pages are kept for reuse.
+	//! This class is not thread safe, use one arena per thread or per frame.
+	//-----------------------------------------------------------
+	class LinearArena
+	{
+	public:
+		explicit LinearArena(size_t pageSize = 64 * 1024, AllocCategory::Type category = AllocCategory::Transient);
+		~LinearArena();
+
+		LinearArena(const LinearArena&) = delete;
+		LinearArena& operator=(const LinearArena&) = delete;
+
+		/**
+		 * @brief allocate memory from arena.
+		*/
+		void* Allocate(size_t size, size_t alignment = kDefaultAllocAlignment);
+
+		/**
+		 * @brief allocate array from arena.
+		*/
+		template <typename T>
+		T* AllocateArray(size_t count)
+		{
+			return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+		}
+
+		/**
+		 * @brief release all allocations, pages are kept.
+		*/
+		void Reset();
+
+		/**
+		 * @brief release all pages.
+		*/
+		void Release();
+
+		// getter
+		size_t GetUsedBytes() const
+		{
+			return usedBytes_;
+		}
+		size_t GetReservedBytes() const
+		{
+			return reservedBytes_;
+		}
+
+	private:
+		struct Page
+		{
+			u8*		pMemory;
+			size_t	size;
+		};	// struct Page
+
+		std::vector<Page>	pages_;
+		u32					currentPage_ = 0;
+		size_t				offset_ = 0;
+		size_t				pageSize_ = 0;
+		size_t				usedBytes_ = 0;
+		size_t				reservedBytes_ = 0;
+		AllocCategory::Type	category_ = AllocCategory::Transient;
+	};	// class LinearArena
+
+}	// namespace mll
+
+//! @brief declare class allocator routed to user allocator callbacks.
+#define MLL_DECLARE_CLASS_ALLOCATOR(category)											\
+	public:																				\
+		static void* operator new(size_t size) noexcept									\
+		{																				\
+			return ::mll::MemoryAllocate(size, ::mll::kDefaultAllocAlignment, category);	\
+		}																				\
+		static void operator delete(void* p, size_t size)								\
+		{																				\
+			::mll::MemoryFree(p, size, category);										\
+		}																				\
+	private:
+
+//! @brief declare class allocator using fixed size pool of the class.
+//! @note MLL_IMPLEMENT_POOL_ALLOCATOR is needed in source file.
+#define MLL_DECLARE_POOL_ALLOCATOR()													\
+	public:																				\
+		static void* operator new(size_t size) noexcept;								\
+		static void operator delete(void* p);											\
+	private:
+
+//! @brief implement class allocator using fixed size pool of the class.
+#define MLL_IMPLEMENT_POOL_ALLOCATOR(T, category)										\
+	static ::mll::FixedSizePool& Get##T##Pool()											\
+	{																					\
+		static ::mll::FixedSizePool s_pool(sizeof(T), alignof(T), category);			\
+		return s_pool;																	\
+	}																					\
+	void* T::operator new(size_t size) noexcept											\
+	{																					\
+		assert(size == sizeof(T));														\
+		return Get##T##Pool().Allocate();												\
+	}																					\
+	void T::operator delete(void* p)													\
+	{																					\
+		Get##T##Pool().Free(p);															\
+	}
+
+
+//	EOF
@@ -0,0 +1,253 @@
+﻿#pragma once
+
+#include "mll_defines.h"
+#include "mll_interfaces.h"
+
+#include <cstdio>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+
+namespace mll
+{
+	//-----------------------------------------------------------
+	//! @brief Capture record types.
+	//-----------------------------------------------------------
+	MLL_ENUM_START(CaptureRecordType)
+		CreateTexture,
+		Submit,
+	MLL_ENUM_END_WITH_MAX;
+
+	//-----------------------------------------------------------
+	//! @brief Capture file header.
+	//!
+	//! Records follow the header in submission order, each record is 8 bytes aligned.
+	//-----------------------------------------------------------
+	struct CaptureFileHeader
+	{
+		u32		magic;
+		u32		version;
+		u32		pointerSize;		//!< packets keep pointer sized fields.
+		u32		textureCount;
+		u32		submitCount;
+		u32		listCount;
+		u64		packetCount;
+		u64		recordBytes;		//!< bytes of all records after header.
+	};	// struct CaptureFileHeader
+
+	//-----------------------------------------------------------
+	//! @brief Capture record header.
+	//-----------------------------------------------------------
+	struct CaptureRecordHeader
+	{
+		CaptureRecordType::Type		type;
+		u32							size;		//!< record bytes including header.
+	};	// struct CaptureRecordHeader
+
+	//-----------------------------------------------------------
+	//! @brief texture creation record.
+	//-----------------------------------------------------------
+	struct CaptureCreateTextureRecord
+	{
+		CaptureRecordHeader		header;
+		u32						textureIndex;
+		u32						reserved;
+		TextureDesc				desc;
+	};	// struct CaptureCreateTextureRecord
+
+	//-----------------------------------------------------------
+	//! @brief submission record.
+	//!
+	//! CaptureListRecord and its packets follow for each command list.
+	//! Texture pointers in packets are replaced with texture indices, pNext is null.
+	//! Executed bundles are flattened into the command list.
+	//-----------------------------------------------------------
+	struct CaptureSubmitRecord
+	{
+		CaptureRecordHeader		header;
+		CommandQueueType::Type	queueType;
+		u32						listCount;
+	};	// struct CaptureSubmitRecord
+
+	struct CaptureListRecord
+	{
+		u32		packetCount;
+		u32		packetBytes;		//!< bytes of packets following this record.
+	};	// struct CaptureListRecord
+
+	//-----------------------------------------------------------
+	//! @brief read only file mapping.
+	//-----------------------------------------------------------
+	class MappedFile
+	{
+	public:
+		MappedFile()
+		{}
+		~MappedFile()
+		{
+			Close();
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		/**
+		 * @brief map whole file.
+		*/
+		Result::Type Open(const char* path);
+
+		/**
+		 * @brief unmap file.
+		*/
+		void Close();
+
+		const u8* GetMemory() const
+		{
+			return pMemory_;
+		}
+		size_t GetSize() const
+		{
+			return size_;
+		}
+
+	private:
+		const u8*	pMemory_ = nullptr;
+		size_t		size_ = 0;
+		void*		handle_ = nullptr;		// file mapping handle on Windows.
+	};	// class MappedFile
+
+	//-----------------------------------------------------------
+	//! @brief writes texture creations and submitted command streams to file.
+	//!
+	//! Usually owned by IDevice between BeginCapture and EndCapture.
+	//! Textures created before capture are written on first reference.
+	//-----------------------------------------------------------
+	class CommandCaptureWriter
+	{
+		MLL_DECLARE_CLASS_ALLOCATOR(AllocCategory::General);
+
+	public:
+		CommandCaptureWriter()
+		{}
+		~CommandCaptureWriter()
+		{
+			Close();
+		}
+
+		CommandCaptureWriter(const CommandCaptureWriter&) = delete;
+		CommandCaptureWriter& operator=(const CommandCaptureWriter&) = delete;
+
+		/**
+		 * @brief create capture file.
+		*/
+		Result::Type Open(const char* path);
+
+		/**
+		 * @brief write file header and close file.
+		*/
+		void Close();
+
+		/**
+		 * @brief write texture creation record if not written yet.
+		*/
+		void WriteTexture(const ITexture* pTexture);
+
+		/**
+		 * @brief write recorded streams of submitted command lists.
+		*/
+		void WriteSubmit(CommandQueueType::Type type, ICommandList* const* ppCmdLists, u32 count);
+
+		bool IsOpened() const
+		{
+			return pFile_ != nullptr;
+		}
+		const CaptureFileHeader& GetHeader() const
+		{
+			return header_;
+		}
+
+	private:
+		void AppendPackets(const CommandStream& stream, CaptureListRecord& list);
+		u32 WriteTextureUnlocked(const ITexture* pTexture);
+		void Write(const void* pData, size_t size);
+
+	private:
+		std::mutex						mutex_;
+		FILE*							pFile_ = nullptr;
+		CaptureFileHeader				header_ = {};
+		std::unordered_map<u64, u32>	textureIndices_;		// object id to texture index.
+		std::vector<u8>					packetBuffer_;			// remapped packets of one command list.
+	};	// class CommandCaptureWriter
+
+	//-----------------------------------------------------------
+	//! @brief replays capture file on any device.
+	//!
+	//! Records are read in place from mapped file.
+	//! Prepare creates textures and command lists, Replay only records and submits them,
+	//! so replay cost is the recording and submission cost of the backend.
+	//-----------------------------------------------------------
+	class CommandCaptureReplay
+	{
+	public:
+		CommandCaptureReplay()
+		{}
+		~CommandCaptureReplay()
+		{
+			Close();
+		}
+
+		CommandCaptureReplay(const CommandCaptureReplay&) = delete;
+		CommandCaptureReplay& operator=(const CommandCaptureReplay&) = delete;
+
+		/**
+		 * @brief map and validate capture file.
+		*/
+		Result::Type Open(const char* path);
+
+		/**
+		 * @brief release replay objects and unmap file.
+		*/
+		void Close();
+
+		/**
+		 * @brief create captured textures and command lists on device.
+		*/
+		Result::Type Prepare(IDevice* pDevice);
+
+		/**
+		 * @brief record and submit all captured command lists.
+		 *
+		 * @return					ticket of last submission.
+		 * @note Prepare must be called before. Replay can be repeated.
+		*/
+		SubmitTicket Replay();
+
+		/**
+		 * @brief release objects created by Prepare.
+		*/
+		void ReleaseObjects();
+
+		const CaptureFileHeader& GetHeader() const
+		{
+			return *reinterpret_cast<const CaptureFileHeader*>(file_.GetMemory());
+		}
+
+	private:
+		template <typename TFunc>
+		void ForEachRecord(TFunc func) const;
+
+		void RecordPackets(ICommandList* pCmdList, const u8* pPackets, u32 packetCount);
+
+	private:
+		MappedFile							file_;
+		IDevice*							pDevice_ = nullptr;
+		std::vector<ObjPtr<ITexture>>		textures_;								// indexed by texture index.
+		std::vector<ObjPtr<ICommandList>>	cmdLists_[CommandQueueType::MAX];		// reused for every submission.
+		std::vector<ICommandList*>			submitLists_[CommandQueueType::MAX];	// raw pointers of cmdLists_ for Submit.
+	};	// class CommandCaptureReplay
+
+}	// namespace mll
+
+
+//	EOF
@@ -0,0 +1,200 @@
+﻿#pragma once
+
+#include "mll_defines.h"
+#include "mll_allocator.h"
+#include "mll_command_stream.h"
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+
+namespace mll
+{
+	class ICommandList;
+	class ThreadPool;
+
+	//-----------------------------------------------------------
+	//! @brief 64bit command sort key.
+	//!
+	//! Fields from most significant bit:
+	//! pass(6) | pipeline(14) | descriptor heap(4) | material(16) | depth(24)
+	//! so sorted packets are grouped by pass, then state changes are minimized.
+	//-----------------------------------------------------------
+	struct SortKey
+	{
+		static const u32	kPassBits = 6;
+		static const u32	kPipelineBits = 14;
+		static const u32	kDescriptorHeapBits = 4;
+		static const u32	kMaterialBits = 16;
+		static const u32	kDepthBits = 24;
+
+		static const u32	kDepthShift = 0;
+		static const u32	kMaterialShift = kDepthShift + kDepthBits;
+		static const u32	kDescriptorHeapShift = kMaterialShift + kMaterialBits;
+		static const u32	kPipelineShift = kDescriptorHeapShift + kDescriptorHeapBits;
+		static const u32	kPassShift = kPipelineShift + kPipelineBits;
+
+		static_assert(kPassShift + kPassBits == 64, "sort key fields must fill 64 bits.");
+
+		/**
+		 * @brief make sort key.
+		 *
+		 * @note Each value must fit in its field.
+		*/
+		static u64 Make(u32 pass, u32 pipeline, u32 descriptorHeap, u32 material, u32 depth)
+		{
+			assert(pass < (1u << kPassBits));
+			assert(pipeline < (1u << kPipelineBits));
+			assert(descriptorHeap < (1u << kDescriptorHeapBits));
+			assert(material < (1u << kMaterialBits));
+			assert(depth < (1u << kDepthBits));
+			return (static_cast<u64>(pass) << kPassShift)
+				| (static_cast<u64>(pipeline) << kPipelineShift)
+				| (static_cast<u64>(descriptorHeap) << kDescriptorHeapShift)
+				| (static_cast<u64>(material) << kMaterialShift)
+				| (static_cast<u64>(depth) << kDepthShift);
+		}
+
+		/**
+		 * @brief quantize [0, 1] depth to depth field.
+		 *
+		 * @param[in]	depth		view depth. pass 1 - depth for back to front order.
+		*/
+		static u32 QuantizeDepth(f32 depth)
+		{
+			depth = (depth < 0.0f) ? 0.0f : ((depth > 1.0f) ? 1.0f : depth);
+			return static_cast<u32>(depth * static_cast<f32>((1u << kDepthBits) - 1));
+		}
+
+		static u32 GetPass(u64 key)
+		{
+			return static_cast<u32>(key >> kPassShift) & ((1u << kPassBits) - 1);
+		}
+		static u32 GetDescriptorHeap(u64 key)
+		{
+			return static_cast<u32>(key >> kDescriptorHeapShift) & ((1u << kDescriptorHeapBits) - 1);
+		}
+	};	// struct SortKey
+
+	//-----------------------------------------------------------
+	//! @brief sort key and payload.
+	//-----------------------------------------------------------
+	struct SortItem
+	{
+		u64		key;
+		u64		payload;
+	};	// struct SortItem
+
+	//-----------------------------------------------------------
+	//! @brief stable LSD radix sort of sort items.
+	//!
+	//! 8 bit digits, digits equal in all keys are skipped.
+	//! Items are split in chunks, each chunk is counted and scattered on one thread of pool.
+	//! Work buffers are kept between sorts.
+	//-----------------------------------------------------------
+	class RadixSorter
+	{
+	public:
+		RadixSorter()
+		{}
+
+		RadixSorter(const RadixSorter&) = delete;
+		RadixSorter& operator=(const RadixSorter&) = delete;
+
+		/**
+		 * @brief sort items by key.
+		 *
+		 * @param[in]	pThreadPool		pool for parallel sort. nullptr sorts on caller thread.
+		*/
+		void Sort(SortItem* pItems, u32 count, ThreadPool* pThreadPool = nullptr);
+
+	private:
+		std::vector<SortItem>	scratch_;
+		std::vector<u32>		histograms_;		// 256 counters per chunk.
+		std::vector<u64>		keyBits_;			// or and and of keys per chunk.
+	};	// class RadixSorter
+
+	//-----------------------------------------------------------
+	//! @brief command packets emitted with sort keys, recorded in key order.
+	//!
+	//! Packets are built in own arena, Sort orders them, Record copies them to command list.
+	//! Packets with equal keys keep emission order.
+	//! This class is not thread safe, use one queue per thread and merge by recording in order.
+	//-----------------------------------------------------------
+	class SortedCommandQueue
+	{
+	public:
+		explicit SortedCommandQueue(size_t pageSize = 64 * 1024)
+			: arena_(pageSize, AllocCategory::CommandList)
+		{}
+
+		SortedCommandQueue(const SortedCommandQueue&) = delete;
+		SortedCommandQueue& operator=(const SortedCommandQueue&) = delete;
+
+		/**
+		 * @brief append new packet with sort key.
+		 *
+		 * @return			packet with initialized header. other members are uninitialized.
+		*/
+		template <typename TPacket>
+		TPacket* Push(u64 key)
+		{
+			static_assert(std::is_trivially_copyable<TPacket>::value && std::is_standard_layout<TPacket>::value, "command packet must be POD.");
+			static_assert(offsetof(TPacket, header) == 0, "command packet must begin with header.");
+
+			auto p = static_cast<TPacket*>(arena_.Allocate(sizeof(TPacket), alignof(TPacket)));
+			assert(p != nullptr);
+			p->header.type = TPacket::kType;
+			p->header.size = static_cast<u32>(sizeof(TPacket));
+			p->header.pNext = nullptr;
+			items_.push_back(SortItem{ key, reinterpret_cast<uintptr_t>(p) });
+			return p;
+		}
+
+		/**
+		 * @brief discard all packets, memory is kept.
+		*/
+		void Reset()
+		{
+			arena_.Reset();
+			items_.clear();
+		}
+
+		/**
+		 * @brief sort packets by key.
+		*/
+		void Sort(ThreadPool* pThreadPool = nullptr)
+		{
+			sorter_.Sort(items_.data(), static_cast<u32>(items_.size()), pThreadPool);
+		}
+
+		/**
+		 * @brief record packets to command list in current order.
+		*/
+		void Record(ICommandList* pCmdList) const;
+
+		// getter
+		u32 GetCount() const
+		{
+			return static_cast<u32>(items_.size());
+		}
+		const SortItem* GetItems() const
+		{
+			return items_.data();
+		}
+		static const CommandPacketHeader& GetPacket(const SortItem& item)
+		{
+			return *reinterpret_cast<const CommandPacketHeader*>(static_cast<uintptr_t>(item.payload));
+		}
+
+	private:
+		LinearArena				arena_;
+		std::vector<SortItem>	items_;
+		RadixSorter				sorter_;
+	};	// class SortedCommandQueue
+
+}	// namespace mll
+
+
+//	EOF
@@ -0,0 +1,261 @@
+﻿#pragma once
+
+#include "mll_defines.h"
+#include "mll_allocator.h"
+
+#include <cstring>
+#include <type_traits>
+
+
+namespace mll
+{
+	class ITexture;
+	class ICommandList;
+
+	//-----------------------------------------------------------
+	//! @brief Command packet types.
+	//-----------------------------------------------------------
+	MLL_ENUM_START(CommandPacketType)
+		ClearTexture,
+		CopyTexture,
+		ResolveTexture,
+		ExecuteBundle,
+	MLL_ENUM_END_WITH_MAX;
+
+	//-----------------------------------------------------------
+	//! @brief Fixed size header of all command packets.
+	//-----------------------------------------------------------
+	struct CommandPacketHeader
+	{
+		CommandPacketType::Type		type;
+		u32							size;			//!< packet bytes including header.
+		const CommandPacketHeader*	pNext;			//!< next packet in recorded order.
+	};	// struct CommandPacketHeader
+
+	//-----------------------------------------------------------
+	//! @brief clear texture subresource.
+	//-----------------------------------------------------------
+	struct ClearTexturePacket
+	{
+		static const CommandPacketType::Type kType = CommandPacketType::ClearTexture;
+
+		CommandPacketHeader		header;
+		ITexture*				pTexture;
+		u32						subresource;
+		f32						color[4];
+	};	// struct ClearTexturePacket
+
+	//-----------------------------------------------------------
+	//! @brief copy texture subresource.
+	//-----------------------------------------------------------
+	struct CopyTexturePacket
+	{
+		static const CommandPacketType::Type kType = CommandPacketType::CopyTexture;
+
+		CommandPacketHeader		header;
+		ITexture*				pDst;
+		ITexture*				pSrc;
+		u32						dstSubresource;
+		u32						srcSubresource;
+	};	// struct CopyTexturePacket
+
+	//-----------------------------------------------------------
+	//! @brief resolve multisampled texture subresource.
+	//-----------------------------------------------------------
+	struct ResolveTexturePacket
+	{
+		static const CommandPacketType::Type kType = CommandPacketType::ResolveTexture;
+
+		CommandPacketHeader		header;
+		ITexture*				pDst;
+		ITexture*				pSrc;
+		u32						dstSubresource;
+		u32						srcSubresource;
+	};	// struct ResolveTexturePacket
+
+	//-----------------------------------------------------------
+	//! @brief execute bundle command list.
+	//-----------------------------------------------------------
+	struct ExecuteBundlePacket
+	{
+		static const CommandPacketType::Type kType = CommandPacketType::ExecuteBundle;
+
+		CommandPacketHeader		header;
+		ICommandList*			pBundle;
+	};	// struct ExecuteBundlePacket
+
+	//-----------------------------------------------------------
+	//! @brief call func(ITexture*&) for all textures referenced by packet.
+	//!
+	//! @note Update this function when new packet references resources.
+	//-----------------------------------------------------------
+	template <typename TFunc>
+	void ForEachPacketTexture(CommandPacketHeader& header, TFunc func)
+	{
+		switch (header.type)
+		{
+		case CommandPacketType::ClearTexture:
+			func(reinterpret_cast<ClearTexturePacket*>(&header)->pTexture);
+			break;
+		case CommandPacketType::CopyTexture:
+			func(reinterpret_cast<CopyTexturePacket*>(&header)->pDst);
+			func(reinterpret_cast<CopyTexturePacket*>(&header)->pSrc);
+			break;
+		case CommandPacketType::ResolveTexture:
+			func(reinterpret_cast<ResolveTexturePacket*>(&header)->pDst);
+			func(reinterpret_cast<ResolveTexturePacket*>(&header)->pSrc);
+			break;
+		case CommandPacketType::ExecuteBundle:
+			// textures are referenced by packets of bundle.
+			break;
+		default:
+			assert(!"unknown command packet.");
+			break;
+		}
+	}
+
+	//-----------------------------------------------------------
+	//! @brief Backend neutral command stream.
+	//!
+	//! Packets are POD and recorded into linear arena pages which are kept over Reset,
+	//! so steady state recording does not allocate.
+	//! Backends translate packets to native commands after recording.
+	//! This class is not thread safe, one stream is recorded by one thread at a time.
+	//-----------------------------------------------------------
+	class CommandStream
+	{
+	public:
+		explicit CommandStream(size_t pageSize = 16 * 1024)
+			: arena_(pageSize, AllocCategory::CommandList)
+		{}
+		~CommandStream()
+		{}
+
+		CommandStream(const CommandStream&) = delete;
+		CommandStream& operator=(const CommandStream&) = delete;
+
+		/**
+		 * @brief append new packet.
+		 *
+		 * @return			packet with initialized header. other members are uninitialized.
+		*/
+		template <typename TPacket>
+		TPacket* Push()
+		{
+			static_assert(std::is_trivially_copyable<TPacket>::value && std::is_standard_layout<TPacket>::value, "command packet must be POD.");
+			static_assert(offsetof(TPacket, header) == 0, "command packet must begin with header.");
+
+			auto p = static_cast<TPacket*>(arena_.Allocate(sizeof(TPacket), alignof(TPacket)));
+			assert(p != nullptr);
+			p->header.type = TPacket::kType;
+			p->header.size = static_cast<u32>(sizeof(TPacket));
+			p->header.pNext = nullptr;
+			Link(&p->header);
+			return p;
+		}
+
+		/**
+		 * @brief append copy of packet recorded elsewhere.
+		 *
+		 * @note Payload referenced by packet is not copied.
+		*/
+		CommandPacketHeader* PushCopy(const CommandPacketHeader& header)
+		{
+			auto p = static_cast<CommandPacketHeader*>(arena_.Allocate(header.size, alignof(CommandPacketHeader)));
+			assert(p != nullptr);
+			memcpy(p, &header, header.size);
+			p->pNext = nullptr;
+			Link(p);
+			return p;
+		}
+
+		/**
+		 * @brief allocate variable size payload referenced by packet.
+		 *
+		 * @note Payload is valid until next Reset.
+		*/
+		void* AllocatePayload(size_t size, size_t alignment = kDefaultAllocAlignment)
+		{
+			return arena_.Allocate(size, alignment);
+		}
+
+		/**
+		 * @brief discard all packets, arena pages are kept.
+		*/
+		void Reset()
+		{
+			arena_.Reset();
+			pFirst_ = pLast_ = nullptr;
+			packetCount_ = 0;
+		}
+
+		/**
+		 * @brief call func(const CommandPacketHeader&) for all packets in recorded order.
+		*/
+		template <typename TFunc>
+		void ForEach(TFunc func) const
+		{
+			for (const CommandPacketHeader* p = pFirst_; p != nullptr; p = p->pNext)
+			{
+				func(*p);
+			}
+		}
+
+		/**
+		 * @brief cast header to packet.
+		*/
+		template <typename TPacket>
+		static const TPacket& Cast(const CommandPacketHeader& header)
+		{
+			assert(header.type == TPacket::kType);
+			return *reinterpret_cast<const TPacket*>(&header);
+		}
+
+		// getter
+		const CommandPacketHeader* GetFirst() const
+		{
+			return pFirst_;
+		}
+		u32 GetPacketCount() const
+		{
+			return packetCount_;
+		}
+		bool IsEmpty() const
+		{
+			return packetCount_ == 0;
+		}
+		size_t GetUsedBytes() const
+		{
+			return arena_.GetUsedBytes();
+		}
+		size_t GetReservedBytes() const
+		{
+			return arena_.GetReservedBytes();
+		}
+
+	private:
+		void Link(CommandPacketHeader* p)
+		{
+			if (pLast_)
+			{
+				pLast_->pNext = p;
+			}
+			else
+			{
+				pFirst_ = p;
+			}
+			pLast_ = p;
+			packetCount_++;
+		}
+
+	private:
+		LinearArena				arena_;
+		CommandPacketHeader*	pFirst_ = nullptr;
+		CommandPacketHeader*	pLast_ = nullptr;
+		u32						packetCount_ = 0;
+	};	// class CommandStream
+
+}	// namespace mll
+
+
+//	EOF
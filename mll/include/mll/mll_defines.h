@@ -3,7 +3,7 @@
 #include <cstdint>
 
 
-#define MLL_ENUM_START(name)	struct name##{ enum Type {
+#define MLL_ENUM_START(name)	struct name { enum Type {
 #define MLL_ENUM_END			}; };
 #define MLL_ENUM_END_WITH_MAX	MAX }; }
 
@@ -39,6 +39,32 @@ namespace mll
 		Copy,
 	MLL_ENUM_END_WITH_MAX;
 
+	//-----------------------------------------------------------
+	//! @brief Command list types.
+	//-----------------------------------------------------------
+	MLL_ENUM_START(CommandListType)
+		Direct,			//!< submitted to command queue.
+		Bundle,			//!< recorded once and executed in direct command lists.
+	MLL_ENUM_END_WITH_MAX;
+
+	//-----------------------------------------------------------
+	//! @brief Native command list state filtered by shadow state.
+	//-----------------------------------------------------------
+	MLL_ENUM_START(CommandStateType)
+		DescriptorHeaps,	//!< shader visible descriptor heaps.
+		ClearView,			//!< render target or depth stencil view created for clear.
+		Barrier,			//!< texture layout transition.
+	MLL_ENUM_END_WITH_MAX;
+
+	//-----------------------------------------------------------
+	//! @brief Device child object types.
+	//-----------------------------------------------------------
+	MLL_ENUM_START(ObjectType)
+		CommandList,
+		Swapchain,
+		Texture,
+	MLL_ENUM_END_WITH_MAX;
+
 	//-----------------------------------------------------------
 	//! @brief Resource formats.
 	//-----------------------------------------------------------
@@ -164,6 +190,14 @@ namespace mll
 		ShadingRate,
 	MLL_ENUM_END_WITH_MAX;
 
+	//-----------------------------------------------------------
+	//! @brief frame ring policy when every slot is in use.
+	//-----------------------------------------------------------
+	MLL_ENUM_START(FrameRingPolicy)
+		DropOldest,			// overwrite oldest frame not yet taken by consumer.
+		Backpressure,		// producer waits until consumer releases a frame.
+	MLL_ENUM_END_WITH_MAX;
+
 
 	//-----------------------------------------------------------
 	//! @brief Graphics device description.
@@ -171,12 +205,48 @@ namespace mll
 	struct DeviceDesc
 	{
 		bool		enableDebugLayer = false;
+		bool		enableReclaimThread = false;
+		u32			deathListBudget = 0;
+		bool		enableNativeObjectName = false;
+		u32			workerThreadCount = 0;		//!< CPU execution threads for headless backend. 0 is hardware concurrency.
+		u32			descriptorRingSize = 0;		//!< shader visible CBV/SRV/UAV descriptors per command queue. 0 uses default.
+		u32			bindlessDescriptorCount = 0;	//!< stable texture view indices at start of shader visible heap. 0 disables bindless.
 
 		DeviceDesc& SetEnableDebugLayer(bool b)
 		{
 			enableDebugLayer = b;
 			return *this;
 		}
+		DeviceDesc& SetEnableReclaimThread(bool b)
+		{
+			enableReclaimThread = b;
+			return *this;
+		}
+		DeviceDesc& SetDeathListBudget(u32 v)
+		{
+			deathListBudget = v;
+			return *this;
+		}
+		DeviceDesc& SetEnableNativeObjectName(bool b)
+		{
+			enableNativeObjectName = b;
+			return *this;
+		}
+		DeviceDesc& SetWorkerThreadCount(u32 v)
+		{
+			workerThreadCount = v;
+			return *this;
+		}
+		DeviceDesc& SetDescriptorRingSize(u32 v)
+		{
+			descriptorRingSize = v;
+			return *this;
+		}
+		DeviceDesc& SetBindlessDescriptorCount(u32 v)
+		{
+			bindlessDescriptorCount = v;
+			return *this;
+		}
 	};	// struct DeviceDesc
 
 	//-----------------------------------------------------------
@@ -185,16 +255,25 @@ namespace mll
 	struct CommandListDesc
 	{
 		CommandQueueType::Type	typeCommandQueue = CommandQueueType::Graphics;
+		CommandListType::Type	typeCommandList = CommandListType::Direct;
 
 		CommandListDesc& SetCommandQueueType(CommandQueueType::Type t)
 		{
 			typeCommandQueue = t;
 			return *this;
 		}
+		CommandListDesc& SetCommandListType(CommandListType::Type t)
+		{
+			typeCommandList = t;
+			return *this;
+		}
 	};	// struct CommandListDesc
 
 	//-----------------------------------------------------------
 	//! @brief Swapchain description.
+	//!
+	//! Window swapchain is not supported on Vulkan backend, and frame ring is supported
+	//! on headless backend only. Unsupported settings return Result::InvalidOperation.
 	//-----------------------------------------------------------
 	struct SwapchainDesc
 	{
@@ -202,8 +281,10 @@ namespace mll
 		u32						height = 0;
 		ResourceFormat::Type	format = ResourceFormat::Unknown;
 		u32						backBufferCount = 0;
-		void*					windowHandle = nullptr;
+		void*					windowHandle = nullptr;		//!< nullptr for offscreen swapchain.
 		bool					isFullscreen = false;
+		const char*				frameRingName = nullptr;	//!< offscreen only, present into shared memory frame ring with this name.
+		FrameRingPolicy::Type	frameRingPolicy = FrameRingPolicy::DropOldest;
 
 		SwapchainDesc& SetWidth(u32 v)
 		{
@@ -235,6 +316,16 @@ namespace mll
 			isFullscreen = v;
 			return *this;
 		}
+		SwapchainDesc& SetFrameRingName(const char* v)
+		{
+			frameRingName = v;
+			return *this;
+		}
+		SwapchainDesc& SetFrameRingPolicy(FrameRingPolicy::Type v)
+		{
+			frameRingPolicy = v;
+			return *this;
+		}
 	};	// struct SwapchainDesc
 
 	//-----------------------------------------------------------
@@ -311,6 +402,97 @@ namespace mll
 		}
 	};	// struct TextureDesc
 
+	//-----------------------------------------------------------
+	//! @brief object counters per object type.
+	//-----------------------------------------------------------
+	struct ObjectTypeStats
+	{
+		u64		liveCount = 0;				//!< created and not killed yet.
+		u64		pendingCount = 0;			//!< killed and waiting in death list.
+		u64		peakLiveCount = 0;			//!< high-water mark of liveCount.
+		u64		totalCreatedCount = 0;
+		u64		totalDestroyedCount = 0;
+		u64		frameCreatedCount = 0;		//!< created since last frame reset.
+		u64		frameDestroyedCount = 0;	//!< destroyed since last frame reset.
+	};	// struct ObjectTypeStats
+
+	//-----------------------------------------------------------
+	//! @brief device telemetry snapshot.
+	//-----------------------------------------------------------
+	struct DeviceStats
+	{
+		u64					frameIndex = 0;								//!< number of frame resets.
+		ObjectTypeStats		objectTypes[ObjectType::MAX];
+		u64					pendingDeathCount = 0;						//!< total of objectTypes[].pendingCount.
+		u64					heapBytes[ResourceHeap::MAX] = {};			//!< estimated bytes of alive resources.
+		u64					peakHeapBytes[ResourceHeap::MAX] = {};		//!< high-water mark of heapBytes.
+	};	// struct DeviceStats
+
+	//-----------------------------------------------------------
+	//! @brief submission ticket.
+	//!
+	//! Fence value signaled on command queue after submitted command lists.
+	//-----------------------------------------------------------
+	struct SubmitTicket
+	{
+		CommandQueueType::Type	queueType = CommandQueueType::Graphics;
+		u64						fenceValue = 0;		//!< 0 is invalid ticket.
+
+		bool IsValid() const
+		{
+			return fenceValue != 0;
+		}
+	};	// struct SubmitTicket
+
+	//-----------------------------------------------------------
+	//! @brief command allocator pool statistics of a command queue type.
+	//-----------------------------------------------------------
+	struct CommandAllocatorStats
+	{
+		u32		allocatorCount = 0;			//!< native allocators created. this is high-water mark, pool never shrinks.
+		u32		heldCount = 0;				//!< allocators held by command lists.
+		u64		peakRecordBytes = 0;		//!< largest command stream recorded into one allocator.
+		u64		acquireCount = 0;
+		u64		recycleCount = 0;			//!< acquisitions served by completed allocator.
+	};	// struct CommandAllocatorStats
+
+	//-----------------------------------------------------------
+	//! @brief shader visible descriptor ring statistics of a command queue type.
+	//-----------------------------------------------------------
+	struct DescriptorRingStats
+	{
+		u32		capacity = 0;				//!< descriptors in ring.
+		u32		usedCount = 0;				//!< descriptors not retired yet.
+		u32		peakUsedCount = 0;			//!< high-water mark of usedCount.
+		u64		allocatedCount = 0;			//!< descriptors allocated in total.
+		u64		blockCount = 0;				//!< blocks handed to command lists.
+		u64		waitCount = 0;				//!< CPU waits for GPU because ring was full.
+	};	// struct DescriptorRingStats
+
+	//-----------------------------------------------------------
+	//! @brief shader visible sampler cache statistics.
+	//-----------------------------------------------------------
+	struct SamplerCacheStats
+	{
+		u32		capacity = 0;				//!< samplers in heap.
+		u32		usedCount = 0;				//!< samplers of cached tables.
+		u32		peakUsedCount = 0;			//!< high-water mark of usedCount.
+		u32		entryCount = 0;				//!< cached tables.
+		u64		hitCount = 0;
+		u64		missCount = 0;
+		u64		evictCount = 0;
+		u64		waitCount = 0;				//!< CPU waits for GPU before eviction.
+	};	// struct SamplerCacheStats
+
+	//-----------------------------------------------------------
+	//! @brief native state calls of command list translation.
+	//-----------------------------------------------------------
+	struct CommandStateStats
+	{
+		u64		issuedCount[CommandStateType::MAX] = {};		//!< calls reached native command list.
+		u64		eliminatedCount[CommandStateType::MAX] = {};	//!< redundant calls filtered by shadow state.
+	};	// struct CommandStateStats
+
 }	// namespace mll
 
 
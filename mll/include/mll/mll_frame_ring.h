@@ -0,0 +1,184 @@
+﻿#pragma once
+
+#include "mll_defines.h"
+
+#include <cstddef>
+
+
+namespace mll
+{
+	//-----------------------------------------------------------
+	//! @brief frame ring description.
+	//-----------------------------------------------------------
+	struct FrameRingDesc
+	{
+		const char*				name = nullptr;		//!< shared memory name.
+		u32						width = 0;
+		u32						height = 0;
+		u32						rowPitch = 0;
+		ResourceFormat::Type	format = ResourceFormat::Unknown;
+		u32						depth = 0;			//!< slot count, 2 or more.
+		FrameRingPolicy::Type	policy = FrameRingPolicy::DropOldest;
+	};	// struct FrameRingDesc
+
+	//-----------------------------------------------------------
+	//! @brief frame taken by consumer.
+	//-----------------------------------------------------------
+	struct FrameRingFrame
+	{
+		const u8*				pData = nullptr;
+		u64						sequence = 0;		//!< 1 origin present count.
+		u32						slot = 0;
+		u32						width = 0;
+		u32						height = 0;
+		u32						rowPitch = 0;
+		ResourceFormat::Type	format = ResourceFormat::Unknown;
+	};	// struct FrameRingFrame
+
+	//-----------------------------------------------------------
+	//! @brief shared memory mapping.
+	//-----------------------------------------------------------
+	class SharedMemory
+	{
+	public:
+		SharedMemory()
+		{}
+		~SharedMemory()
+		{
+			Close();
+		}
+
+		SharedMemory(const SharedMemory&) = delete;
+		SharedMemory& operator=(const SharedMemory&) = delete;
+
+		/**
+		 * @brief create and map shared memory. existing memory with same name is replaced.
+		*/
+		Result::Type Create(const char* name, size_t size);
+
+		/**
+		 * @brief map existing shared memory.
+		*/
+		Result::Type Open(const char* name);
+
+		/**
+		 * @brief unmap, and remove name if created.
+		*/
+		void Close();
+
+		u8* GetMemory() const
+		{
+			return pMemory_;
+		}
+		size_t GetSize() const
+		{
+			return size_;
+		}
+
+	private:
+		u8*			pMemory_ = nullptr;
+		size_t		size_ = 0;
+		void*		handle_ = nullptr;		// file mapping handle on Windows.
+		char		name_[256] = {};
+		bool		isOwner_ = false;
+	};	// class SharedMemory
+
+	//-----------------------------------------------------------
+	//! @brief producer side of shared memory frame ring.
+	//!
+	//! Each slot holds one frame and a state word (sequence << 2 | status).
+	//! Producer renders into its current slot directly, Publish hands it to consumer
+	//! and takes the next free slot, so frames are never copied.
+	//-----------------------------------------------------------
+	class FrameRingWriter
+	{
+	public:
+		FrameRingWriter()
+		{}
+		~FrameRingWriter()
+		{
+			Destroy();
+		}
+
+		FrameRingWriter(const FrameRingWriter&) = delete;
+		FrameRingWriter& operator=(const FrameRingWriter&) = delete;
+
+		Result::Type Create(const FrameRingDesc& desc);
+		void Destroy();
+
+		/**
+		 * @brief publish current slot and take next slot for writing.
+		 *
+		 * @return					next slot index.
+		 * @note Blocks while consumer holds every other slot, or with Backpressure policy while no slot is free.
+		*/
+		u32 Publish();
+
+		/**
+		 * @brief get frame memory of slot.
+		*/
+		u8* GetSlotMemory(u32 slot) const;
+
+		u32 GetCurrentSlot() const
+		{
+			return currentSlot_;
+		}
+		u32 GetDepth() const;
+
+		/**
+		 * @brief get count of frames overwritten before consumer took them.
+		*/
+		u64 GetDroppedCount() const;
+
+	private:
+		u32 AcquireWritableSlot();
+
+	private:
+		SharedMemory	memory_;
+		u32				currentSlot_ = 0;
+		u64				sequence_ = 0;
+	};	// class FrameRingWriter
+
+	//-----------------------------------------------------------
+	//! @brief consumer side of shared memory frame ring.
+	//-----------------------------------------------------------
+	class FrameRingReader
+	{
+	public:
+		FrameRingReader()
+		{}
+		~FrameRingReader()
+		{
+			Close();
+		}
+
+		FrameRingReader(const FrameRingReader&) = delete;
+		FrameRingReader& operator=(const FrameRingReader&) = delete;
+
+		Result::Type Open(const char* name);
+		void Close();
+
+		/**
+		 * @brief take oldest published frame.
+		 *
+		 * @return					false if no frame is published.
+		 * @note Frame memory is valid until ReleaseFrame, several frames may be taken at once.
+		*/
+		bool AcquireFrame(FrameRingFrame& outFrame);
+
+		/**
+		 * @brief return frame to producer.
+		*/
+		void ReleaseFrame(const FrameRingFrame& frame);
+
+		u64 GetPublishedCount() const;
+		u64 GetDroppedCount() const;
+
+	private:
+		SharedMemory	memory_;
+	};	// class FrameRingReader
+
+}	// namespace mll
+
+
+//	EOF
@@ -0,0 +1,285 @@
+﻿#pragma once
+
+#include "mll_defines.h"
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+
+namespace mll
+{
+	/*! @name fnv1a hash functions. */
+	/* @{ */
+	static const u32 kFnv1aPrime32 = 16777619;
+	static const u32 kFnv1aSeed32 = 0x811c9dc5;
+	static const u64 kFnv1aPrime64 = 1099511628211ULL;
+	static const u64 kFnv1aSeed64 = 0xcbf29ce484222325ULL;
+
+	inline constexpr u32 CalcFnv1a32(u8 oneByte, u32 hash = kFnv1aSeed32)
+	{
+		return (oneByte ^ hash) * kFnv1aPrime32;
+	}
+	inline u32 CalcFnv1a32(const void* data, size_t numBytes, u32 hash = kFnv1aSeed32)
+	{
+		const u8* ptr = reinterpret_cast<const u8*>(data);
+		while (numBytes--)
+			hash = CalcFnv1a32(*ptr++, hash);
+		return hash;
+	}
+	inline constexpr u64 CalcFnv1a64(u8 oneByte, u64 hash = kFnv1aSeed64)
+	{
+		return (oneByte ^ hash) * kFnv1aPrime64;
+	}
+	inline u64 CalcFnv1a64(const void* data, size_t numBytes, u64 hash = kFnv1aSeed64)
+	{
+		const u8* ptr = reinterpret_cast<const u8*>(data);
+		while (numBytes--)
+			hash = CalcFnv1a64(*ptr++, hash);
+		return hash;
+	}
+	/* @} */
+
+	/**
+	 * @brief calc string hash.
+	 *
+	 * @note This is constexpr, string keys can be hashed at compile time.
+	 *       ex) constexpr u64 kKey = CalcStringHash64("key");
+	*/
+	inline constexpr u64 CalcStringHash64(const char* str, u64 hash = kFnv1aSeed64)
+	{
+		while (*str != '\0')
+		{
+			hash = CalcFnv1a64(static_cast<u8>(*str++), hash);
+		}
+		return hash;
+	}
+
+	/*! @name 64bit hash functions. (xxHash64 algorithm) */
+	/* @{ */
+	namespace hash_impl
+	{
+		static const u64 kPrime64_1 = 0x9E3779B185EBCA87ULL;
+		static const u64 kPrime64_2 = 0xC2B2AE3D27D4EB4FULL;
+		static const u64 kPrime64_3 = 0x165667B19E3779F9ULL;
+		static const u64 kPrime64_4 = 0x85EBCA77C2B2AE63ULL;
+		static const u64 kPrime64_5 = 0x27D4EB2F165667C5ULL;
+
+		inline u64 Rotl64(u64 v, u32 r)
+		{
+			return (v << r) | (v >> (64 - r));
+		}
+		inline u64 Read64(const u8* p)
+		{
+			u64 v;
+			memcpy(&v, p, sizeof(v));
+			return v;
+		}
+		inline u32 Read32(const u8* p)
+		{
+			u32 v;
+			memcpy(&v, p, sizeof(v));
+			return v;
+		}
+		inline u64 Round(u64 acc, u64 input)
+		{
+			acc += input * kPrime64_2;
+			acc = Rotl64(acc, 31);
+			return acc * kPrime64_1;
+		}
+		inline u64 MergeRound(u64 acc, u64 v)
+		{
+			acc ^= Round(0, v);
+			return acc * kPrime64_1 + kPrime64_4;
+		}
+		inline u64 MergeLanes(const u64* v)
+		{
+			u64 h = Rotl64(v[0], 1) + Rotl64(v[1], 7) + Rotl64(v[2], 12) + Rotl64(v[3], 18);
+			h = MergeRound(h, v[0]);
+			h = MergeRound(h, v[1]);
+			h = MergeRound(h, v[2]);
+			h = MergeRound(h, v[3]);
+			return h;
+		}
+		inline void InitLanes(u64* v, u64 seed)
+		{
+			v[0] = seed + kPrime64_1 + kPrime64_2;
+			v[1] = seed + kPrime64_2;
+			v[2] = seed;
+			v[3] = seed - kPrime64_1;
+		}
+		inline const u8* ProcessStripes(u64* v, const u8* p, const u8* end)
+		{
+			// 4 independent lanes, 32 bytes per iteration.
+			while (p + 32 <= end)
+			{
+				v[0] = Round(v[0], Read64(p));
+				v[1] = Round(v[1], Read64(p + 8));
+				v[2] = Round(v[2], Read64(p + 16));
+				v[3] = Round(v[3], Read64(p + 24));
+				p += 32;
+			}
+			return p;
+		}
+		inline u64 Finalize(u64 h, const u8* p, size_t len)
+		{
+			while (len >= 8)
+			{
+				h ^= Round(0, Read64(p));
+				h = Rotl64(h, 27) * kPrime64_1 + kPrime64_4;
+				p += 8;
+				len -= 8;
+			}
+			if (len >= 4)
+			{
+				h ^= static_cast<u64>(Read32(p)) * kPrime64_1;
+				h = Rotl64(h, 23) * kPrime64_2 + kPrime64_3;
+				p += 4;
+				len -= 4;
+			}
+			while (len > 0)
+			{
+				h ^= (*p++) * kPrime64_5;
+				h = Rotl64(h, 11) * kPrime64_1;
+				len--;
+			}
+
+			// avalanche.
+			h ^= h >> 33;
+			h *= kPrime64_2;
+			h ^= h >> 29;
+			h *= kPrime64_3;
+			h ^= h >> 32;
+			return h;
+		}
+	}	// namespace hash_impl
+
+	/**
+	 * @brief calc 64bit hash.
+	 *
+	 * @param[in]	data		data to hash.
+	 * @param[in]	numBytes	data size.
+	 * @param[in]	seed		hash seed.
+	*/
+	inline u64 CalcHash64(const void* data, size_t numBytes, u64 seed = 0)
+	{
+		using namespace hash_impl;
+
+		const u8* p = reinterpret_cast<const u8*>(data);
+		const u8* end = p + numBytes;
+		u64 h;
+		if (numBytes >= 32)
+		{
+			u64 v[4];
+			InitLanes(v, seed);
+			p = ProcessStripes(v, p, end);
+			h = MergeLanes(v);
+		}
+		else
+		{
+			h = seed + kPrime64_5;
+		}
+		h += static_cast<u64>(numBytes);
+		return Finalize(h, p, static_cast<size_t>(end - p));
+	}
+
+	/**
+	 * @brief calc 64bit hash of trivially copyable value.
+	*/
+	template <typename T>
+	inline u64 CalcValueHash64(const T& value, u64 seed = 0)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "hashed type must be trivially copyable.");
+		return CalcHash64(&value, sizeof(T), seed);
+	}
+
+	//-----------------------------------------------------------
+	//! @brief Streaming 64bit hasher.
+	//!
+	//! Gives the same result as CalcHash64 for the concatenated data.
+	//-----------------------------------------------------------
+	class Hasher64
+	{
+	public:
+		explicit Hasher64(u64 seed = 0)
+		{
+			Reset(seed);
+		}
+
+		/**
+		 * @brief reset hasher.
+		*/
+		void Reset(u64 seed = 0)
+		{
+			hash_impl::InitLanes(lanes_, seed);
+			seed_ = seed;
+			totalBytes_ = 0;
+			bufferSize_ = 0;
+		}
+
+		/**
+		 * @brief append data.
+		*/
+		Hasher64& Update(const void* data, size_t numBytes)
+		{
+			const u8* p = reinterpret_cast<const u8*>(data);
+			const u8* end = p + numBytes;
+			totalBytes_ += numBytes;
+
+			// fill pending buffer first.
+			if (bufferSize_ + numBytes < sizeof(buffer_))
+			{
+				memcpy(buffer_ + bufferSize_, p, numBytes);
+				bufferSize_ += static_cast<u32>(numBytes);
+				return *this;
+			}
+			if (bufferSize_ > 0)
+			{
+				size_t fill = sizeof(buffer_) - bufferSize_;
+				memcpy(buffer_ + bufferSize_, p, fill);
+				hash_impl::ProcessStripes(lanes_, buffer_, buffer_ + sizeof(buffer_));
+				p += fill;
+				bufferSize_ = 0;
+			}
+
+			p = hash_impl::ProcessStripes(lanes_, p, end);
+			bufferSize_ = static_cast<u32>(end - p);
+			memcpy(buffer_, p, bufferSize_);
+			return *this;
+		}
+
+		/**
+		 * @brief append trivially copyable value.
+		*/
+		template <typename T>
+		Hasher64& UpdateValue(const T& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "hashed type must be trivially copyable.");
+			return Update(&value, sizeof(T));
+		}
+
+		/**
+		 * @brief get hash value of appended data.
+		*/
+		u64 Finalize() const
+		{
+			using namespace hash_impl;
+
+			u64 h = (totalBytes_ >= sizeof(buffer_)) ? MergeLanes(lanes_) : seed_ + kPrime64_5;
+			h += totalBytes_;
+			return hash_impl::Finalize(h, buffer_, bufferSize_);
+		}
+
+	private:
+		u64		lanes_[4];
+		u64		seed_ = 0;
+		u64		totalBytes_ = 0;
+		u8		buffer_[32];
+		u32		bufferSize_ = 0;
+	};	// class Hasher64
+	/* @} */
+
+}	// namespace mll
+
+
+//	EOF
@@ -2,10 +2,21 @@
 
 #include <memory>
 #include <atomic>
-#include <list>
-#include <set>
+#include <utility>
+#include <deque>
 #include <string>
 #include <mutex>
+#include <vector>
+#include <thread>
+#include <condition_variable>
+#include <cassert>
+
+#include "mll_allocator.h"
+#include "mll_command_stream.h"
+#include "mll_hash.h"
+#include "mll_name_table.h"
+#include "mll_object_table.h"
+#include "mll_state_cache.h"
 
 
 namespace mll
@@ -17,6 +28,7 @@ namespace mll
 	class ICommandList;
 	class ISwapchain;
 	class ITexture;
+	class CommandCaptureWriter;
 
 	//-----------------------------------------------------------
 	//! @brief safe release.
@@ -47,37 +59,48 @@ namespace mll
 		return t == Result::Ok;
 	}
 
-	/*! @name fnv1a hash functions. */
-	/* @{ */
-	static const u32 kFnv1aPrime32 = 16777619;
-	static const u32 kFnv1aSeed32 = 0x811c9dc5;
-	static const u64 kFnv1aPrime64 = 1099511628211L;
-	static const u64 kFnv1aSeed64 = 0xcbf29ce484222325L;
-
-	inline u32 CalcFnv1a32(u8 oneByte, u32 hash = kFnv1aSeed32)
-	{
-		return (oneByte ^ hash) * kFnv1aPrime32;
-	}
-	inline u32 CalcFnv1a32(const void* data, size_t numBytes, u32 hash = kFnv1aSeed32)
-	{
-		const u8* ptr = reinterpret_cast<const u8*>(data);
-		while (numBytes--)
-			hash = CalcFnv1a32(*ptr++, hash);
-		return hash;
-	}
-	inline u64 CalcFnv1a64(u8 oneByte, u64 hash = kFnv1aSeed64)
-	{
-		return (oneByte ^ hash) * kFnv1aPrime32;
-	}
-	inline u64 CalcFnv1a64(const void* data, size_t numBytes, u64 hash = kFnv1aSeed64)
+	//-----------------------------------------------------------
+	//! @brief Intrusive reference counter.
+	//-----------------------------------------------------------
+	class ObjRefCounter
 	{
-		const u8* ptr = reinterpret_cast<const u8*>(data);
-		while (numBytes--)
-			hash = CalcFnv1a64(*ptr++, hash);
-		return hash;
-	}
-	/* @} */
+		template <typename T>
+		friend class ObjPtr;
+		template <typename T>
+		friend class ObjWeakPtr;
 
+	protected:
+		ObjRefCounter()
+		{}
+		~ObjRefCounter()
+		{}
+
+	private:
+		void AddRef()
+		{
+			refCount_.fetch_add(1, std::memory_order_relaxed);
+		}
+		bool TryAddRef()
+		{
+			// fail if the object is already killed.
+			auto count = refCount_.load(std::memory_order_relaxed);
+			while (count != 0)
+			{
+				if (refCount_.compare_exchange_weak(count, count + 1, std::memory_order_acquire, std::memory_order_relaxed))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+		u32 SubRef()
+		{
+			return refCount_.fetch_sub(1, std::memory_order_acq_rel) - 1;
+		}
+
+	private:
+		std::atomic<u32>	refCount_{ 0 };
+	};	// class ObjRefCounter
 
 	//-----------------------------------------------------------
 	//! @brief Safe object pointer.
@@ -85,123 +108,191 @@ namespace mll
 	template <typename T>
 	class ObjPtr
 	{
-		template <typename T>
+		template <typename U>
 		friend class ObjWeakPtr;
 
 		friend class IDevice;
+		friend class ICommandList;
 
 	public:
-		typedef typename ObjPtr<T> SelfType;
+		typedef ObjPtr<T> SelfType;
 
 		ObjPtr()
 		{}
 		ObjPtr(const SelfType& t)
 			: obj_(t.obj_)
-			, id_(t.id_)
-		{}
+		{
+			if (obj_ != nullptr)
+			{
+				obj_->AddRef();
+			}
+		}
+		ObjPtr(SelfType&& t)
+			: obj_(t.obj_)
+		{
+			t.obj_ = nullptr;
+		}
+		~ObjPtr()
+		{
+			Reset();
+		}
+
+		SelfType& operator=(const SelfType& t)
+		{
+			SelfType(t).Swap(*this);
+			return *this;
+		}
+		SelfType& operator=(SelfType&& t)
+		{
+			SelfType(std::move(t)).Swap(*this);
+			return *this;
+		}
 
 		void Reset()
 		{
-			obj_.reset();
+			if (obj_ != nullptr)
+			{
+				if (obj_->SubRef() == 0)
+				{
+					obj_->Release();
+				}
+				obj_ = nullptr;
+			}
+		}
+
+		void Swap(SelfType& t)
+		{
+			std::swap(obj_, t.obj_);
 		}
 
 		bool IsValid() const
 		{
-			return (obj_.get() != nullptr);
+			return (obj_ != nullptr);
 		}
 
 		operator const T* () const
 		{
-			return obj_.get();
+			return obj_;
 		}
 		operator T* ()
 		{
-			return obj_.get();
+			return obj_;
 		}
 		const T* operator->() const
 		{
-			return obj_.get();
+			return obj_;
 		}
 		T* operator->()
 		{
-			return obj_.get();
+			return obj_;
 		}
 
 		bool operator==(const SelfType& t) const
 		{
-			return id_ == t.id_;
+			return obj_ == t.obj_;
 		}
 		bool operator<(const SelfType& t) const
 		{
-			return id_ < t.id_;
+			return obj_ < t.obj_;
 		}
 		bool operator>(const SelfType& t) const
 		{
-			return id_ > t.id_;
+			return obj_ > t.obj_;
 		}
 
 	private:
-		ObjPtr(T* obj, u64 id)
-			: obj_(obj, [](T* p) { p->Release(); })
-			, id_(id)
-		{}
+		explicit ObjPtr(T* obj)
+			: obj_(obj)
+		{
+			if (obj_ != nullptr)
+			{
+				obj_->AddRef();
+			}
+		}
 
-		std::shared_ptr<T>	obj_;
-		u64					id_ = 0;
+		T*		obj_ = nullptr;
 	};	// class ObjPtr
 
 	//-----------------------------------------------------------
 	//! @brief Safe object weak pointer.
+	//!
+	//! Validity is checked with the generation of object slot, no reference count is touched.
+	//! Raw pointer given from this is valid until next IDevice::ProcDeathList.
 	//-----------------------------------------------------------
 	template <typename T>
 	class ObjWeakPtr
 	{
 	public:
-		typedef typename ObjWeakPtr<T> SelfType;
+		typedef ObjWeakPtr<T> SelfType;
 
 		ObjWeakPtr()
 		{}
 		ObjWeakPtr(const SelfType& t)
 			: obj_(t.obj_)
-			, id_(t.id_)
+			, pSlot_(t.pSlot_)
+			, generation_(t.generation_)
 		{}
 		ObjWeakPtr(const ObjPtr<T>& t)
 			: obj_(t.obj_)
-			, id_(t.id_)
-		{}
+		{
+			if (obj_ != nullptr)
+			{
+				pSlot_ = obj_->pSlot_;
+				generation_ = pSlot_->generation.load(std::memory_order_relaxed);
+			}
+		}
 
 		bool IsValid() const
 		{
-			return !obj_.expired();
+			return (pSlot_ != nullptr) && (pSlot_->generation.load(std::memory_order_acquire) == generation_);
+		}
+
+		/**
+		 * @brief get strong pointer.
+		 *
+		 * @return		strong pointer. (invalid if object is already killed)
+		*/
+		ObjPtr<T> Lock() const
+		{
+			ObjPtr<T> ret;
+			if (IsValid() && obj_->TryAddRef())
+			{
+				ret.obj_ = obj_;
+			}
+			return ret;
 		}
 
 		operator const T* () const
 		{
-			return obj_.lock().get();
+			return IsValid() ? obj_ : nullptr;
 		}
 		operator T* ()
 		{
-			return obj_.lock().get();
+			return IsValid() ? obj_ : nullptr;
 		}
 		const T* operator->() const
 		{
-			return obj_.lock().get();
+			return IsValid() ? obj_ : nullptr;
 		}
 		T* operator->()
 		{
-			return obj_.lock().get();
+			return IsValid() ? obj_ : nullptr;
 		}
 
 	private:
-		std::weak_ptr<T>	obj_;
-		u64					id_ = 0;
+		T*					obj_ = nullptr;
+		const ObjectSlot*	pSlot_ = nullptr;
+		u32					generation_ = 0;
 	};	// class ObjWeakPtr
 
 	//-----------------------------------------------------------
 	//! @brief Graphics device interface.
 	//-----------------------------------------------------------
 	class IDevice
+		: public ObjRefCounter
 	{
+		MLL_DECLARE_CLASS_ALLOCATOR(AllocCategory::Device);
+
 		template <typename T>
 		friend class ObjPtr;
 		friend class IDeviceChild;
@@ -211,6 +302,10 @@ namespace mll
 		 * @brief Iterate death list.
 		 *
 		 * @param[in]	bForce		強制的に全てのオブジェクトを削除するフラグ
+		 *
+		 * @note Objects are deleted after every command queue has completed the fence value signaled before they were killed.
+		 *       At most DeviceDesc::deathListBudget objects are deleted per call unless bForce is true.
+		 *       If reclaim thread is enabled, destructors run on it.
 		*/
 		void ProcDeathList(bool bForce = false);
 
@@ -219,19 +314,34 @@ namespace mll
 		 *
 		 * @param[in]	func		オブジェクトごとに実行する関数
 		 * @return					生き残っているオブジェクト数
+		 *
+		 * @note Iterates a snapshot of live objects, creation and kill on other threads are not blocked.
+		 *       Death list processing is blocked while iterating, so do not call ProcDeathList in func.
+		 *       Killed objects are listed until next ProcDeathList.
 		*/
 		template <typename TFunc>
 		u32 IterateLiveObjects(TFunc func)
 		{
-			u32 ret = 0;
-			for (auto&& obj : liveObjects_)
+			std::lock_guard<std::mutex> lock(deathMutex_);
+			std::vector<IDeviceChild*> objs;
+			u32 ret = objectTable_.Snapshot(objs);
+			for (auto&& obj : objs)
 			{
 				func(obj);
-				ret++;
 			}
 			return ret;
 		}
 
+		/**
+		 * @brief Get telemetry snapshot.
+		 *
+		 * @param[in]	bResetFrame		フレーム単位のカウンタをリセットするフラグ
+		 *
+		 * @note Lock free, counters are read one by one so the snapshot is not an atomic view.
+		 *       Call with bResetFrame = true once per frame to get per frame counts.
+		*/
+		DeviceStats GetStats(bool bResetFrame = false);
+
 		/**
 		 * @brief Get raytracing is enabled, or not.
 		*/
@@ -240,6 +350,27 @@ namespace mll
 			return enableRaytracing_;
 		}
 
+		/**
+		 * @brief Start capturing texture creations and submitted command lists to file.
+		 *
+		 * @note Textures created before capture are captured on first reference.
+		 *       Do not call while other threads create textures or submit command lists.
+		*/
+		Result::Type BeginCapture(const char* path);
+
+		/**
+		 * @brief Finish capture and close file.
+		*/
+		void EndCapture();
+
+		/**
+		 * @brief Get capture is running, or not.
+		*/
+		bool IsCapturing() const
+		{
+			return pCapture_ != nullptr;
+		}
+
 	private:
 		/**
 		 * @brief Kill device child.
@@ -248,8 +379,106 @@ namespace mll
 		*/
 		void KillDeviceChild(IDeviceChild* obj);
 
-		// --- @start these functions implement in each platform library.
+		/**
+		 * @brief Move killed objects from lock-free kill stack to death list.
+		*/
+		void DrainKillStack();
+
+		/**
+		 * @brief Count created device child.
+		*/
+		void CountCreatedDeviceChild(const IDeviceChild* obj);
+
+		/**
+		 * @brief Count and delete device child.
+		*/
+		void DestroyDeviceChild(IDeviceChild* obj);
+
+		/**
+		 * @brief Reclaim thread main function.
+		*/
+		void ReclaimThreadMain();
+
+		/**
+		 * @brief Check device child is no longer used by GPU.
+		 *
+		 * @param[in]	obj			チェックするオブジェクト
+		 * @param[in]	completed	各コマンドキューの完了済みフェンス値
+		*/
+		static bool IsRetired(const IDeviceChild* obj, const u64* completed);
+
+		/**
+		 * @brief Allocate unique object id.
+		*/
+		static u64 AllocateObjectId();
+
 	public:
+		/**
+		 * @brief submit command list to its command queue.
+		 *
+		 * @return					fence value signaled after the command list.
+		*/
+		u64 Submit(ICommandList* pCmdList);
+
+		/**
+		 * @brief check submission is completed on GPU.
+		*/
+		bool IsTicketCompleted(const SubmitTicket& ticket)
+		{
+			return GetCompletedFenceValue(ticket.queueType) >= ticket.fenceValue;
+		}
+
+		// --- @start these functions implement in each platform library.
+		/**
+		 * @brief get last fence value signaled on command queue.
+		*/
+		u64 GetSignaledFenceValue(CommandQueueType::Type type);
+
+		/**
+		 * @brief get fence value completed on command queue.
+		*/
+		u64 GetCompletedFenceValue(CommandQueueType::Type type);
+
+		/**
+		 * @brief submit command lists to command queue at once.
+		 *
+		 * @param[in]	type			command queue type. all command lists must be created for this type.
+		 * @param[in]	ppCmdLists		command lists executed in order.
+		 * @param[in]	count			command list count.
+		 * @param[in]	pWaitTickets	submissions on other queues which GPU waits before execution.
+		 * @param[in]	waitTicketCount	wait ticket count.
+		 * @return						ticket signaled after all command lists.
+		 *
+		 * @note One native submission and one fence signal are issued for the batch.
+		*/
+		SubmitTicket Submit(CommandQueueType::Type type, ICommandList* const* ppCmdLists, u32 count, const SubmitTicket* pWaitTickets = nullptr, u32 waitTicketCount = 0);
+
+		/**
+		 * @brief block CPU until submission is completed.
+		*/
+		void WaitTicket(const SubmitTicket& ticket);
+
+		/**
+		 * @brief get command allocator pool statistics.
+		 *
+		 * @note Backends without native allocators return zero.
+		*/
+		void GetCommandAllocatorStats(CommandQueueType::Type type, CommandAllocatorStats& outStats);
+
+		/**
+		 * @brief get shader visible descriptor ring statistics.
+		 *
+		 * @note Backends without descriptor heaps return zero.
+		*/
+		void GetDescriptorRingStats(CommandQueueType::Type type, DescriptorRingStats& outStats);
+
+		/**
+		 * @brief get shader visible sampler cache statistics.
+		 *
+		 * @note Backends without descriptor heaps return zero.
+		*/
+		void GetSamplerCacheStats(SamplerCacheStats& outStats);
+
 		/**
 		 * @brief create command list.
 		*/
@@ -277,30 +506,94 @@ namespace mll
 		IDevice()
 		{}
 		virtual ~IDevice()
-		{}
+		{
+			EndCapture();
+		}
 
 		IDevice(const IDevice&) = delete;
 		IDevice& operator=(const IDevice&) = delete;
 
+		/**
+		 * @brief Initialize death list processing.
+		 *
+		 * @note Call from platform device initialization.
+		*/
+		void InitializeDeathList(const DeviceDesc& desc);
+
+		/**
+		 * @brief Delete all objects in death list and stop reclaim thread.
+		 *
+		 * @note Call from platform device destruction after GPU is idle.
+		*/
+		void FinalizeDeathList();
+
+		/**
+		 * @brief Capture submitted command lists if capture is running.
+		 *
+		 * @note Call from platform Submit before execution.
+		*/
+		void CaptureSubmit(CommandQueueType::Type type, ICommandList* const* ppCmdLists, u32 count);
+
+		/**
+		 * @brief register created object to device.
+		 *
+		 * @return			OutOfMemory if object table is full, caller deletes object.
+		*/
 		template <typename T>
-		ObjPtr<T> AppendDeviceChild(T* obj)
+		Result::Type AppendDeviceChild(T* obj, ObjPtr<T>& outObj)
 		{
-			std::lock_guard<std::mutex> lock(objectMutex_);
-			liveObjects_.insert(obj);
-			u64 id = objectId_.fetch_add(1);
-			obj->SetObjectId(id);
+			obj->SetObjectId(AllocateObjectId());
 			obj->SetParentDevice(this);
-			return ObjPtr<T>(obj, id);
+			auto slot = objectTable_.Insert(obj);
+			if (slot == nullptr)
+			{
+				return Result::OutOfMemory;
+			}
+			obj->SetObjectSlot(slot);
+			CountCreatedDeviceChild(obj);
+			outObj = ObjPtr<T>(obj);
+			return Result::Ok;
 		}
 
 	protected:
-		std::mutex					objectMutex_;			// オブジェクト追加、削除用Mutex
-		std::set<IDeviceChild*>		liveObjects_;			// 自身が生成したオブジェクト
-		std::list<IDeviceChild*>	deathList_;				// デスリスト
+		ObjectTable					objectTable_;			// 自身が生成したオブジェクト
+		std::atomic<IDeviceChild*>	killStackHead_{ nullptr };	// 削除要求スタック(lock-free)
+		std::mutex					deathMutex_;			// デスリスト処理用Mutex
+		std::deque<IDeviceChild*>	deathList_;				// デスリスト(削除要求順)
+		u32							deathListBudget_ = 0;	// 1回の処理で削除する最大数(0は無制限)
+
+		std::thread					reclaimThread_;			// オブジェクト削除スレッド
+		std::mutex					reclaimMutex_;			// 削除スレッド用Mutex
+		std::condition_variable		reclaimCond_;
+		std::vector<IDeviceChild*>	reclaimList_;			// 削除スレッドに渡すオブジェクト
+		bool						reclaimExit_ = false;
 
 		bool	enableRaytracing_ = false;
 
+		CommandCaptureWriter*	pCapture_ = nullptr;		// 実行中のキャプチャ
+
 	private:
+		struct ObjectTypeCounters
+		{
+			std::atomic<u64>	liveCount{ 0 };
+			std::atomic<u64>	pendingCount{ 0 };
+			std::atomic<u64>	peakLiveCount{ 0 };
+			std::atomic<u64>	totalCreatedCount{ 0 };
+			std::atomic<u64>	totalDestroyedCount{ 0 };
+			std::atomic<u64>	frameCreatedCount{ 0 };
+			std::atomic<u64>	frameDestroyedCount{ 0 };
+		};	// struct ObjectTypeCounters
+
+		struct HeapCounters
+		{
+			std::atomic<u64>	bytes{ 0 };
+			std::atomic<u64>	peakBytes{ 0 };
+		};	// struct HeapCounters
+
+		ObjectTypeCounters		objectCounters_[ObjectType::MAX];	// オブジェクト種別ごとのカウンタ
+		HeapCounters			heapCounters_[ResourceHeap::MAX];	// ヒープ種別ごとの推定メモリ量
+		std::atomic<u64>		statsFrameIndex_{ 0 };
+
 		static std::atomic<u64>	objectId_;
 
 	public:
@@ -316,12 +609,17 @@ namespace mll
 	//! @brief Device child interface.
 	//-----------------------------------------------------------
 	class IDeviceChild
+		: public ObjRefCounter
 	{
+		MLL_DECLARE_CLASS_ALLOCATOR(AllocCategory::Object);
+
 		friend class IDevice;
 
 	protected:
 		template <typename T>
 		friend class ObjPtr;
+		template <typename T>
+		friend class ObjWeakPtr;
 
 	public:
 		/**
@@ -335,9 +633,43 @@ namespace mll
 		/**
 		 * @brief Get object name.
 		*/
-		const std::string& GetObjectName() const
+		const char* GetObjectName() const
 		{
-			return objectName_;
+			return GetInternedName(nameId_);
+		}
+
+		/**
+		 * @brief Get object name id.
+		*/
+		NameId GetObjectNameId() const
+		{
+			return nameId_;
+		}
+
+		/**
+		 * @brief Set object name.
+		 *
+		 * @return		OutOfMemory if name table is full, object name is not changed then.
+		 * @note The name is interned, so naming objects every frame only costs a table lookup.
+		 *       Interned names are permanent, reuse names instead of making unique names per frame.
+		*/
+		Result::Type SetObjectName(const char* name)
+		{
+			auto id = InternName(name);
+			if (id == kEmptyNameId && name != nullptr && name[0] != '\0')
+			{
+				return Result::OutOfMemory;
+			}
+			SetObjectName(id);
+			return Result::Ok;
+		}
+		void SetObjectName(NameId id)
+		{
+			if (nameId_ != id)
+			{
+				nameId_ = id;
+				OnObjectNameChanged();
+			}
 		}
 
 		/**
@@ -345,8 +677,17 @@ namespace mll
 		*/
 		virtual const char* GetObjectType() const = 0;
 
+		/**
+		 * @brief Get object type id.
+		*/
+		ObjectType::Type GetObjectTypeId() const
+		{
+			return objectType_;
+		}
+
 	protected:
-		IDeviceChild()
+		IDeviceChild(ObjectType::Type type)
+			: objectType_(type)
 		{}
 		virtual ~IDeviceChild()
 		{}
@@ -354,9 +695,23 @@ namespace mll
 		IDeviceChild(const IDeviceChild&) = delete;
 		IDeviceChild& operator=(const IDeviceChild&) = delete;
 
-		void SetObjectName(const std::string& name)
+		/**
+		 * @brief Called when object name is changed.
+		 *
+		 * @note Override in each platform library to propagate the name to native object.
+		*/
+		virtual void OnObjectNameChanged()
+		{}
+
+		/**
+		 * @brief Set estimated memory size for telemetry.
+		 *
+		 * @note Call in platform object initialization, before the object is registered to device.
+		*/
+		void SetMemoryFootprint(ResourceHeap::Type heap, u64 bytes)
 		{
-			objectName_ = name;
+			memoryHeap_ = heap;
+			memoryBytes_ = bytes;
 		}
 
 		void KillSelf()
@@ -378,13 +733,22 @@ namespace mll
 		{
 			objectId_ = id;
 		}
+		void SetObjectSlot(ObjectSlot* slot)
+		{
+			pSlot_ = slot;
+		}
 
 	protected:
 		IDevice*		pParentDevice_ = nullptr;
 	private:
-		std::string		objectName_ = "";
-		u64				objectId_ = 0;
-		u8				pendingKillCount_ = 0;
+		ObjectType::Type	objectType_;
+		NameId				nameId_ = kEmptyNameId;
+		u64					objectId_ = 0;
+		ObjectSlot*			pSlot_ = nullptr;
+		u64					retireFenceValues_[CommandQueueType::MAX] = {};	// 削除可能になるフェンス値
+		IDeviceChild*		pNextKill_ = nullptr;								// 削除要求スタックのリンク
+		ResourceHeap::Type	memoryHeap_ = ResourceHeap::Default;				// 推定メモリ量の計上先ヒープ
+		u64					memoryBytes_ = 0;									// 推定メモリ量
 	};	// class IDeviceChild
 
 	//-----------------------------------------------------------
@@ -410,25 +774,167 @@ namespace mll
 			return desc_;
 		}
 
+		/**
+		 * @brief Get recorded command stream.
+		 *
+		 * @note Stream is valid from End to next Begin.
+		*/
+		const CommandStream& GetCommandStream() const
+		{
+			return stream_;
+		}
+
+		/**
+		 * @brief Check recording.
+		*/
+		bool IsRecording() const
+		{
+			return isRecording_;
+		}
+
+		/**
+		 * @brief Check bundle command list.
+		*/
+		bool IsBundle() const
+		{
+			return desc_.typeCommandList == CommandListType::Bundle;
+		}
+
+		/**
+		 * @brief Get native state calls of last translation.
+		 *
+		 * @note Backends without native command list return zero.
+		*/
+		const CommandStateStats& GetStateStats() const
+		{
+			return stateStats_;
+		}
+
+		/**
+		 * @brief clear texture subresource.
+		 *
+		 * @param[in]	pTexture		clear target.
+		 * @param[in]	subresource		subresource index. (mip + arraySlice * mipLevels)
+		 * @param[in]	color			clear value. depth and stencil use color[0] and color[1].
+		 *
+		 * @note Texture needs RenderTarget or DepthStencil usage on GPU backends.
+		*/
+		void ClearTexture(ITexture* pTexture, u32 subresource, const f32* color);
+
+		/**
+		 * @brief copy texture subresource.
+		 *
+		 * @note Format conversion between different formats is supported only by CPU execution,
+		 *       GPU backends require copy compatible formats.
+		*/
+		void CopyTexture(ITexture* pDst, u32 dstSubresource, ITexture* pSrc, u32 srcSubresource);
+
+		/**
+		 * @brief resolve multisampled texture subresource.
+		 *
+		 * @note Samples are averaged, integer formats take the first sample.
+		*/
+		void ResolveTexture(ITexture* pDst, u32 dstSubresource, ITexture* pSrc, u32 srcSubresource);
+
+		/**
+		 * @brief execute recorded bundle.
+		 *
+		 * @param[in]	pBundle			bundle command list of same command queue type, not recording.
+		 *
+		 * @note Bundles can not be nested. Command list keeps bundle alive until next Begin.
+		 *       Recording bundle again invalidates command lists which executed it on all backends,
+		 *       record them again before next submission. Submit asserts this.
+		*/
+		void ExecuteBundle(ICommandList* pBundle);
+
+		/**
+		 * @brief Check bundles executed by this list were recorded again after they were executed.
+		*/
+		bool IsExecutedBundleChanged() const;
+
+		/**
+		 * @brief record copy of command packet.
+		 *
+		 * @note Used to record packets built outside of command list, e.g. sorted packets.
+		*/
+		void RecordPacket(const CommandPacketHeader& header);
+
 		// --- @start these functions implement in each platform library.
 		/**
 		 * @brief begin command load.
+		 *
+		 * @note Previous command stream is discarded.
 		*/
 		void Begin();
 
 		/**
 		 * @brief end command load.
+		 *
+		 * @note GPU backends translate command stream to native command list here.
 		*/
 		void End();
 		// --- @end these functions implement in each platform library.
 
 	protected:
 		ICommandList()
+			: IDeviceChild(ObjectType::CommandList)
 		{}
 		virtual ~ICommandList()
 		{}
 
+		/**
+		 * @brief Update shadow state and count the call.
+		 *
+		 * @return					true if native call is required.
+		*/
+		template <typename T>
+		bool ApplyState(CommandStateType::Type type, ShadowState<T>& state, const T& value)
+		{
+			bool changed = state.Set(value);
+			CountState(type, changed ? 1 : 0, changed ? 0 : 1);
+			return changed;
+		}
+
+		/**
+		 * @brief Count native state calls.
+		*/
+		void CountState(CommandStateType::Type type, u64 issued, u64 eliminated)
+		{
+			stateStats_.issuedCount[type] += issued;
+			stateStats_.eliminatedCount[type] += eliminated;
+		}
+
+		/**
+		 * @brief Hold objects referenced by recorded packet.
+		 *
+		 * @note Objects are held until next Begin, so they are killed after submissions of the stream.
+		*/
+		void HoldReference(IDeviceChild* obj);
+		void HoldPacketReferences(CommandPacketHeader& header);
+		void HoldBundle(ICommandList* pBundle);
+
+		/**
+		 * @brief Discard previous stream and its references at Begin.
+		 *
+		 * @note Objects of previous stream are killed after its submissions.
+		*/
+		void ResetStream();
+
+	private:
+		struct ExecutedBundle
+		{
+			const ICommandList*		pBundle;
+			u32						recordCount;		// record count of bundle when executed.
+		};	// struct ExecutedBundle
+
+	protected:
 		CommandListDesc		desc_;
+		CommandStream		stream_;
+		CommandStateStats	stateStats_;
+		bool				isRecording_ = false;
+		u32					recordCount_ = 0;
+		std::vector<ObjPtr<IDeviceChild>>	references_;		// objects used by stream.
+		std::vector<ExecutedBundle>			executedBundles_;
 	};	// class ICommandList
 
 	//-----------------------------------------------------------
@@ -464,10 +970,18 @@ namespace mll
 		 * @brief get current backbuffer index.
 		*/
 		u32 GetBackBufferIndex() const;
+
+		/**
+		 * @brief get backbuffer texture.
+		 *
+		 * @note Backbuffers are valid while swapchain is alive.
+		*/
+		ITexture* GetBackBuffer(u32 index);
 		// --- @end these functions implement in each platform library.
 
 	protected:
 		ISwapchain()
+			: IDeviceChild(ObjectType::Swapchain)
 		{}
 		virtual ~ISwapchain()
 		{}
@@ -490,6 +1004,8 @@ namespace mll
 			return "Texture";
 		}
 
+		static const u32	kInvalidBindlessIndex = 0xffffffff;
+
 		/**
 		 * @brief get initial desc.
 		*/
@@ -499,10 +1015,24 @@ namespace mll
 		}
 
 		// --- @start these functions implement in each platform library.
+		/**
+		 * @brief get index of shader resource view in bindless descriptor heap.
+		 *
+		 * @return			stable while texture lives. kInvalidBindlessIndex if bindless is disabled or not shader resource.
+		*/
+		u32 GetBindlessSrvIndex() const;
+
+		/**
+		 * @brief get index of unordered access view in bindless descriptor heap.
+		 *
+		 * @return			stable while texture lives. kInvalidBindlessIndex if bindless is disabled or not unordered access.
+		*/
+		u32 GetBindlessUavIndex() const;
 		// --- @end these functions implement in each platform library.
 
 	protected:
 		ITexture()
+			: IDeviceChild(ObjectType::Texture)
 		{}
 		virtual ~ITexture()
 		{}
@@ -513,6 +1043,8 @@ namespace mll
 }
 
 //! @brief new delete interfaces.
+//! @note Classes route allocation to user allocator or fixed size pool
+//!       with MLL_DECLARE_CLASS_ALLOCATOR or MLL_DECLARE_POOL_ALLOCATOR.
 //! @{
 #define MLL_NEW(T, ...)		\
 			new T(__VA_ARGS__)
@@ -0,0 +1,51 @@
+﻿#pragma once
+
+#include "mll_defines.h"
+
+
+namespace mll
+{
+	//! @brief interned name id.
+	typedef u32		NameId;
+
+	//! @brief name id of empty string.
+	static const NameId		kEmptyNameId = 0;
+
+	/**
+	 * @brief intern name string.
+	 *
+	 * @param[in]	name		name string. (nullptr is same as empty string)
+	 * @return					name id. same string always returns same id.
+	 *							kEmptyNameId if table is full or allocation failed.
+	 * @note Thread safe. Interned strings are permanent, they are kept until process exit.
+	 *       Table holds about 4M names, do not intern unbounded unique names such as frame numbers.
+	*/
+	NameId InternName(const char* name);
+
+	/**
+	 * @brief find name id without interning.
+	 *
+	 * @param[in]	name		name string.
+	 * @param[out]	outId		name id.
+	 * @return					true if the name is already interned.
+	*/
+	bool FindInternedName(const char* name, NameId& outId);
+
+	/**
+	 * @brief get interned name string.
+	 *
+	 * @param[in]	id			name id.
+	 * @return					name string. (empty string if id is unknown)
+	 * @note Lock free.
+	*/
+	const char* GetInternedName(NameId id);
+
+	/**
+	 * @brief get interned name count.
+	*/
+	u32 GetInternedNameCount();
+
+}	// namespace mll
+
+
+//	EOF
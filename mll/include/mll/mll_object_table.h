@@ -0,0 +1,88 @@
+﻿#pragma once
+
+#include "mll_defines.h"
+
+#include <atomic>
+#include <vector>
+#include <mutex>
+
+
+namespace mll
+{
+	class IDeviceChild;
+
+	//-----------------------------------------------------------
+	//! @brief Object slot.
+	//!
+	//! Generation is incremented when the object in this slot is killed.
+	//! Weak pointers compare it with the generation they captured.
+	//-----------------------------------------------------------
+	struct ObjectSlot
+	{
+		std::atomic<u32>	generation{ 0 };
+		u32					index = 0;
+		u32					denseIndex = 0;
+		IDeviceChild*		pObject = nullptr;
+	};	// struct ObjectSlot
+
+	//-----------------------------------------------------------
+	//! @brief Live object table.
+	//!
+	//! Slots are allocated in fixed size chunks and never move until the table is destroyed,
+	//! so slot address is kept by weak pointers.
+	//! Live objects are also packed in dense array for iteration, insert and remove are O(1).
+	//-----------------------------------------------------------
+	class ObjectTable
+	{
+	public:
+		static const u32	kChunkSize = 1024;
+		static const u32	kMaxChunks = 1024;
+
+		ObjectTable()
+		{}
+		~ObjectTable();
+
+		ObjectTable(const ObjectTable&) = delete;
+		ObjectTable& operator=(const ObjectTable&) = delete;
+
+		/**
+		 * @brief insert object.
+		 *
+		 * @param[in]		obj				object to insert.
+		 * @return			slot of object. (nullptr if table is full)
+		*/
+		ObjectSlot* Insert(IDeviceChild* obj);
+
+		/**
+		 * @brief remove object.
+		 *
+		 * @param[in]		slot			slot of object to remove.
+		*/
+		void Remove(ObjectSlot* slot);
+
+		/**
+		 * @brief copy live objects.
+		 *
+		 * @param[out]		outObjects		live objects.
+		 * @return			live object count.
+		*/
+		u32 Snapshot(std::vector<IDeviceChild*>& outObjects);
+
+		/**
+		 * @brief get live object count.
+		*/
+		u32 GetCount();
+
+	private:
+		std::mutex					mutex_;
+		ObjectSlot*					chunks_[kMaxChunks] = {};
+		u32							slotCount_ = 0;
+		std::vector<ObjectSlot*>	freeSlots_;
+		std::vector<IDeviceChild*>	denseObjects_;
+		std::vector<ObjectSlot*>	denseSlots_;
+	};	// class ObjectTable
+
+}	// namespace mll
+
+
+//	EOF
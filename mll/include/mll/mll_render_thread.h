@@ -0,0 +1,331 @@
+﻿#pragma once
+
+#include "mll_defines.h"
+#include "mll_allocator.h"
+#include "mll_interfaces.h"
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+
+namespace mll
+{
+	//-----------------------------------------------------------
+	//! @brief lock free single producer, single consumer ring of variable size records.
+	//!
+	//! Records are contiguous in memory, a record which does not fit before the end of ring
+	//! is preceded by padding and placed at the beginning.
+	//! Allocate/Commit are called by producer thread, Peek/Pop by consumer thread.
+	//-----------------------------------------------------------
+	class SpscRing
+	{
+	public:
+		static const u32	kRecordAlignment = 16;
+
+		SpscRing()
+		{}
+		~SpscRing()
+		{
+			Destroy();
+		}
+
+		SpscRing(const SpscRing&) = delete;
+		SpscRing& operator=(const SpscRing&) = delete;
+
+		/**
+		 * @brief allocate ring memory.
+		 *
+		 * @param[in]	capacity		ring bytes, power of two.
+		*/
+		Result::Type Initialize(u32 capacity);
+		void Destroy();
+
+		/**
+		 * @brief reserve record memory after committed records.
+		 *
+		 * @return			record memory, or nullptr while consumer has not popped enough records.
+		 * @note Previously allocated record must be committed first.
+		*/
+		void* Allocate(u32 size);
+
+		/**
+		 * @brief publish allocated record to consumer.
+		*/
+		void Commit();
+
+		/**
+		 * @brief get oldest committed record.
+		 *
+		 * @return			record memory, or nullptr if ring is empty.
+		*/
+		void* Peek();
+
+		/**
+		 * @brief release record returned by Peek.
+		*/
+		void Pop();
+
+		bool IsEmpty() const
+		{
+			return readPos_.load(std::memory_order_acquire) == writePos_.load(std::memory_order_acquire);
+		}
+		u32 GetCapacity() const
+		{
+			return capacity_;
+		}
+		u32 GetMaxRecordSize() const
+		{
+			return capacity_ / 2 - kRecordAlignment;
+		}
+
+	private:
+		struct RecordHeader
+		{
+			u32		size;			// bytes including header and alignment.
+			u32		isPadding;
+		};	// struct RecordHeader
+
+		u8*						pMemory_ = nullptr;
+		u32						capacity_ = 0;
+
+		// producer side.
+		alignas(64) std::atomic<u64>	writePos_{ 0 };
+		u64								pendingPos_ = 0;
+		u64								cachedReadPos_ = 0;
+
+		// consumer side.
+		alignas(64) std::atomic<u64>	readPos_{ 0 };
+		u32								peekSize_ = 0;
+	};	// class SpscRing
+
+	//-----------------------------------------------------------
+	//! @brief render thread description.
+	//-----------------------------------------------------------
+	struct RenderThreadDesc
+	{
+		u32			ringBytes = 256 * 1024;			//!< command ring bytes, power of two.
+		u32			frameCount = 0;					//!< frames in flight. 0 uses back buffer count of swapchain.
+		size_t		frameDataPageSize = 64 * 1024;	//!< page size of per frame parameter arena.
+		u32			syncInterval = 1;
+
+		RenderThreadDesc& SetRingBytes(u32 v)
+		{
+			ringBytes = v;
+			return *this;
+		}
+		RenderThreadDesc& SetFrameCount(u32 v)
+		{
+			frameCount = v;
+			return *this;
+		}
+		RenderThreadDesc& SetFrameDataPageSize(size_t v)
+		{
+			frameDataPageSize = v;
+			return *this;
+		}
+		RenderThreadDesc& SetSyncInterval(u32 v)
+		{
+			syncInterval = v;
+			return *this;
+		}
+	};	// struct RenderThreadDesc
+
+	//-----------------------------------------------------------
+	//! @brief state passed to render commands on render thread.
+	//-----------------------------------------------------------
+	struct RenderContext
+	{
+		IDevice*		pDevice = nullptr;
+		ISwapchain*		pSwapchain = nullptr;
+		ICommandList*	pCmdList = nullptr;			//!< recording command list of frame, nullptr outside frame.
+		ITexture*		pBackBuffer = nullptr;		//!< back buffer of frame, nullptr outside frame.
+		u32				backBufferIndex = 0;
+		u32				frameSlot = 0;
+		u64				frameNumber = 0;			//!< 1 origin frame count.
+	};	// struct RenderContext
+
+	//-----------------------------------------------------------
+	//! @brief render thread statistics.
+	//-----------------------------------------------------------
+	struct RenderThreadStats
+	{
+		u64		producedFrameCount = 0;
+		u64		retiredFrameCount = 0;			//!< frames submitted and presented by render thread.
+		u64		commandCount = 0;
+		u64		ringFullWaitCount = 0;			//!< producer waits for ring space.
+		u64		frameWaitCount = 0;				//!< producer waits for free frame slot.
+		u64		gpuWaitCount = 0;				//!< render thread waits for GPU before reusing frame slot.
+	};	// struct RenderThreadStats
+
+	//-----------------------------------------------------------
+	//! @brief frame pipelined render thread front end.
+	//!
+	//! Game thread enqueues render commands into SPSC ring, render thread records them
+	//! into per frame command lists, submits and presents.
+	//! Parameter data of each frame lives in its own arena, so game thread builds frame N + 1
+	//! while render thread reads frame N.
+	//! BeginFrame blocks while all frame slots are in flight, and render thread waits GPU
+	//! completion of the frame which used the slot before, so simulation runs at most
+	//! frameCount frames ahead of back buffers.
+	//! Game thread functions must be called from one thread.
+	//-----------------------------------------------------------
+	class RenderThread
+	{
+		MLL_DECLARE_CLASS_ALLOCATOR(AllocCategory::General);
+
+	public:
+		static const u32	kMaxFrameCount = 4;
+
+		RenderThread()
+		{}
+		~RenderThread()
+		{
+			Destroy();
+		}
+
+		RenderThread(const RenderThread&) = delete;
+		RenderThread& operator=(const RenderThread&) = delete;
+
+		/**
+		 * @brief create frame resources and start render thread.
+		*/
+		Result::Type Initialize(IDevice* pDevice, ISwapchain* pSwapchain, const RenderThreadDesc& desc);
+
+		/**
+		 * @brief execute remaining commands, wait GPU and stop render thread.
+		*/
+		void Destroy();
+
+		// --- game thread.
+		/**
+		 * @brief start new frame.
+		 *
+		 * @note Blocks while frameCount frames are not retired by render thread.
+		*/
+		void BeginFrame();
+
+		/**
+		 * @brief finish frame, render thread submits and presents it.
+		*/
+		void EndFrame();
+
+		/**
+		 * @brief enqueue func(RenderContext&) to run on render thread.
+		 *
+		 * @note func is moved into ring, it must not throw. Blocks while ring is full.
+		*/
+		template <typename TFunc>
+		void Enqueue(TFunc&& func)
+		{
+			typedef typename std::decay<TFunc>::type FuncType;
+			static_assert(alignof(FuncType) <= SpscRing::kRecordAlignment, "render command is over aligned.");
+
+			auto p = AllocateRecord(RecordType::Command, sizeof(FuncType));
+			p->pInvoke = [](void* pFunc, RenderContext& context)
+			{
+				auto p_func = static_cast<FuncType*>(pFunc);
+				(*p_func)(context);
+				p_func->~FuncType();
+			};
+			new(GetRecordPayload(p)) FuncType(std::forward<TFunc>(func));
+			CommitRecord();
+		}
+
+		/**
+		 * @brief allocate parameter data of current frame.
+		 *
+		 * @note Memory is valid until render thread retires the frame.
+		*/
+		void* AllocateFrameData(size_t size, size_t alignment = kDefaultAllocAlignment);
+		template <typename T>
+		T* AllocateFrameData(size_t count = 1)
+		{
+			return static_cast<T*>(AllocateFrameData(sizeof(T) * count, alignof(T)));
+		}
+
+		/**
+		 * @brief wait until all enqueued commands are executed and GPU is idle.
+		*/
+		void Flush();
+
+		RenderThreadStats GetStats() const;
+		u32 GetFrameCount() const
+		{
+			return frameCount_;
+		}
+		bool IsInFrame() const
+		{
+			return isInFrame_;
+		}
+
+	private:
+		MLL_ENUM_START(RecordType)
+			Command,
+			BeginFrame,
+			EndFrame,
+			Flush,
+			Exit,
+		MLL_ENUM_END;
+
+		struct Record
+		{
+			RecordType::Type	type;
+			u32					frameSlot;
+			void				(*pInvoke)(void*, RenderContext&);
+		};	// struct Record
+
+		static const u32	kRecordPayloadOffset = (sizeof(Record) + SpscRing::kRecordAlignment - 1) & ~(SpscRing::kRecordAlignment - 1);
+
+		static void* GetRecordPayload(Record* p)
+		{
+			return reinterpret_cast<u8*>(p) + kRecordPayloadOffset;
+		}
+
+		Record* AllocateRecord(RecordType::Type type, size_t payloadSize);
+		void CommitRecord();
+		void EnqueueAndWait(RecordType::Type type);
+		void ThreadMain();
+		void WaitGpu(u32 frameSlot);
+
+	private:
+		IDevice*					pDevice_ = nullptr;
+		ISwapchain*					pSwapchain_ = nullptr;
+		u32							frameCount_ = 0;
+		u32							syncInterval_ = 1;
+		SpscRing					ring_;
+		std::thread					thread_;
+
+		ObjPtr<ICommandList>		cmdLists_[kMaxFrameCount];
+		SubmitTicket				tickets_[kMaxFrameCount];
+		LinearArena*				pFrameData_[kMaxFrameCount] = {};
+
+		// game thread.
+		u64							producedFrame_ = 0;
+		u64							producedRecords_ = 0;
+		u64							commandCount_ = 0;
+		u64							ringFullWaitCount_ = 0;
+		u64							frameWaitCount_ = 0;
+		bool						isInFrame_ = false;
+
+		// render thread.
+		RenderContext				context_;
+		std::atomic<u64>			retiredFrame_{ 0 };
+		std::atomic<u64>			executedRecords_{ 0 };
+		std::atomic<u64>			gpuWaitCount_{ 0 };
+
+		// sleep of render thread while ring is empty.
+		std::mutex					mutex_;
+		std::condition_variable		cond_;
+		std::atomic<bool>			isSleeping_{ false };
+	};	// class RenderThread
+
+}	// namespace mll
+
+
+//	EOF
@@ -0,0 +1,66 @@
+﻿#pragma once
+
+#include "mll_defines.h"
+
+#include <cassert>
+
+
+namespace mll
+{
+	//-----------------------------------------------------------
+	//! @brief Shadow of one native command list state.
+	//!
+	//! Keeps last value set to native command list, so redundant sets are filtered before driver.
+	//! Invalidate when native state becomes unknown, e.g. command list reset.
+	//-----------------------------------------------------------
+	template <typename T>
+	class ShadowState
+	{
+	public:
+		ShadowState()
+		{}
+
+		/**
+		 * @brief update shadow value.
+		 *
+		 * @return			true if value is changed and native call is required.
+		*/
+		bool Set(const T& v)
+		{
+			if (isValid_ && value_ == v)
+			{
+				return false;
+			}
+			value_ = v;
+			isValid_ = true;
+			return true;
+		}
+
+		/**
+		 * @brief forget shadow value, next Set always requires native call.
+		*/
+		void Invalidate()
+		{
+			isValid_ = false;
+		}
+
+		// getter
+		bool IsValid() const
+		{
+			return isValid_;
+		}
+		const T& Get() const
+		{
+			assert(isValid_);
+			return value_;
+		}
+
+	private:
+		T		value_ = T();
+		bool	isValid_ = false;
+	};	// class ShadowState
+
+}	// namespace mll
+
+
+//	EOF
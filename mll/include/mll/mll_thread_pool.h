@@ -0,0 +1,85 @@
+﻿#pragma once
+
+#include "mll_defines.h"
+#include "mll_allocator.h"
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+
+namespace mll
+{
+	//-----------------------------------------------------------
+	//! @brief worker threads for CPU jobs.
+	//!
+	//! Several queues may run ParallelFor at the same time,
+	//! caller thread also processes its own job while waiting.
+	//-----------------------------------------------------------
+	class ThreadPool
+	{
+		MLL_DECLARE_CLASS_ALLOCATOR(AllocCategory::General);
+
+	public:
+		ThreadPool()
+		{}
+		~ThreadPool()
+		{
+			Destroy();
+		}
+
+		/**
+		 * @brief start worker threads.
+		 *
+		 * @param[in]	threadCount		worker thread count. 0 uses hardware concurrency.
+		*/
+		void Initialize(u32 threadCount);
+		void Destroy();
+
+		/**
+		 * @brief call func(index) for each index in [0, count) and wait all.
+		*/
+		template <typename TFunc>
+		void ParallelFor(u32 count, TFunc func)
+		{
+			Job job;
+			job.pInvoke = [](void* pContext, u32 index) { (*static_cast<TFunc*>(pContext))(index); };
+			job.pContext = &func;
+			job.count = count;
+			Run(job);
+		}
+
+		u32 GetThreadCount() const
+		{
+			return static_cast<u32>(threads_.size());
+		}
+
+	private:
+		struct Job
+		{
+			void	(*pInvoke)(void*, u32) = nullptr;
+			void*	pContext = nullptr;
+			u32		count = 0;
+			std::atomic<u32>	next{ 0 };
+			std::atomic<u32>	done{ 0 };
+			u32		workerCount = 0;		// workers referring this job, guarded by mutex_.
+		};	// struct Job
+
+		void Run(Job& job);
+		void Process(Job& job);
+		void WorkerMain();
+
+	private:
+		std::vector<std::thread>	threads_;
+		std::mutex					mutex_;
+		std::condition_variable		jobCond_;
+		std::condition_variable		doneCond_;
+		std::deque<Job*>			jobs_;
+		bool						exit_ = false;
+	};	// class ThreadPool
+
+}
+//	EOF
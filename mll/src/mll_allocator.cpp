@@ -0,0 +1,310 @@
+﻿#include "../include/mll/mll_defines.h"
+#include "../include/mll/mll_allocator.h"
+
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
+
+
+namespace mll
+{
+	namespace
+	{
+		struct CategoryCounter
+		{
+			std::atomic<u64>	reservedBytes;
+			std::atomic<u64>	usedBytes;
+			std::atomic<u64>	peakUsedBytes;
+			std::atomic<u64>	allocationCount;
+			std::atomic<u64>	totalAllocationCount;
+		};	// struct CategoryCounter
+
+		static AllocatorCallbacks	g_callbacks;
+		static CategoryCounter		g_counters[AllocCategory::MAX];
+
+		void* DefaultAllocate(size_t size, size_t alignment)
+		{
+#ifdef _MSC_VER
+			return _aligned_malloc(size, alignment);
+#else
+			void* ret = nullptr;
+			if (posix_memalign(&ret, std::max(alignment, sizeof(void*)), size) != 0)
+			{
+				return nullptr;
+			}
+			return ret;
+#endif
+		}
+
+		void DefaultFree(void* ptr)
+		{
+#ifdef _MSC_VER
+			_aligned_free(ptr);
+#else
+			free(ptr);
+#endif
+		}
+
+		//! allocate from backing allocator, count as reserved.
+		void* ReserveMemory(size_t size, size_t alignment, AllocCategory::Type category)
+		{
+			void* ret = (g_callbacks.pfnAllocate != nullptr)
+				? g_callbacks.pfnAllocate(g_callbacks.pUserData, size, alignment, category)
+				: DefaultAllocate(size, alignment);
+			if (ret != nullptr)
+			{
+				g_counters[category].reservedBytes.fetch_add(size, std::memory_order_relaxed);
+			}
+			return ret;
+		}
+
+		//! free to backing allocator.
+		void UnreserveMemory(void* ptr, size_t size, AllocCategory::Type category)
+		{
+			if (g_callbacks.pfnFree != nullptr)
+			{
+				g_callbacks.pfnFree(g_callbacks.pUserData, ptr, size, category);
+			}
+			else
+			{
+				DefaultFree(ptr);
+			}
+			g_counters[category].reservedBytes.fetch_sub(size, std::memory_order_relaxed);
+		}
+
+		//! count bytes handed out to users.
+		void RecordUse(size_t size, AllocCategory::Type category)
+		{
+			auto& counter = g_counters[category];
+			auto used = counter.usedBytes.fetch_add(size, std::memory_order_relaxed) + size;
+			counter.allocationCount.fetch_add(1, std::memory_order_relaxed);
+			counter.totalAllocationCount.fetch_add(1, std::memory_order_relaxed);
+
+			auto peak = counter.peakUsedBytes.load(std::memory_order_relaxed);
+			while (peak < used && !counter.peakUsedBytes.compare_exchange_weak(peak, used, std::memory_order_relaxed))
+			{}
+		}
+
+		//! uncount bytes handed out to users.
+		void RecordUnuse(size_t size, AllocCategory::Type category)
+		{
+			auto& counter = g_counters[category];
+			counter.usedBytes.fetch_sub(size, std::memory_order_relaxed);
+			counter.allocationCount.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		size_t AlignUp(size_t v, size_t alignment)
+		{
+			return (v + alignment - 1) & ~(alignment - 1);
+		}
+	}
+
+	//-----------------------------------------------------------
+	// set user allocator callbacks.
+	//-----------------------------------------------------------
+	void SetAllocatorCallbacks(const AllocatorCallbacks& callbacks)
+	{
+		// allocate and free must be replaced together.
+		assert((callbacks.pfnAllocate == nullptr) == (callbacks.pfnFree == nullptr));
+		g_callbacks = callbacks;
+	}
+
+	//-----------------------------------------------------------
+	// allocate memory.
+	//-----------------------------------------------------------
+	void* MemoryAllocate(size_t size, size_t alignment, AllocCategory::Type category)
+	{
+		auto ret = ReserveMemory(size, alignment, category);
+		if (ret != nullptr)
+		{
+			RecordUse(size, category);
+		}
+		return ret;
+	}
+
+	//-----------------------------------------------------------
+	// free memory.
+	//-----------------------------------------------------------
+	void MemoryFree(void* ptr, size_t size, AllocCategory::Type category)
+	{
+		if (ptr == nullptr)
+		{
+			return;
+		}
+		RecordUnuse(size, category);
+		UnreserveMemory(ptr, size, category);
+	}
+
+	//-----------------------------------------------------------
+	// get allocation statistics.
+	//-----------------------------------------------------------
+	void GetAllocatorStats(AllocCategory::Type category, AllocatorStats& outStats)
+	{
+		auto& counter = g_counters[category];
+		outStats.reservedBytes = counter.reservedBytes.load(std::memory_order_relaxed);
+		outStats.usedBytes = counter.usedBytes.load(std::memory_order_relaxed);
+		outStats.peakUsedBytes = counter.peakUsedBytes.load(std::memory_order_relaxed);
+		outStats.allocationCount = counter.allocationCount.load(std::memory_order_relaxed);
+		outStats.totalAllocationCount = counter.totalAllocationCount.load(std::memory_order_relaxed);
+	}
+
+
+	//-----------------------------------------------------------
+	// constructor for fixed size pool.
+	//-----------------------------------------------------------
+	FixedSizePool::FixedSizePool(size_t blockSize, size_t alignment, AllocCategory::Type category, u32 blocksPerPage)
+		: alignment_(std::max(alignment, alignof(FreeBlock)))
+		, blocksPerPage_(blocksPerPage)
+		, category_(category)
+	{
+		blockSize_ = AlignUp(std::max(blockSize, sizeof(FreeBlock)), alignment_);
+	}
+
+	//-----------------------------------------------------------
+	// destructor for fixed size pool.
+	//-----------------------------------------------------------
+	FixedSizePool::~FixedSizePool()
+	{
+		assert(usedCount_ == 0);
+		for (auto&& page : pages_)
+		{
+			UnreserveMemory(page, blockSize_ * blocksPerPage_, category_);
+		}
+		pages_.clear();
+	}
+
+	//-----------------------------------------------------------
+	// allocate one block.
+	//-----------------------------------------------------------
+	void* FixedSizePool::Allocate()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		if (pFreeList_ == nullptr)
+		{
+			// add new page and link all blocks.
+			auto page = static_cast<u8*>(ReserveMemory(blockSize_ * blocksPerPage_, alignment_, category_));
+			if (page == nullptr)
+			{
+				return nullptr;
+			}
+			pages_.push_back(page);
+
+			for (u32 i = blocksPerPage_; i > 0; i--)
+			{
+				auto block = reinterpret_cast<FreeBlock*>(page + blockSize_ * (i - 1));
+				block->pNext = pFreeList_;
+				pFreeList_ = block;
+			}
+		}
+
+		auto ret = pFreeList_;
+		pFreeList_ = ret->pNext;
+		usedCount_++;
+		RecordUse(blockSize_, category_);
+		return ret;
+	}
+
+	//-----------------------------------------------------------
+	// free one block.
+	//-----------------------------------------------------------
+	void FixedSizePool::Free(void* ptr)
+	{
+		if (ptr == nullptr)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		auto block = static_cast<FreeBlock*>(ptr);
+		block->pNext = pFreeList_;
+		pFreeList_ = block;
+		usedCount_--;
+		RecordUnuse(blockSize_, category_);
+	}
+
+
+	//-----------------------------------------------------------
+	// constructor for linear arena.
+	//-----------------------------------------------------------
+	LinearArena::LinearArena(size_t pageSize, AllocCategory::Type category)
+		: pageSize_(pageSize)
+		, category_(category)
+	{}
+
+	//-----------------------------------------------------------
+	// destructor for linear arena.
+	//-----------------------------------------------------------
+	LinearArena::~LinearArena()
+	{
+		Release();
+	}
+
+	//-----------------------------------------------------------
+	// allocate memory from arena.
+	//-----------------------------------------------------------
+	void* LinearArena::Allocate(size_t size, size_t alignment)
+	{
+		while (currentPage_ < pages_.size())
+		{
+			auto& page = pages_[currentPage_];
+			auto offset = AlignUp(reinterpret_cast<size_t>(page.pMemory) + offset_, alignment) - reinterpret_cast<size_t>(page.pMemory);
+			if (offset + size <= page.size)
+			{
+				offset_ = offset + size;
+				usedBytes_ += size;
+				return page.pMemory + offset;
+			}
+
+			// try next page.
+			currentPage_++;
+			offset_ = 0;
+		}
+
+		// add new page, large allocation has its own page.
+		Page page;
+		page.size = std::max(pageSize_, AlignUp(size, kDefaultAllocAlignment));
+		page.pMemory = static_cast<u8*>(ReserveMemory(page.size, std::max(alignment, kDefaultAllocAlignment), category_));
+		if (page.pMemory == nullptr)
+		{
+			return nullptr;
+		}
+		RecordUse(page.size, category_);
+		reservedBytes_ += page.size;
+		pages_.push_back(page);
+		currentPage_ = static_cast<u32>(pages_.size() - 1);
+
+		offset_ = size;
+		usedBytes_ += size;
+		return page.pMemory;
+	}
+
+	//-----------------------------------------------------------
+	// release all allocations.
+	//-----------------------------------------------------------
+	void LinearArena::Reset()
+	{
+		currentPage_ = 0;
+		offset_ = 0;
+		usedBytes_ = 0;
+	}
+
+	//-----------------------------------------------------------
+	// release all pages.
+	//-----------------------------------------------------------
+	void LinearArena::Release()
+	{
+		for (auto&& page : pages_)
+		{
+			MemoryFree(page.pMemory, page.size, category_);
+		}
+		pages_.clear();
+		reservedBytes_ = 0;
+		Reset();
+	}
+
+}	// namespace mll
+
+
+//	EOF
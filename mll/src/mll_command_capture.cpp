@@ -0,0 +1,658 @@
+﻿#include "../include/mll/mll_defines.h"
+#include "../include/mll/mll_command_capture.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#if defined(_WIN32)
+#	ifndef WIN32_LEAN_AND_MEAN
+#		define WIN32_LEAN_AND_MEAN
+#	endif
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+
+namespace mll
+{
+	namespace
+	{
+		static const u32	kCaptureMagic = 0x434c4c4d;		// 'MLLC'
+		static const u32	kCaptureVersion = 1;
+		static const size_t	kCaptureRecordAlign = 8;
+
+		inline constexpr size_t AlignSize(size_t size, size_t align)
+		{
+			return (size + align - 1) & ~(align - 1);
+		}
+
+		// texture index is kept in texture pointer field.
+		inline ITexture* IndexToPointer(u32 index)
+		{
+			return reinterpret_cast<ITexture*>(static_cast<uintptr_t>(index));
+		}
+		inline u32 PointerToIndex(const ITexture* p)
+		{
+			return static_cast<u32>(reinterpret_cast<uintptr_t>(p));
+		}
+
+		// enum fields of file are read as integers, compiler may assume enum values are in range.
+		template <typename T>
+		inline u32 ReadEnum(const T& value)
+		{
+			static_assert(sizeof(T) == sizeof(u32), "enum field must be 32 bits.");
+			u32 ret;
+			memcpy(&ret, &value, sizeof(ret));
+			return ret;
+		}
+
+		inline u32 GetSubresourceCount(const TextureDesc& desc)
+		{
+			u32 array_size = (desc.dimension != ResourceDimension::Texture3D && desc.arraySize > 0) ? desc.arraySize : 1;
+			u32 mip_levels = (desc.mipLevels > 0) ? desc.mipLevels : 1;
+			return array_size * mip_levels;
+		}
+
+		// check packet type, size, texture indices and subresources. bundles are flattened by writer.
+		bool ValidatePacket(const CommandPacketHeader& header, const std::vector<u32>& subresourceCounts)
+		{
+			auto is_texture = [&](const ITexture* p, u32 subresource)
+			{
+				auto index = reinterpret_cast<uintptr_t>(p);
+				return index < subresourceCounts.size() && subresource < subresourceCounts[index];
+			};
+
+			switch (ReadEnum(header.type))
+			{
+			case CommandPacketType::ClearTexture:
+				{
+					if (header.size < sizeof(ClearTexturePacket))
+					{
+						return false;
+					}
+					auto&& packet = CommandStream::Cast<ClearTexturePacket>(header);
+					return is_texture(packet.pTexture, packet.subresource);
+				}
+			case CommandPacketType::CopyTexture:
+				{
+					if (header.size < sizeof(CopyTexturePacket))
+					{
+						return false;
+					}
+					auto&& packet = CommandStream::Cast<CopyTexturePacket>(header);
+					return is_texture(packet.pDst, packet.dstSubresource) && is_texture(packet.pSrc, packet.srcSubresource);
+				}
+			case CommandPacketType::ResolveTexture:
+				{
+					if (header.size < sizeof(ResolveTexturePacket))
+					{
+						return false;
+					}
+					auto&& packet = CommandStream::Cast<ResolveTexturePacket>(header);
+					return is_texture(packet.pDst, packet.dstSubresource) && is_texture(packet.pSrc, packet.srcSubresource);
+				}
+			default:
+				return false;
+			}
+		}
+
+		// check nested lists and packets fill submit record exactly.
+		bool ValidateSubmitRecord(const CaptureSubmitRecord& record, const std::vector<u32>& subresourceCounts)
+		{
+			if (record.header.size < sizeof(CaptureSubmitRecord) || ReadEnum(record.queueType) >= CommandQueueType::MAX)
+			{
+				return false;
+			}
+
+			auto p = reinterpret_cast<const u8*>(&record) + sizeof(CaptureSubmitRecord);
+			size_t remain = record.header.size - sizeof(CaptureSubmitRecord);
+			for (u32 i = 0; i < record.listCount; i++)
+			{
+				if (remain < sizeof(CaptureListRecord))
+				{
+					return false;
+				}
+				auto&& list = *reinterpret_cast<const CaptureListRecord*>(p);
+				p += sizeof(CaptureListRecord);
+				remain -= sizeof(CaptureListRecord);
+				if (list.packetBytes > remain)
+				{
+					return false;
+				}
+
+				size_t list_remain = list.packetBytes;
+				for (u32 j = 0; j < list.packetCount; j++)
+				{
+					if (list_remain < sizeof(CommandPacketHeader))
+					{
+						return false;
+					}
+					auto&& header = *reinterpret_cast<const CommandPacketHeader*>(p);
+					if (header.size < sizeof(CommandPacketHeader)
+						|| header.size % kCaptureRecordAlign != 0
+						|| header.size > list_remain
+						|| !ValidatePacket(header, subresourceCounts))
+					{
+						return false;
+					}
+					p += header.size;
+					list_remain -= header.size;
+				}
+				if (list_remain != 0)
+				{
+					return false;
+				}
+				remain -= list.packetBytes;
+			}
+			return remain == 0;
+		}
+	}
+
+
+	//-----------------------------------------------------------
+	// map whole file.
+	//-----------------------------------------------------------
+	Result::Type MappedFile::Open(const char* path)
+	{
+		Close();
+
+		if (path == nullptr || path[0] == '\0')
+		{
+			return Result::InvalidArgs;
+		}
+
+#if defined(_WIN32)
+		auto file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return Result::InvalidOperation;
+		}
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0)
+		{
+			CloseHandle(file);
+			return Result::InvalidOperation;
+		}
+		auto handle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (handle == nullptr)
+		{
+			return Result::InvalidOperation;
+		}
+		auto p = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0);
+		if (p == nullptr)
+		{
+			CloseHandle(handle);
+			return Result::InvalidOperation;
+		}
+		handle_ = handle;
+		size_ = static_cast<size_t>(file_size.QuadPart);
+#else
+		int fd = open(path, O_RDONLY);
+		if (fd < 0)
+		{
+			return Result::InvalidOperation;
+		}
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size <= 0)
+		{
+			close(fd);
+			return Result::InvalidOperation;
+		}
+		auto p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (p == MAP_FAILED)
+		{
+			return Result::InvalidOperation;
+		}
+		size_ = static_cast<size_t>(st.st_size);
+#endif
+
+		pMemory_ = static_cast<const u8*>(p);
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// unmap file.
+	//-----------------------------------------------------------
+	void MappedFile::Close()
+	{
+		if (pMemory_ == nullptr)
+		{
+			return;
+		}
+
+#if defined(_WIN32)
+		UnmapViewOfFile(pMemory_);
+		CloseHandle(static_cast<HANDLE>(handle_));
+		handle_ = nullptr;
+#else
+		munmap(const_cast<u8*>(pMemory_), size_);
+#endif
+
+		pMemory_ = nullptr;
+		size_ = 0;
+	}
+
+
+	//-----------------------------------------------------------
+	// create capture file.
+	//-----------------------------------------------------------
+	Result::Type CommandCaptureWriter::Open(const char* path)
+	{
+		Close();
+
+		if (path == nullptr || path[0] == '\0')
+		{
+			return Result::InvalidArgs;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		pFile_ = fopen(path, "wb");
+		if (pFile_ == nullptr)
+		{
+			return Result::InvalidOperation;
+		}
+
+		header_ = CaptureFileHeader();
+		header_.magic = kCaptureMagic;
+		header_.version = kCaptureVersion;
+		header_.pointerSize = static_cast<u32>(sizeof(void*));
+
+		// header is rewritten on Close.
+		Write(&header_, sizeof(header_));
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// write file header and close file.
+	//-----------------------------------------------------------
+	void CommandCaptureWriter::Close()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		if (pFile_ == nullptr)
+		{
+			return;
+		}
+
+		fseek(pFile_, 0, SEEK_SET);
+		Write(&header_, sizeof(header_));
+		fclose(pFile_);
+		pFile_ = nullptr;
+
+		textureIndices_.clear();
+	}
+
+	//-----------------------------------------------------------
+	// write texture creation record.
+	//-----------------------------------------------------------
+	void CommandCaptureWriter::WriteTexture(const ITexture* pTexture)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		if (pFile_ != nullptr)
+		{
+			WriteTextureUnlocked(pTexture);
+		}
+	}
+
+	//-----------------------------------------------------------
+	// write recorded streams of submitted command lists.
+	//-----------------------------------------------------------
+	void CommandCaptureWriter::WriteSubmit(CommandQueueType::Type type, ICommandList* const* ppCmdLists, u32 count)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		if (pFile_ == nullptr || count == 0)
+		{
+			return;
+		}
+
+		// remap packets first, so texture records of first references are written before submission.
+		packetBuffer_.clear();
+		for (u32 i = 0; i < count; i++)
+		{
+			auto&& stream = ppCmdLists[i]->GetCommandStream();
+
+			size_t list_offset = packetBuffer_.size();
+			packetBuffer_.resize(list_offset + sizeof(CaptureListRecord));
+
+			CaptureListRecord list = {};
+			AppendPackets(stream, list);
+			memcpy(packetBuffer_.data() + list_offset, &list, sizeof(list));
+
+			header_.packetCount += list.packetCount;
+		}
+
+		CaptureSubmitRecord record;
+		record.header.type = CaptureRecordType::Submit;
+		record.header.size = static_cast<u32>(sizeof(record) + packetBuffer_.size());
+		record.queueType = type;
+		record.listCount = count;
+		Write(&record, sizeof(record));
+		Write(packetBuffer_.data(), packetBuffer_.size());
+
+		header_.submitCount++;
+		header_.listCount += count;
+		header_.recordBytes += record.header.size;
+	}
+
+	//-----------------------------------------------------------
+	// append remapped packets to buffer, bundles are flattened.
+	//-----------------------------------------------------------
+	void CommandCaptureWriter::AppendPackets(const CommandStream& stream, CaptureListRecord& list)
+	{
+		stream.ForEach([&](const CommandPacketHeader& header)
+		{
+			if (header.type == CommandPacketType::ExecuteBundle)
+			{
+				AppendPackets(CommandStream::Cast<ExecuteBundlePacket>(header).pBundle->GetCommandStream(), list);
+				return;
+			}
+
+			assert(header.size % kCaptureRecordAlign == 0);
+
+			size_t offset = packetBuffer_.size();
+			packetBuffer_.resize(offset + header.size);
+			auto p_packet = reinterpret_cast<CommandPacketHeader*>(packetBuffer_.data() + offset);
+			memcpy(p_packet, &header, header.size);
+
+			p_packet->pNext = nullptr;
+			ForEachPacketTexture(*p_packet, [&](ITexture*& pTexture)
+			{
+				pTexture = IndexToPointer(WriteTextureUnlocked(pTexture));
+			});
+			list.packetCount++;
+			list.packetBytes += header.size;
+		});
+	}
+
+	//-----------------------------------------------------------
+	// write texture creation record and return texture index.
+	//-----------------------------------------------------------
+	u32 CommandCaptureWriter::WriteTextureUnlocked(const ITexture* pTexture)
+	{
+		assert(pTexture != nullptr);
+
+		auto it = textureIndices_.find(pTexture->GetObjectId());
+		if (it != textureIndices_.end())
+		{
+			return it->second;
+		}
+
+		alignas(kCaptureRecordAlign) u8 data[AlignSize(sizeof(CaptureCreateTextureRecord), kCaptureRecordAlign)] = {};
+		auto p_record = reinterpret_cast<CaptureCreateTextureRecord*>(data);
+		p_record->header.type = CaptureRecordType::CreateTexture;
+		p_record->header.size = static_cast<u32>(sizeof(data));
+		p_record->textureIndex = header_.textureCount;
+		p_record->desc = pTexture->GetDesc();
+		Write(data, sizeof(data));
+
+		header_.recordBytes += sizeof(data);
+		textureIndices_[pTexture->GetObjectId()] = header_.textureCount;
+		return header_.textureCount++;
+	}
+
+	//-----------------------------------------------------------
+	// write to file.
+	//-----------------------------------------------------------
+	void CommandCaptureWriter::Write(const void* pData, size_t size)
+	{
+		auto written = fwrite(pData, 1, size, pFile_);
+		assert(written == size);
+		(void)written;
+	}
+
+
+	//-----------------------------------------------------------
+	// map and validate capture file.
+	//-----------------------------------------------------------
+	Result::Type CommandCaptureReplay::Open(const char* path)
+	{
+		Close();
+
+		auto result = file_.Open(path);
+		if (IsFailed(result))
+		{
+			return result;
+		}
+
+		// validate whole file once, Replay trusts records.
+		auto p_memory = file_.GetMemory();
+		auto size = file_.GetSize();
+		auto&& header = *reinterpret_cast<const CaptureFileHeader*>(p_memory);
+		if (size < sizeof(CaptureFileHeader)
+			|| header.magic != kCaptureMagic
+			|| header.version != kCaptureVersion
+			|| header.pointerSize != sizeof(void*)
+			|| header.recordBytes > size - sizeof(CaptureFileHeader))
+		{
+			file_.Close();
+			return Result::InvalidArgs;
+		}
+
+		u64 offset = 0;
+		std::vector<u32> subresource_counts;		// of textures written so far.
+		while (offset < header.recordBytes)
+		{
+			auto p_record = p_memory + sizeof(CaptureFileHeader) + offset;
+			auto&& record = *reinterpret_cast<const CaptureRecordHeader*>(p_record);
+			bool valid = header.recordBytes - offset >= sizeof(CaptureRecordHeader)
+				&& record.size >= sizeof(CaptureRecordHeader)
+				&& record.size % kCaptureRecordAlign == 0
+				&& record.size <= header.recordBytes - offset;
+			if (valid && ReadEnum(record.type) == CaptureRecordType::CreateTexture)
+			{
+				auto&& create = *reinterpret_cast<const CaptureCreateTextureRecord*>(p_record);
+				valid = record.size >= sizeof(CaptureCreateTextureRecord)
+					&& create.textureIndex == subresource_counts.size();
+				if (valid)
+				{
+					subresource_counts.push_back(GetSubresourceCount(create.desc));
+				}
+			}
+			else if (valid && ReadEnum(record.type) == CaptureRecordType::Submit)
+			{
+				// textures are written before their first submission.
+				valid = ValidateSubmitRecord(*reinterpret_cast<const CaptureSubmitRecord*>(p_record), subresource_counts);
+			}
+			else
+			{
+				valid = false;
+			}
+			if (!valid)
+			{
+				file_.Close();
+				return Result::InvalidArgs;
+			}
+			offset += record.size;
+		}
+		if (subresource_counts.size() != header.textureCount)
+		{
+			file_.Close();
+			return Result::InvalidArgs;
+		}
+
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// release replay objects and unmap file.
+	//-----------------------------------------------------------
+	void CommandCaptureReplay::Close()
+	{
+		ReleaseObjects();
+		file_.Close();
+	}
+
+	//-----------------------------------------------------------
+	// create captured textures and command lists.
+	//-----------------------------------------------------------
+	Result::Type CommandCaptureReplay::Prepare(IDevice* pDevice)
+	{
+		assert(file_.GetMemory() != nullptr);
+		assert(pDevice != nullptr);
+
+		ReleaseObjects();
+		pDevice_ = pDevice;
+
+		textures_.resize(GetHeader().textureCount);
+
+		u32 list_counts[CommandQueueType::MAX] = {};
+		Result::Type result = Result::Ok;
+		ForEachRecord([&](const CaptureRecordHeader& record)
+		{
+			if (IsFailed(result))
+			{
+				return;
+			}
+			if (record.type == CaptureRecordType::CreateTexture)
+			{
+				auto&& create = reinterpret_cast<const CaptureCreateTextureRecord&>(record);
+				result = pDevice_->CreateTexture(create.desc, textures_[create.textureIndex]);
+			}
+			else
+			{
+				auto&& submit = reinterpret_cast<const CaptureSubmitRecord&>(record);
+				list_counts[submit.queueType] = std::max(list_counts[submit.queueType], submit.listCount);
+			}
+		});
+
+		for (u32 type = 0; type < CommandQueueType::MAX && IsSucceeded(result); type++)
+		{
+			cmdLists_[type].resize(list_counts[type]);
+			submitLists_[type].resize(list_counts[type]);
+			for (u32 i = 0; i < list_counts[type] && IsSucceeded(result); i++)
+			{
+				CommandListDesc desc;
+				desc.SetCommandQueueType(static_cast<CommandQueueType::Type>(type));
+				result = pDevice_->CreateCommandList(desc, cmdLists_[type][i]);
+				submitLists_[type][i] = cmdLists_[type][i];
+			}
+		}
+
+		if (IsFailed(result))
+		{
+			ReleaseObjects();
+		}
+		return result;
+	}
+
+	//-----------------------------------------------------------
+	// record and submit all captured command lists.
+	//-----------------------------------------------------------
+	SubmitTicket CommandCaptureReplay::Replay()
+	{
+		assert(pDevice_ != nullptr);
+
+		SubmitTicket ticket;
+		ForEachRecord([&](const CaptureRecordHeader& record)
+		{
+			if (record.type != CaptureRecordType::Submit)
+			{
+				return;
+			}
+
+			auto&& submit = reinterpret_cast<const CaptureSubmitRecord&>(record);
+			auto p = reinterpret_cast<const u8*>(&submit) + sizeof(CaptureSubmitRecord);
+			for (u32 i = 0; i < submit.listCount; i++)
+			{
+				auto&& list = *reinterpret_cast<const CaptureListRecord*>(p);
+				p += sizeof(CaptureListRecord);
+				RecordPackets(cmdLists_[submit.queueType][i], p, list.packetCount);
+				p += list.packetBytes;
+			}
+			ticket = pDevice_->Submit(submit.queueType, submitLists_[submit.queueType].data(), submit.listCount);
+		});
+		return ticket;
+	}
+
+	//-----------------------------------------------------------
+	// release objects created by Prepare.
+	//-----------------------------------------------------------
+	void CommandCaptureReplay::ReleaseObjects()
+	{
+		for (auto&& lists : cmdLists_)
+		{
+			lists.clear();
+		}
+		for (auto&& lists : submitLists_)
+		{
+			lists.clear();
+		}
+		textures_.clear();
+		pDevice_ = nullptr;
+	}
+
+	//-----------------------------------------------------------
+	// call func(const CaptureRecordHeader&) for all records.
+	//-----------------------------------------------------------
+	template <typename TFunc>
+	void CommandCaptureReplay::ForEachRecord(TFunc func) const
+	{
+		auto p = file_.GetMemory() + sizeof(CaptureFileHeader);
+		auto p_end = p + GetHeader().recordBytes;
+		while (p < p_end)
+		{
+			auto&& record = *reinterpret_cast<const CaptureRecordHeader*>(p);
+			func(record);
+			p += record.size;
+		}
+	}
+
+	//-----------------------------------------------------------
+	// record captured packets through command list interface.
+	//-----------------------------------------------------------
+	void CommandCaptureReplay::RecordPackets(ICommandList* pCmdList, const u8* pPackets, u32 packetCount)
+	{
+		auto texture = [&](const ITexture* p) -> ITexture*
+		{
+			auto index = PointerToIndex(p);
+			assert(index < textures_.size());
+			return textures_[index];
+		};
+
+		pCmdList->Begin();
+		for (u32 i = 0; i < packetCount; i++)
+		{
+			auto&& header = *reinterpret_cast<const CommandPacketHeader*>(pPackets);
+			switch (header.type)
+			{
+			case CommandPacketType::ClearTexture:
+				{
+					auto&& packet = CommandStream::Cast<ClearTexturePacket>(header);
+					pCmdList->ClearTexture(texture(packet.pTexture), packet.subresource, packet.color);
+				}
+				break;
+			case CommandPacketType::CopyTexture:
+				{
+					auto&& packet = CommandStream::Cast<CopyTexturePacket>(header);
+					pCmdList->CopyTexture(texture(packet.pDst), packet.dstSubresource, texture(packet.pSrc), packet.srcSubresource);
+				}
+				break;
+			case CommandPacketType::ResolveTexture:
+				{
+					auto&& packet = CommandStream::Cast<ResolveTexturePacket>(header);
+					pCmdList->ResolveTexture(texture(packet.pDst), packet.dstSubresource, texture(packet.pSrc), packet.srcSubresource);
+				}
+				break;
+			default:
+				assert(!"unknown command packet.");
+				break;
+			}
+			pPackets += header.size;
+		}
+		pCmdList->End();
+	}
+
+}	// namespace mll
+
+
+//	EOF
@@ -0,0 +1,162 @@
+﻿#include "../include/mll/mll_defines.h"
+#include "../include/mll/mll_command_sort.h"
+#include "../include/mll/mll_interfaces.h"
+#include "../include/mll/mll_thread_pool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+
+namespace mll
+{
+	namespace
+	{
+		static const u32	kRadixBits = 8;
+		static const u32	kRadixSize = 1 << kRadixBits;
+		static const u32	kParallelSortMinCount = 16 * 1024;		// smaller sorts run on caller thread.
+		static const u32	kMaxSortChunks = 64;
+
+		inline u32 GetDigit(u64 key, u32 shift)
+		{
+			return static_cast<u32>(key >> shift) & (kRadixSize - 1);
+		}
+	}
+
+
+	//-----------------------------------------------------------
+	// sort items by key.
+	//-----------------------------------------------------------
+	void RadixSorter::Sort(SortItem* pItems, u32 count, ThreadPool* pThreadPool)
+	{
+		if (count < 2)
+		{
+			return;
+		}
+
+		// caller thread processes jobs too.
+		u32 chunk_count = 1;
+		if (pThreadPool != nullptr && count >= kParallelSortMinCount)
+		{
+			chunk_count = std::min(pThreadPool->GetThreadCount() + 1, kMaxSortChunks);
+		}
+		u32 chunk_size = (count + chunk_count - 1) / chunk_count;
+
+		auto run = [&](auto func)
+		{
+			if (chunk_count == 1)
+			{
+				func(0);
+			}
+			else
+			{
+				pThreadPool->ParallelFor(chunk_count, func);
+			}
+		};
+		auto chunk_range = [&](u32 chunk, u32& outBegin, u32& outEnd)
+		{
+			outBegin = std::min(chunk * chunk_size, count);
+			outEnd = std::min(outBegin + chunk_size, count);
+		};
+
+		if (scratch_.size() < count)
+		{
+			scratch_.resize(count);
+		}
+		histograms_.resize(chunk_count * kRadixSize);
+		keyBits_.resize(chunk_count * 2);
+
+		// find key bits which differ between items, digits without them are skipped.
+		run([&](u32 chunk)
+		{
+			u32 begin, end;
+			chunk_range(chunk, begin, end);
+			u64 bits_or = 0, bits_and = ~0ull;
+			for (u32 i = begin; i < end; i++)
+			{
+				bits_or |= pItems[i].key;
+				bits_and &= pItems[i].key;
+			}
+			keyBits_[chunk * 2 + 0] = bits_or;
+			keyBits_[chunk * 2 + 1] = bits_and;
+		});
+		u64 bits_or = 0, bits_and = ~0ull;
+		for (u32 chunk = 0; chunk < chunk_count; chunk++)
+		{
+			bits_or |= keyBits_[chunk * 2 + 0];
+			bits_and &= keyBits_[chunk * 2 + 1];
+		}
+		u64 varying_bits = bits_or ^ bits_and;
+
+		SortItem* p_src = pItems;
+		SortItem* p_dst = scratch_.data();
+		for (u32 shift = 0; shift < 64; shift += kRadixBits)
+		{
+			if (GetDigit(varying_bits, shift) == 0)
+			{
+				continue;
+			}
+
+			// count digits per chunk.
+			run([&](u32 chunk)
+			{
+				u32 begin, end;
+				chunk_range(chunk, begin, end);
+				u32* p_hist = histograms_.data() + chunk * kRadixSize;
+				memset(p_hist, 0, sizeof(u32) * kRadixSize);
+				for (u32 i = begin; i < end; i++)
+				{
+					p_hist[GetDigit(p_src[i].key, shift)]++;
+				}
+			});
+
+			// exclusive prefix sum in digit major, chunk minor order keeps sort stable.
+			u32 offset = 0;
+			for (u32 digit = 0; digit < kRadixSize; digit++)
+			{
+				for (u32 chunk = 0; chunk < chunk_count; chunk++)
+				{
+					u32& h = histograms_[chunk * kRadixSize + digit];
+					u32 n = h;
+					h = offset;
+					offset += n;
+				}
+			}
+
+			// scatter.
+			run([&](u32 chunk)
+			{
+				u32 begin, end;
+				chunk_range(chunk, begin, end);
+				u32* p_offset = histograms_.data() + chunk * kRadixSize;
+				for (u32 i = begin; i < end; i++)
+				{
+					p_dst[p_offset[GetDigit(p_src[i].key, shift)]++] = p_src[i];
+				}
+			});
+
+			std::swap(p_src, p_dst);
+		}
+
+		if (p_src != pItems)
+		{
+			memcpy(pItems, p_src, sizeof(SortItem) * count);
+		}
+	}
+
+
+	//-----------------------------------------------------------
+	// record packets to command list in current order.
+	//-----------------------------------------------------------
+	void SortedCommandQueue::Record(ICommandList* pCmdList) const
+	{
+		for (auto&& item : items_)
+		{
+			pCmdList->RecordPacket(GetPacket(item));
+		}
+	}
+
+}	// namespace mll
+
+
+//	EOF
@@ -0,0 +1,565 @@
+﻿#include "../include/mll/mll_defines.h"
+#include "../include/mll/mll_frame_ring.h"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#if defined(_WIN32)
+#	ifndef WIN32_LEAN_AND_MEAN
+#		define WIN32_LEAN_AND_MEAN
+#	endif
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+// slot states are shared with other processes, address free atomics are required.
+#if ATOMIC_LLONG_LOCK_FREE != 2
+#	error "frame ring requires lock free 64bit atomics."
+#endif
+
+
+namespace mll
+{
+	namespace
+	{
+		static const u32	kFrameRingMagic = 0x474e5246;		// 'FRNG'
+		static const u32	kFrameRingVersion = 1;
+		static const size_t	kFrameRingCacheLine = 64;
+		static const size_t	kFrameRingFrameAlign = 4096;
+
+		//-----------------------------------------------------------
+		//! @brief slot status, stored in low 2 bits of slot state.
+		//-----------------------------------------------------------
+		MLL_ENUM_START(SlotStatus)
+			Free,
+			Writing,
+			Ready,
+			Reading,
+		MLL_ENUM_END;
+
+		//-----------------------------------------------------------
+		//! @brief frame ring header at top of shared memory.
+		//-----------------------------------------------------------
+		struct FrameRingHeader
+		{
+			std::atomic<u32>	magic;
+			u32					version;
+			u32					width;
+			u32					height;
+			u32					rowPitch;
+			u32					format;
+			u32					depth;
+			u32					policy;
+			u64					frameBytes;
+			u64					slotOffset;
+			u64					dataOffset;
+			u64					totalBytes;
+
+			alignas(64) std::atomic<u64>	publishedCount;
+			std::atomic<u64>				droppedCount;
+		};	// struct FrameRingHeader
+
+		//-----------------------------------------------------------
+		//! @brief slot state, one cache line per slot.
+		//-----------------------------------------------------------
+		struct alignas(64) FrameRingSlot
+		{
+			std::atomic<u64>	state;		// sequence << 2 | status.
+		};	// struct FrameRingSlot
+
+		static_assert(sizeof(FrameRingSlot) == kFrameRingCacheLine, "frame ring slot must be one cache line.");
+
+		inline u64 MakeSlotState(u64 sequence, SlotStatus::Type status)
+		{
+			return (sequence << 2) | status;
+		}
+		inline u64 GetSlotSequence(u64 state)
+		{
+			return state >> 2;
+		}
+		inline SlotStatus::Type GetSlotStatus(u64 state)
+		{
+			return static_cast<SlotStatus::Type>(state & 0x3);
+		}
+
+		inline size_t AlignSize(size_t size, size_t align)
+		{
+			return (size + align - 1) & ~(align - 1);
+		}
+
+		inline FrameRingHeader* GetHeader(const SharedMemory& memory)
+		{
+			return reinterpret_cast<FrameRingHeader*>(memory.GetMemory());
+		}
+		inline FrameRingSlot* GetSlots(const SharedMemory& memory)
+		{
+			return reinterpret_cast<FrameRingSlot*>(memory.GetMemory() + GetHeader(memory)->slotOffset);
+		}
+
+		//-----------------------------------------------------------
+		// back off while the other side holds slots.
+		//-----------------------------------------------------------
+		void WaitSlot(u32& spinCount)
+		{
+			if (++spinCount < 64)
+			{
+				std::this_thread::yield();
+			}
+			else
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(100));
+			}
+		}
+
+		//-----------------------------------------------------------
+		// make platform shared memory name.
+		//-----------------------------------------------------------
+		bool MakeSharedMemoryName(const char* name, char* outName, size_t size)
+		{
+			if (name == nullptr || name[0] == '\0')
+			{
+				return false;
+			}
+#if defined(_WIN32)
+			int len = snprintf(outName, size, "%s", name);
+#else
+			// POSIX names start with one slash.
+			int len = snprintf(outName, size, "%s%s", (name[0] == '/') ? "" : "/", name);
+#endif
+			return len > 0 && static_cast<size_t>(len) < size;
+		}
+	}
+
+
+	//-----------------------------------------------------------
+	// create shared memory.
+	//-----------------------------------------------------------
+	Result::Type SharedMemory::Create(const char* name, size_t size)
+	{
+		Close();
+
+		if (size == 0 || !MakeSharedMemoryName(name, name_, sizeof(name_)))
+		{
+			return Result::InvalidArgs;
+		}
+
+#if defined(_WIN32)
+		auto handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+			static_cast<DWORD>(static_cast<u64>(size) >> 32), static_cast<DWORD>(size), name_);
+		if (handle == nullptr)
+		{
+			return Result::InvalidOperation;
+		}
+		if (GetLastError() == ERROR_ALREADY_EXISTS)
+		{
+			// mapping is alive while other process opens it.
+			CloseHandle(handle);
+			return Result::InvalidOperation;
+		}
+		auto p = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+		if (p == nullptr)
+		{
+			CloseHandle(handle);
+			return Result::InvalidOperation;
+		}
+		handle_ = handle;
+#else
+		// stale memory left by crashed process is replaced.
+		shm_unlink(name_);
+		int fd = shm_open(name_, O_CREAT | O_EXCL | O_RDWR, 0600);
+		if (fd < 0)
+		{
+			return Result::InvalidOperation;
+		}
+		if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+		{
+			close(fd);
+			shm_unlink(name_);
+			return Result::OutOfMemory;
+		}
+		auto p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+		if (p == MAP_FAILED)
+		{
+			shm_unlink(name_);
+			return Result::OutOfMemory;
+		}
+#endif
+
+		pMemory_ = static_cast<u8*>(p);
+		size_ = size;
+		isOwner_ = true;
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// open shared memory.
+	//-----------------------------------------------------------
+	Result::Type SharedMemory::Open(const char* name)
+	{
+		Close();
+
+		if (!MakeSharedMemoryName(name, name_, sizeof(name_)))
+		{
+			return Result::InvalidArgs;
+		}
+
+#if defined(_WIN32)
+		auto handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name_);
+		if (handle == nullptr)
+		{
+			return Result::InvalidOperation;
+		}
+		auto p = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+		if (p == nullptr)
+		{
+			CloseHandle(handle);
+			return Result::InvalidOperation;
+		}
+		MEMORY_BASIC_INFORMATION info;
+		VirtualQuery(p, &info, sizeof(info));
+		handle_ = handle;
+		size_ = static_cast<size_t>(info.RegionSize);
+#else
+		int fd = shm_open(name_, O_RDWR, 0);
+		if (fd < 0)
+		{
+			return Result::InvalidOperation;
+		}
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size <= 0)
+		{
+			close(fd);
+			return Result::InvalidOperation;
+		}
+		auto p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+		if (p == MAP_FAILED)
+		{
+			return Result::InvalidOperation;
+		}
+		size_ = static_cast<size_t>(st.st_size);
+#endif
+
+		pMemory_ = static_cast<u8*>(p);
+		isOwner_ = false;
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// close shared memory.
+	//-----------------------------------------------------------
+	void SharedMemory::Close()
+	{
+		if (pMemory_ == nullptr)
+		{
+			return;
+		}
+
+#if defined(_WIN32)
+		UnmapViewOfFile(pMemory_);
+		CloseHandle(static_cast<HANDLE>(handle_));
+		handle_ = nullptr;
+#else
+		munmap(pMemory_, size_);
+		if (isOwner_)
+		{
+			// mapped processes keep memory until they unmap.
+			shm_unlink(name_);
+		}
+#endif
+
+		pMemory_ = nullptr;
+		size_ = 0;
+		isOwner_ = false;
+	}
+
+
+	//-----------------------------------------------------------
+	// create frame ring.
+	//-----------------------------------------------------------
+	Result::Type FrameRingWriter::Create(const FrameRingDesc& desc)
+	{
+		Destroy();
+
+		if (desc.depth < 2 || desc.width == 0 || desc.height == 0 || desc.rowPitch == 0 || desc.policy >= FrameRingPolicy::MAX)
+		{
+			return Result::InvalidArgs;
+		}
+
+		size_t slot_offset = AlignSize(sizeof(FrameRingHeader), kFrameRingCacheLine);
+		size_t data_offset = AlignSize(slot_offset + sizeof(FrameRingSlot) * desc.depth, kFrameRingFrameAlign);
+		size_t frame_bytes = AlignSize(static_cast<size_t>(desc.rowPitch) * desc.height, kFrameRingFrameAlign);
+		size_t total_bytes = data_offset + frame_bytes * desc.depth;
+
+		auto result = memory_.Create(desc.name, total_bytes);
+		if (result != Result::Ok)
+		{
+			return result;
+		}
+
+		auto p_header = new(memory_.GetMemory()) FrameRingHeader();
+		p_header->width = desc.width;
+		p_header->height = desc.height;
+		p_header->rowPitch = desc.rowPitch;
+		p_header->format = desc.format;
+		p_header->depth = desc.depth;
+		p_header->policy = desc.policy;
+		p_header->frameBytes = frame_bytes;
+		p_header->slotOffset = slot_offset;
+		p_header->dataOffset = data_offset;
+		p_header->totalBytes = total_bytes;
+		p_header->publishedCount.store(0, std::memory_order_relaxed);
+		p_header->droppedCount.store(0, std::memory_order_relaxed);
+
+		auto p_slots = reinterpret_cast<FrameRingSlot*>(memory_.GetMemory() + slot_offset);
+		for (u32 i = 0; i < desc.depth; i++)
+		{
+			new(&p_slots[i]) FrameRingSlot();
+			p_slots[i].state.store(MakeSlotState(0, SlotStatus::Free), std::memory_order_relaxed);
+		}
+
+		// producer owns first slot.
+		currentSlot_ = 0;
+		sequence_ = 0;
+		p_slots[0].state.store(MakeSlotState(0, SlotStatus::Writing), std::memory_order_relaxed);
+
+		// header is visible to reader after magic.
+		p_header->version = kFrameRingVersion;
+		p_header->magic.store(kFrameRingMagic, std::memory_order_release);
+
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// destroy frame ring.
+	//-----------------------------------------------------------
+	void FrameRingWriter::Destroy()
+	{
+		memory_.Close();
+		currentSlot_ = 0;
+		sequence_ = 0;
+	}
+
+	//-----------------------------------------------------------
+	// publish current slot.
+	//-----------------------------------------------------------
+	u32 FrameRingWriter::Publish()
+	{
+		assert(memory_.GetMemory() != nullptr);
+
+		auto p_header = GetHeader(memory_);
+		auto p_slots = GetSlots(memory_);
+
+		sequence_++;
+		p_slots[currentSlot_].state.store(MakeSlotState(sequence_, SlotStatus::Ready), std::memory_order_release);
+		p_header->publishedCount.fetch_add(1, std::memory_order_relaxed);
+
+		currentSlot_ = AcquireWritableSlot();
+		return currentSlot_;
+	}
+
+	//-----------------------------------------------------------
+	// take free slot, or oldest ready slot with DropOldest policy.
+	//-----------------------------------------------------------
+	u32 FrameRingWriter::AcquireWritableSlot()
+	{
+		auto p_header = GetHeader(memory_);
+		auto p_slots = GetSlots(memory_);
+		u32 depth = p_header->depth;
+		bool can_drop = p_header->policy == FrameRingPolicy::DropOldest;
+
+		u32 spin_count = 0;
+		while (true)
+		{
+			// only producer moves slots out of Free, so no race on free slots.
+			// scan from next slot to spread writes evenly.
+			for (u32 i = 1; i <= depth; i++)
+			{
+				u32 slot = (currentSlot_ + i) % depth;
+				u64 state = p_slots[slot].state.load(std::memory_order_acquire);
+				if (GetSlotStatus(state) == SlotStatus::Free)
+				{
+					p_slots[slot].state.store(MakeSlotState(GetSlotSequence(state), SlotStatus::Writing), std::memory_order_relaxed);
+					return slot;
+				}
+			}
+
+			if (can_drop)
+			{
+				// overwrite oldest frame, consumer may take it at the same time.
+				u32 oldest = depth;
+				u64 oldest_state = 0;
+				for (u32 slot = 0; slot < depth; slot++)
+				{
+					u64 state = p_slots[slot].state.load(std::memory_order_acquire);
+					if (GetSlotStatus(state) == SlotStatus::Ready && (oldest == depth || state < oldest_state))
+					{
+						oldest = slot;
+						oldest_state = state;
+					}
+				}
+				if (oldest != depth)
+				{
+					u64 writing = MakeSlotState(GetSlotSequence(oldest_state), SlotStatus::Writing);
+					if (p_slots[oldest].state.compare_exchange_strong(oldest_state, writing, std::memory_order_acquire, std::memory_order_relaxed))
+					{
+						p_header->droppedCount.fetch_add(1, std::memory_order_relaxed);
+						return oldest;
+					}
+					continue;
+				}
+			}
+
+			// consumer holds every other slot.
+			WaitSlot(spin_count);
+		}
+	}
+
+	//-----------------------------------------------------------
+	// get frame memory of slot.
+	//-----------------------------------------------------------
+	u8* FrameRingWriter::GetSlotMemory(u32 slot) const
+	{
+		auto p_header = GetHeader(memory_);
+		assert(slot < p_header->depth);
+		return memory_.GetMemory() + p_header->dataOffset + p_header->frameBytes * slot;
+	}
+
+	u32 FrameRingWriter::GetDepth() const
+	{
+		return memory_.GetMemory() ? GetHeader(memory_)->depth : 0;
+	}
+
+	u64 FrameRingWriter::GetDroppedCount() const
+	{
+		return memory_.GetMemory() ? GetHeader(memory_)->droppedCount.load(std::memory_order_relaxed) : 0;
+	}
+
+
+	//-----------------------------------------------------------
+	// open frame ring.
+	//-----------------------------------------------------------
+	Result::Type FrameRingReader::Open(const char* name)
+	{
+		Close();
+
+		auto result = memory_.Open(name);
+		if (result != Result::Ok)
+		{
+			return result;
+		}
+
+		// validate header before touching slots, it is written by another process.
+		// ranges are checked by division to avoid overflow.
+		auto p_header = GetHeader(memory_);
+		bool is_valid = memory_.GetSize() >= sizeof(FrameRingHeader)
+			&& p_header->magic.load(std::memory_order_acquire) == kFrameRingMagic
+			&& p_header->version == kFrameRingVersion
+			&& p_header->depth >= 2
+			&& p_header->policy < FrameRingPolicy::MAX
+			&& p_header->totalBytes <= memory_.GetSize()
+			&& p_header->slotOffset >= sizeof(FrameRingHeader)
+			&& p_header->slotOffset % kFrameRingCacheLine == 0
+			&& p_header->slotOffset <= p_header->dataOffset
+			&& p_header->depth <= (p_header->dataOffset - p_header->slotOffset) / sizeof(FrameRingSlot)
+			&& p_header->dataOffset <= p_header->totalBytes
+			&& static_cast<u64>(p_header->rowPitch) * p_header->height <= p_header->frameBytes
+			&& p_header->frameBytes > 0
+			&& p_header->depth <= (p_header->totalBytes - p_header->dataOffset) / p_header->frameBytes;
+		if (!is_valid)
+		{
+			memory_.Close();
+			return Result::InvalidOperation;
+		}
+
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// close frame ring.
+	//-----------------------------------------------------------
+	void FrameRingReader::Close()
+	{
+		memory_.Close();
+	}
+
+	//-----------------------------------------------------------
+	// take oldest published frame.
+	//-----------------------------------------------------------
+	bool FrameRingReader::AcquireFrame(FrameRingFrame& outFrame)
+	{
+		assert(memory_.GetMemory() != nullptr);
+
+		auto p_header = GetHeader(memory_);
+		auto p_slots = GetSlots(memory_);
+		u32 depth = p_header->depth;
+
+		while (true)
+		{
+			u32 oldest = depth;
+			u64 oldest_state = 0;
+			for (u32 slot = 0; slot < depth; slot++)
+			{
+				u64 state = p_slots[slot].state.load(std::memory_order_acquire);
+				if (GetSlotStatus(state) == SlotStatus::Ready && (oldest == depth || state < oldest_state))
+				{
+					oldest = slot;
+					oldest_state = state;
+				}
+			}
+			if (oldest == depth)
+			{
+				return false;
+			}
+
+			// producer may take this slot to drop, retry with next oldest.
+			u64 reading = MakeSlotState(GetSlotSequence(oldest_state), SlotStatus::Reading);
+			if (p_slots[oldest].state.compare_exchange_strong(oldest_state, reading, std::memory_order_acquire, std::memory_order_relaxed))
+			{
+				outFrame.pData = memory_.GetMemory() + p_header->dataOffset + p_header->frameBytes * oldest;
+				outFrame.sequence = GetSlotSequence(oldest_state);
+				outFrame.slot = oldest;
+				outFrame.width = p_header->width;
+				outFrame.height = p_header->height;
+				outFrame.rowPitch = p_header->rowPitch;
+				outFrame.format = static_cast<ResourceFormat::Type>(p_header->format);
+				return true;
+			}
+		}
+	}
+
+	//-----------------------------------------------------------
+	// return frame to producer.
+	//-----------------------------------------------------------
+	void FrameRingReader::ReleaseFrame(const FrameRingFrame& frame)
+	{
+		assert(memory_.GetMemory() != nullptr);
+		assert(frame.slot < GetHeader(memory_)->depth);
+
+		auto&& state = GetSlots(memory_)[frame.slot].state;
+		assert(state.load(std::memory_order_relaxed) == MakeSlotState(frame.sequence, SlotStatus::Reading));
+		state.store(MakeSlotState(frame.sequence, SlotStatus::Free), std::memory_order_release);
+	}
+
+	u64 FrameRingReader::GetPublishedCount() const
+	{
+		return GetHeader(memory_)->publishedCount.load(std::memory_order_relaxed);
+	}
+
+	u64 FrameRingReader::GetDroppedCount() const
+	{
+		return GetHeader(memory_)->droppedCount.load(std::memory_order_relaxed);
+	}
+
+}
+//	EOF
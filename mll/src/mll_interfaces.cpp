@@ -1,5 +1,6 @@
 ﻿#include "../include/mll/mll_defines.h"
 #include "../include/mll/mll_interfaces.h"
+#include "../include/mll/mll_command_capture.h"
 
 #include <cassert>
 
@@ -8,25 +9,195 @@ namespace mll
 {
 	namespace
 	{
-		static const u8		kPendingKillCount = 3;
+		static const u64	kObjectIdBlockSize = 256;
+
+		//-----------------------------------------------------------
+		// Raise high-water mark.
+		//-----------------------------------------------------------
+		void UpdatePeak(std::atomic<u64>& peak, u64 value)
+		{
+			auto current = peak.load(std::memory_order_relaxed);
+			while (current < value && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed))
+			{}
+		}
 	}
 
 	//! @brief object handle id.
 	std::atomic<u64>	IDevice::objectId_;
 
+	//-----------------------------------------------------------
+	// Allocate unique object id.
+	//-----------------------------------------------------------
+	u64 IDevice::AllocateObjectId()
+	{
+		// each thread takes ids by block to avoid contention on global counter.
+		struct IdBlock
+		{
+			u64		next = 0;
+			u64		end = 0;
+		};
+		static thread_local IdBlock block;
+
+		if (block.next == block.end)
+		{
+			block.next = objectId_.fetch_add(kObjectIdBlockSize);
+			block.end = block.next + kObjectIdBlockSize;
+		}
+		return block.next++;
+	}
+
+	//-----------------------------------------------------------
+	// Count created device child.
+	//-----------------------------------------------------------
+	void IDevice::CountCreatedDeviceChild(const IDeviceChild* obj)
+	{
+		auto&& counters = objectCounters_[obj->objectType_];
+		auto live = counters.liveCount.fetch_add(1, std::memory_order_relaxed) + 1;
+		UpdatePeak(counters.peakLiveCount, live);
+		counters.totalCreatedCount.fetch_add(1, std::memory_order_relaxed);
+		counters.frameCreatedCount.fetch_add(1, std::memory_order_relaxed);
+
+		if (obj->memoryBytes_ > 0)
+		{
+			auto&& heap = heapCounters_[obj->memoryHeap_];
+			auto bytes = heap.bytes.fetch_add(obj->memoryBytes_, std::memory_order_relaxed) + obj->memoryBytes_;
+			UpdatePeak(heap.peakBytes, bytes);
+		}
+
+		if (pCapture_ != nullptr && obj->objectType_ == ObjectType::Texture)
+		{
+			pCapture_->WriteTexture(static_cast<const ITexture*>(obj));
+		}
+	}
+
+	//-----------------------------------------------------------
+	// Count and delete device child.
+	//-----------------------------------------------------------
+	void IDevice::DestroyDeviceChild(IDeviceChild* obj)
+	{
+		auto&& counters = objectCounters_[obj->objectType_];
+		counters.pendingCount.fetch_sub(1, std::memory_order_relaxed);
+		counters.totalDestroyedCount.fetch_add(1, std::memory_order_relaxed);
+		counters.frameDestroyedCount.fetch_add(1, std::memory_order_relaxed);
+
+		// native memory is freed by destructor.
+		if (obj->memoryBytes_ > 0)
+		{
+			heapCounters_[obj->memoryHeap_].bytes.fetch_sub(obj->memoryBytes_, std::memory_order_relaxed);
+		}
+
+		delete obj;
+	}
+
+	//-----------------------------------------------------------
+	// Get telemetry snapshot.
+	//-----------------------------------------------------------
+	DeviceStats IDevice::GetStats(bool bResetFrame)
+	{
+		DeviceStats ret;
+		ret.frameIndex = bResetFrame
+			? statsFrameIndex_.fetch_add(1, std::memory_order_relaxed)
+			: statsFrameIndex_.load(std::memory_order_relaxed);
+
+		for (u32 i = 0; i < ObjectType::MAX; i++)
+		{
+			auto&& src = objectCounters_[i];
+			auto&& dst = ret.objectTypes[i];
+			dst.liveCount = src.liveCount.load(std::memory_order_relaxed);
+			dst.pendingCount = src.pendingCount.load(std::memory_order_relaxed);
+			dst.peakLiveCount = src.peakLiveCount.load(std::memory_order_relaxed);
+			dst.totalCreatedCount = src.totalCreatedCount.load(std::memory_order_relaxed);
+			dst.totalDestroyedCount = src.totalDestroyedCount.load(std::memory_order_relaxed);
+			if (bResetFrame)
+			{
+				dst.frameCreatedCount = src.frameCreatedCount.exchange(0, std::memory_order_relaxed);
+				dst.frameDestroyedCount = src.frameDestroyedCount.exchange(0, std::memory_order_relaxed);
+			}
+			else
+			{
+				dst.frameCreatedCount = src.frameCreatedCount.load(std::memory_order_relaxed);
+				dst.frameDestroyedCount = src.frameDestroyedCount.load(std::memory_order_relaxed);
+			}
+			ret.pendingDeathCount += dst.pendingCount;
+		}
+
+		for (u32 i = 0; i < ResourceHeap::MAX; i++)
+		{
+			ret.heapBytes[i] = heapCounters_[i].bytes.load(std::memory_order_relaxed);
+			ret.peakHeapBytes[i] = heapCounters_[i].peakBytes.load(std::memory_order_relaxed);
+		}
+
+		return ret;
+	}
+
 	//-----------------------------------------------------------
 	// Kill device child.
 	//-----------------------------------------------------------
 	void IDevice::KillDeviceChild(IDeviceChild* obj)
 	{
-#if _DEBUG
-		auto it = liveObjects_.find(obj);
-		assert(it != liveObjects_.end());
-#endif
-		std::lock_guard<std::mutex> lock(objectMutex_);
-		obj->pendingKillCount_ = kPendingKillCount;
-		liveObjects_.erase(obj);
-		deathList_.push_back(obj);
+		auto&& counters = objectCounters_[obj->objectType_];
+		counters.liveCount.fetch_sub(1, std::memory_order_relaxed);
+		counters.pendingCount.fetch_add(1, std::memory_order_relaxed);
+
+		// invalidate weak pointers.
+		obj->pSlot_->generation.fetch_add(1, std::memory_order_release);
+
+		// commands submitted until now may refer this object, recorded streams hold references.
+		for (u32 i = 0; i < CommandQueueType::MAX; i++)
+		{
+			obj->retireFenceValues_[i] = GetSignaledFenceValue(static_cast<CommandQueueType::Type>(i));
+		}
+
+		// push to kill stack without lock.
+		auto head = killStackHead_.load(std::memory_order_relaxed);
+		do
+		{
+			obj->pNextKill_ = head;
+		} while (!killStackHead_.compare_exchange_weak(head, obj, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	//-----------------------------------------------------------
+	// Move killed objects from kill stack to death list.
+	//-----------------------------------------------------------
+	void IDevice::DrainKillStack()
+	{
+		auto head = killStackHead_.exchange(nullptr, std::memory_order_acquire);
+		if (head == nullptr)
+		{
+			return;
+		}
+
+		// kill stack is LIFO, reverse it to kill order.
+		IDeviceChild* first = nullptr;
+		while (head != nullptr)
+		{
+			auto next = head->pNextKill_;
+			head->pNextKill_ = first;
+			first = head;
+			head = next;
+		}
+
+		for (auto obj = first; obj != nullptr; obj = obj->pNextKill_)
+		{
+			assert(obj->pSlot_->pObject == obj);
+			objectTable_.Remove(obj->pSlot_);
+			deathList_.push_back(obj);
+		}
+	}
+
+	//-----------------------------------------------------------
+	// Check device child is no longer used by GPU.
+	//-----------------------------------------------------------
+	bool IDevice::IsRetired(const IDeviceChild* obj, const u64* completed)
+	{
+		for (u32 i = 0; i < CommandQueueType::MAX; i++)
+		{
+			if (obj->retireFenceValues_[i] > completed[i])
+			{
+				return false;
+			}
+		}
+		return true;
 	}
 
 	//-----------------------------------------------------------
@@ -34,33 +205,324 @@ namespace mll
 	//-----------------------------------------------------------
 	void IDevice::ProcDeathList(bool bForce)
 	{
-		std::lock_guard<std::mutex> lock(objectMutex_);
-		if (!bForce)
+		std::lock_guard<std::mutex> lock(deathMutex_);
+		DrainKillStack();
+		if (deathList_.empty())
 		{
-			auto it = deathList_.begin();
-			while (it != deathList_.end())
+			return;
+		}
+
+		if (bForce)
+		{
+			// destructors may kill owned objects, repeat until nothing is killed.
+			while (!deathList_.empty())
 			{
-				(*it)->pendingKillCount_--;
-				if ((*it)->pendingKillCount_ == 0)
+				std::deque<IDeviceChild*> objs;
+				objs.swap(deathList_);
+				for (auto&& obj : objs)
 				{
-					auto obj = (*it);
-					it = deathList_.erase(it);
-					delete obj;
+					DestroyDeviceChild(obj);
 				}
-				else
+				DrainKillStack();
+			}
+			return;
+		}
+
+		u64 completed[CommandQueueType::MAX];
+		for (u32 i = 0; i < CommandQueueType::MAX; i++)
+		{
+			completed[i] = GetCompletedFenceValue(static_cast<CommandQueueType::Type>(i));
+		}
+
+		// objects are almost ordered by kill time, so stop at the first object GPU may still use.
+		// concurrent kills can leave a retired object behind it, it will be deleted on later call.
+		bool use_thread = reclaimThread_.joinable();
+		std::unique_lock<std::mutex> reclaim_lock(reclaimMutex_, std::defer_lock);
+		if (use_thread)
+		{
+			reclaim_lock.lock();
+		}
+
+		u32 budget = (deathListBudget_ > 0) ? deathListBudget_ : ~0u;
+		u32 count = 0;
+		while (!deathList_.empty() && count < budget)
+		{
+			auto obj = deathList_.front();
+			if (!IsRetired(obj, completed))
+			{
+				break;
+			}
+			deathList_.pop_front();
+			count++;
+
+			if (use_thread)
+			{
+				reclaimList_.push_back(obj);
+			}
+			else
+			{
+				DestroyDeviceChild(obj);
+			}
+		}
+
+		if (use_thread && count > 0)
+		{
+			reclaim_lock.unlock();
+			reclaimCond_.notify_one();
+		}
+	}
+
+	//-----------------------------------------------------------
+	// Reclaim thread main function.
+	//-----------------------------------------------------------
+	void IDevice::ReclaimThreadMain()
+	{
+		std::vector<IDeviceChild*> objs;
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(reclaimMutex_);
+				reclaimCond_.wait(lock, [this] { return reclaimExit_ || !reclaimList_.empty(); });
+				if (reclaimList_.empty())
 				{
 					break;
 				}
+				objs.swap(reclaimList_);
+			}
+
+			for (auto&& obj : objs)
+			{
+				DestroyDeviceChild(obj);
 			}
+			objs.clear();
 		}
-		else
+	}
+
+	//-----------------------------------------------------------
+	// Initialize death list processing.
+	//-----------------------------------------------------------
+	void IDevice::InitializeDeathList(const DeviceDesc& desc)
+	{
+		deathListBudget_ = desc.deathListBudget;
+
+		if (desc.enableReclaimThread)
+		{
+			reclaimExit_ = false;
+			reclaimThread_ = std::thread([this] { ReclaimThreadMain(); });
+		}
+	}
+
+	//-----------------------------------------------------------
+	// Delete all objects in death list and stop reclaim thread.
+	//-----------------------------------------------------------
+	void IDevice::FinalizeDeathList()
+	{
+		// stop reclaim thread first, objects it kills are deleted below.
+		if (reclaimThread_.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(reclaimMutex_);
+				reclaimExit_ = true;
+			}
+			reclaimCond_.notify_one();
+			reclaimThread_.join();
+		}
+
+		ProcDeathList(true);
+	}
+
+	//-----------------------------------------------------------
+	// Capture submitted command lists.
+	//-----------------------------------------------------------
+	void IDevice::CaptureSubmit(CommandQueueType::Type type, ICommandList* const* ppCmdLists, u32 count)
+	{
+		if (pCapture_ != nullptr)
+		{
+			pCapture_->WriteSubmit(type, ppCmdLists, count);
+		}
+	}
+
+	//-----------------------------------------------------------
+	// Start capture.
+	//-----------------------------------------------------------
+	Result::Type IDevice::BeginCapture(const char* path)
+	{
+		if (pCapture_ != nullptr)
+		{
+			return Result::InvalidOperation;
+		}
+
+		auto p = MLL_NEW(CommandCaptureWriter);
+		auto result = p->Open(path);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+			return result;
+		}
+
+		pCapture_ = p;
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// Finish capture.
+	//-----------------------------------------------------------
+	void IDevice::EndCapture()
+	{
+		if (pCapture_ != nullptr)
+		{
+			MLL_DELETE(pCapture_);
+			pCapture_ = nullptr;
+		}
+	}
+
+	//-----------------------------------------------------------
+	// Submit command list to its command queue.
+	//-----------------------------------------------------------
+	u64 IDevice::Submit(ICommandList* pCmdList)
+	{
+		return Submit(pCmdList->GetDesc().typeCommandQueue, &pCmdList, 1).fenceValue;
+	}
+
+	//-----------------------------------------------------------
+	// Record clear texture packet.
+	//-----------------------------------------------------------
+	void ICommandList::ClearTexture(ITexture* pTexture, u32 subresource, const f32* color)
+	{
+		assert(isRecording_);
+		assert(pTexture != nullptr);
+
+		HoldReference(pTexture);
+		auto p = stream_.Push<ClearTexturePacket>();
+		p->pTexture = pTexture;
+		p->subresource = subresource;
+		for (u32 i = 0; i < 4; i++)
+		{
+			p->color[i] = color[i];
+		}
+	}
+
+	//-----------------------------------------------------------
+	// Record copy texture packet.
+	//-----------------------------------------------------------
+	void ICommandList::CopyTexture(ITexture* pDst, u32 dstSubresource, ITexture* pSrc, u32 srcSubresource)
+	{
+		assert(isRecording_);
+		assert(pDst != nullptr && pSrc != nullptr);
+
+		HoldReference(pDst);
+		HoldReference(pSrc);
+		auto p = stream_.Push<CopyTexturePacket>();
+		p->pDst = pDst;
+		p->pSrc = pSrc;
+		p->dstSubresource = dstSubresource;
+		p->srcSubresource = srcSubresource;
+	}
+
+	//-----------------------------------------------------------
+	// Record resolve texture packet.
+	//-----------------------------------------------------------
+	void ICommandList::ResolveTexture(ITexture* pDst, u32 dstSubresource, ITexture* pSrc, u32 srcSubresource)
+	{
+		assert(isRecording_);
+		assert(pDst != nullptr && pSrc != nullptr);
+
+		HoldReference(pDst);
+		HoldReference(pSrc);
+		auto p = stream_.Push<ResolveTexturePacket>();
+		p->pDst = pDst;
+		p->pSrc = pSrc;
+		p->dstSubresource = dstSubresource;
+		p->srcSubresource = srcSubresource;
+	}
+
+	//-----------------------------------------------------------
+	// Record execute bundle packet.
+	//-----------------------------------------------------------
+	void ICommandList::ExecuteBundle(ICommandList* pBundle)
+	{
+		assert(isRecording_);
+		assert(!IsBundle());
+		assert(pBundle != nullptr && pBundle->IsBundle() && !pBundle->IsRecording());
+		assert(pBundle->GetDesc().typeCommandQueue == desc_.typeCommandQueue);
+
+		HoldBundle(pBundle);
+		auto p = stream_.Push<ExecuteBundlePacket>();
+		p->pBundle = pBundle;
+	}
+
+	//-----------------------------------------------------------
+	// Record copy of command packet.
+	//-----------------------------------------------------------
+	void ICommandList::RecordPacket(const CommandPacketHeader& header)
+	{
+		assert(isRecording_);
+		assert(header.type < CommandPacketType::MAX);
+
+		HoldPacketReferences(*stream_.PushCopy(header));
+	}
+
+	//-----------------------------------------------------------
+	// Hold object referenced by recorded packet.
+	//-----------------------------------------------------------
+	void ICommandList::HoldReference(IDeviceChild* obj)
+	{
+		// consecutive packets often use the same object.
+		if (references_.empty() || static_cast<IDeviceChild*>(references_.back()) != obj)
+		{
+			references_.push_back(ObjPtr<IDeviceChild>(obj));
+		}
+	}
+
+	//-----------------------------------------------------------
+	// Hold executed bundle with its record count.
+	//-----------------------------------------------------------
+	void ICommandList::HoldBundle(ICommandList* pBundle)
+	{
+		HoldReference(pBundle);
+		executedBundles_.push_back(ExecutedBundle{ pBundle, pBundle->recordCount_ });
+	}
+
+	//-----------------------------------------------------------
+	// Check executed bundles were recorded again.
+	//-----------------------------------------------------------
+	bool ICommandList::IsExecutedBundleChanged() const
+	{
+		for (auto&& bundle : executedBundles_)
 		{
-			for (auto&& obj : deathList_)
+			if (bundle.pBundle->recordCount_ != bundle.recordCount)
 			{
-				delete obj;
+				return true;
 			}
-			deathList_.clear();
 		}
+		return false;
+	}
+
+	//-----------------------------------------------------------
+	// Discard previous stream and its references.
+	//-----------------------------------------------------------
+	void ICommandList::ResetStream()
+	{
+		stream_.Reset();
+		references_.clear();
+		executedBundles_.clear();
+		recordCount_++;
+	}
+
+	//-----------------------------------------------------------
+	// Hold objects referenced by recorded packet.
+	//-----------------------------------------------------------
+	void ICommandList::HoldPacketReferences(CommandPacketHeader& header)
+	{
+		if (header.type == CommandPacketType::ExecuteBundle)
+		{
+			HoldBundle(reinterpret_cast<ExecuteBundlePacket*>(&header)->pBundle);
+			return;
+		}
+		ForEachPacketTexture(header, [this](ITexture*& pTexture)
+		{
+			HoldReference(pTexture);
+		});
 	}
 
 }	// namespace mll
@@ -0,0 +1,287 @@
+﻿#include "../include/mll/mll_defines.h"
+#include "../include/mll/mll_name_table.h"
+#include "../include/mll/mll_allocator.h"
+#include "../include/mll/mll_hash.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <shared_mutex>
+#include <vector>
+
+
+namespace mll
+{
+	namespace
+	{
+		static const u32	kEntryChunkSize = 4096;
+		static const u32	kMaxEntryChunks = 1024;
+		static const size_t	kStringPageSize = 64 * 1024;
+		static const u32	kEmptyBucket = ~0u;
+
+		//-----------------------------------------------------------
+		//! @brief Global name table.
+		//!
+		//! Entries are stored in fixed size chunks and published by count,
+		//! so lookup from id needs no lock.
+		//-----------------------------------------------------------
+		class NameTable
+		{
+		public:
+			NameTable()
+			{
+				for (auto&& chunk : chunks_)
+				{
+					chunk.store(nullptr, std::memory_order_relaxed);
+				}
+				count_.store(0, std::memory_order_relaxed);
+				buckets_.assign(1024, kEmptyBucket);
+
+				// id 0 is empty string.
+				InsertLocked("", 0, CalcHash64("", 0));
+			}
+			~NameTable()
+			{
+				for (auto&& chunk : chunks_)
+				{
+					MemoryFree(chunk.load(), sizeof(Entry) * kEntryChunkSize, AllocCategory::General);
+				}
+				for (auto&& page : pages_)
+				{
+					MemoryFree(page.pMemory, page.size, AllocCategory::General);
+				}
+			}
+
+			NameId Intern(const char* name)
+			{
+				size_t length = strlen(name);
+				u64 hash = CalcHash64(name, length);
+
+				{
+					std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+					NameId id;
+					if (FindLocked(name, length, hash, id))
+					{
+						return id;
+					}
+				}
+
+				std::lock_guard<std::shared_timed_mutex> lock(mutex_);
+				NameId id;
+				if (FindLocked(name, length, hash, id))
+				{
+					return id;
+				}
+				return InsertLocked(name, length, hash);
+			}
+
+			bool Find(const char* name, NameId& outId)
+			{
+				size_t length = strlen(name);
+				std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+				return FindLocked(name, length, CalcHash64(name, length), outId);
+			}
+
+			const char* Get(NameId id) const
+			{
+				if (id >= count_.load(std::memory_order_acquire))
+				{
+					return "";
+				}
+				auto chunk = chunks_[id / kEntryChunkSize].load(std::memory_order_acquire);
+				return chunk[id % kEntryChunkSize].pString;
+			}
+
+			u32 GetCount() const
+			{
+				return count_.load(std::memory_order_acquire);
+			}
+
+		private:
+			struct Entry
+			{
+				const char*		pString;
+				u64				hash;
+				u32				length;
+			};	// struct Entry
+
+			struct Page
+			{
+				char*		pMemory;
+				size_t		size;
+			};	// struct Page
+
+			const Entry& GetEntry(NameId id) const
+			{
+				return chunks_[id / kEntryChunkSize].load(std::memory_order_relaxed)[id % kEntryChunkSize];
+			}
+
+			bool FindLocked(const char* name, size_t length, u64 hash, NameId& outId) const
+			{
+				u32 mask = static_cast<u32>(buckets_.size() - 1);
+				for (u32 i = static_cast<u32>(hash) & mask; ; i = (i + 1) & mask)
+				{
+					auto id = buckets_[i];
+					if (id == kEmptyBucket)
+					{
+						return false;
+					}
+					auto& entry = GetEntry(id);
+					if (entry.hash == hash && entry.length == length && memcmp(entry.pString, name, length) == 0)
+					{
+						outId = id;
+						return true;
+					}
+				}
+			}
+
+			NameId InsertLocked(const char* name, size_t length, u64 hash)
+			{
+				NameId id = count_.load(std::memory_order_relaxed);
+				u32 chunk_index = id / kEntryChunkSize;
+				if (chunk_index >= kMaxEntryChunks)
+				{
+					// names are never freed, table is full.
+					return kEmptyNameId;
+				}
+				if (chunks_[chunk_index].load(std::memory_order_relaxed) == nullptr)
+				{
+					auto chunk = static_cast<Entry*>(MemoryAllocate(sizeof(Entry) * kEntryChunkSize, alignof(Entry), AllocCategory::General));
+					if (chunk == nullptr)
+					{
+						return kEmptyNameId;
+					}
+					chunks_[chunk_index].store(chunk, std::memory_order_release);
+				}
+
+				auto p_string = CopyString(name, length);
+				if (p_string == nullptr)
+				{
+					return kEmptyNameId;
+				}
+
+				auto& entry = chunks_[chunk_index].load(std::memory_order_relaxed)[id % kEntryChunkSize];
+				entry.pString = p_string;
+				entry.hash = hash;
+				entry.length = static_cast<u32>(length);
+
+				// publish entry.
+				count_.store(id + 1, std::memory_order_release);
+
+				// keep load factor under 0.5.
+				if ((id + 1) * 2 > buckets_.size())
+				{
+					Rehash(static_cast<u32>(buckets_.size() * 2));
+				}
+				else
+				{
+					PlaceBucket(id, hash);
+				}
+				return id;
+			}
+
+			void PlaceBucket(NameId id, u64 hash)
+			{
+				u32 mask = static_cast<u32>(buckets_.size() - 1);
+				u32 i = static_cast<u32>(hash) & mask;
+				while (buckets_[i] != kEmptyBucket)
+				{
+					i = (i + 1) & mask;
+				}
+				buckets_[i] = id;
+			}
+
+			void Rehash(u32 bucketCount)
+			{
+				buckets_.assign(bucketCount, kEmptyBucket);
+				u32 count = count_.load(std::memory_order_relaxed);
+				for (NameId id = 0; id < count; id++)
+				{
+					PlaceBucket(id, GetEntry(id).hash);
+				}
+			}
+
+			const char* CopyString(const char* name, size_t length)
+			{
+				size_t size = length + 1;
+				if (pages_.empty() || pageOffset_ + size > pages_.back().size)
+				{
+					Page page;
+					page.size = (size > kStringPageSize) ? size : kStringPageSize;
+					page.pMemory = static_cast<char*>(MemoryAllocate(page.size, 1, AllocCategory::General));
+					if (page.pMemory == nullptr)
+					{
+						return nullptr;
+					}
+					pages_.push_back(page);
+					pageOffset_ = 0;
+				}
+
+				char* ret = pages_.back().pMemory + pageOffset_;
+				memcpy(ret, name, length);
+				ret[length] = '\0';
+				pageOffset_ += size;
+				return ret;
+			}
+
+		private:
+			mutable std::shared_timed_mutex	mutex_;
+			std::atomic<Entry*>				chunks_[kMaxEntryChunks];
+			std::atomic<u32>				count_;
+			std::vector<NameId>				buckets_;
+			std::vector<Page>				pages_;
+			size_t							pageOffset_ = 0;
+		};	// class NameTable
+
+		NameTable& GetNameTable()
+		{
+			static NameTable s_table;
+			return s_table;
+		}
+	}
+
+	//-----------------------------------------------------------
+	// intern name string.
+	//-----------------------------------------------------------
+	NameId InternName(const char* name)
+	{
+		if (name == nullptr || name[0] == '\0')
+		{
+			return kEmptyNameId;
+		}
+		return GetNameTable().Intern(name);
+	}
+
+	//-----------------------------------------------------------
+	// find name id without interning.
+	//-----------------------------------------------------------
+	bool FindInternedName(const char* name, NameId& outId)
+	{
+		if (name == nullptr || name[0] == '\0')
+		{
+			outId = kEmptyNameId;
+			return true;
+		}
+		return GetNameTable().Find(name, outId);
+	}
+
+	//-----------------------------------------------------------
+	// get interned name string.
+	//-----------------------------------------------------------
+	const char* GetInternedName(NameId id)
+	{
+		return GetNameTable().Get(id);
+	}
+
+	//-----------------------------------------------------------
+	// get interned name count.
+	//-----------------------------------------------------------
+	u32 GetInternedNameCount()
+	{
+		return GetNameTable().GetCount();
+	}
+
+}	// namespace mll
+
+
+//	EOF
@@ -0,0 +1,102 @@
+﻿#include "../include/mll/mll_defines.h"
+#include "../include/mll/mll_object_table.h"
+
+#include <cassert>
+
+
+namespace mll
+{
+	//-----------------------------------------------------------
+	// destructor.
+	//-----------------------------------------------------------
+	ObjectTable::~ObjectTable()
+	{
+		for (auto&& chunk : chunks_)
+		{
+			delete[] chunk;
+			chunk = nullptr;
+		}
+	}
+
+	//-----------------------------------------------------------
+	// insert object.
+	//-----------------------------------------------------------
+	ObjectSlot* ObjectTable::Insert(IDeviceChild* obj)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		ObjectSlot* ret = nullptr;
+		if (!freeSlots_.empty())
+		{
+			ret = freeSlots_.back();
+			freeSlots_.pop_back();
+		}
+		else
+		{
+			u32 chunk_index = slotCount_ / kChunkSize;
+			if (chunk_index >= kMaxChunks)
+			{
+				return nullptr;
+			}
+			if (chunks_[chunk_index] == nullptr)
+			{
+				chunks_[chunk_index] = new ObjectSlot[kChunkSize];
+			}
+
+			ret = &chunks_[chunk_index][slotCount_ % kChunkSize];
+			ret->index = slotCount_++;
+		}
+
+		ret->pObject = obj;
+		ret->denseIndex = static_cast<u32>(denseObjects_.size());
+		denseObjects_.push_back(obj);
+		denseSlots_.push_back(ret);
+		return ret;
+	}
+
+	//-----------------------------------------------------------
+	// remove object.
+	//-----------------------------------------------------------
+	void ObjectTable::Remove(ObjectSlot* slot)
+	{
+		assert(slot != nullptr);
+		std::lock_guard<std::mutex> lock(mutex_);
+		assert(slot->pObject != nullptr);
+		assert(denseSlots_[slot->denseIndex] == slot);
+
+		// move last object to removed position.
+		u32 index = slot->denseIndex;
+		auto last_slot = denseSlots_.back();
+		denseObjects_[index] = denseObjects_.back();
+		denseSlots_[index] = last_slot;
+		last_slot->denseIndex = index;
+		denseObjects_.pop_back();
+		denseSlots_.pop_back();
+
+		slot->pObject = nullptr;
+		freeSlots_.push_back(slot);
+	}
+
+	//-----------------------------------------------------------
+	// copy live objects.
+	//-----------------------------------------------------------
+	u32 ObjectTable::Snapshot(std::vector<IDeviceChild*>& outObjects)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		outObjects.assign(denseObjects_.begin(), denseObjects_.end());
+		return static_cast<u32>(outObjects.size());
+	}
+
+	//-----------------------------------------------------------
+	// get live object count.
+	//-----------------------------------------------------------
+	u32 ObjectTable::GetCount()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return static_cast<u32>(denseObjects_.size());
+	}
+
+}	// namespace mll
+
+
+//	EOF
@@ -0,0 +1,474 @@
+﻿#include "../include/mll/mll_defines.h"
+#include "../include/mll/mll_render_thread.h"
+
+#include <chrono>
+
+
+namespace mll
+{
+	namespace
+	{
+		inline u32 AlignSize(u32 size, u32 align)
+		{
+			return (size + align - 1) & ~(align - 1);
+		}
+
+		//-----------------------------------------------------------
+		// back off while the other thread is behind.
+		//-----------------------------------------------------------
+		void WaitOtherThread(u32& spinCount)
+		{
+			if (++spinCount < 64)
+			{
+				std::this_thread::yield();
+			}
+			else
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(100));
+			}
+		}
+	}
+
+
+	//-----------------------------------------------------------
+	// allocate ring memory.
+	//-----------------------------------------------------------
+	Result::Type SpscRing::Initialize(u32 capacity)
+	{
+		if (capacity < kRecordAlignment * 4 || (capacity & (capacity - 1)) != 0)
+		{
+			return Result::InvalidArgs;
+		}
+
+		Destroy();
+		pMemory_ = static_cast<u8*>(MemoryAllocate(capacity, 64, AllocCategory::CommandList));
+		if (pMemory_ == nullptr)
+		{
+			return Result::OutOfMemory;
+		}
+		capacity_ = capacity;
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// free ring memory.
+	//-----------------------------------------------------------
+	void SpscRing::Destroy()
+	{
+		if (pMemory_ != nullptr)
+		{
+			MemoryFree(pMemory_, capacity_, AllocCategory::CommandList);
+			pMemory_ = nullptr;
+		}
+		capacity_ = 0;
+		writePos_.store(0);
+		readPos_.store(0);
+		pendingPos_ = cachedReadPos_ = 0;
+		peekSize_ = 0;
+	}
+
+	//-----------------------------------------------------------
+	// reserve record memory.
+	//-----------------------------------------------------------
+	void* SpscRing::Allocate(u32 size)
+	{
+		assert(pMemory_ != nullptr);
+		assert(size <= GetMaxRecordSize());
+		assert(pendingPos_ == writePos_.load(std::memory_order_relaxed));
+
+		u32 record_size = AlignSize(size, kRecordAlignment) + kRecordAlignment;
+		u64 pos = pendingPos_;
+		u32 offset = static_cast<u32>(pos) & (capacity_ - 1);
+		u32 padding = (offset + record_size > capacity_) ? capacity_ - offset : 0;
+		u64 end = pos + padding + record_size;
+
+		// read position is loaded only when cached one is not enough.
+		if (end - cachedReadPos_ > capacity_)
+		{
+			cachedReadPos_ = readPos_.load(std::memory_order_acquire);
+			if (end - cachedReadPos_ > capacity_)
+			{
+				return nullptr;
+			}
+		}
+
+		if (padding > 0)
+		{
+			auto p_pad = reinterpret_cast<RecordHeader*>(pMemory_ + offset);
+			p_pad->size = padding;
+			p_pad->isPadding = 1;
+			offset = 0;
+		}
+		auto p_header = reinterpret_cast<RecordHeader*>(pMemory_ + offset);
+		p_header->size = record_size;
+		p_header->isPadding = 0;
+		pendingPos_ = end;
+		return pMemory_ + offset + kRecordAlignment;
+	}
+
+	//-----------------------------------------------------------
+	// publish allocated record.
+	//-----------------------------------------------------------
+	void SpscRing::Commit()
+	{
+		writePos_.store(pendingPos_, std::memory_order_release);
+	}
+
+	//-----------------------------------------------------------
+	// get oldest record.
+	//-----------------------------------------------------------
+	void* SpscRing::Peek()
+	{
+		assert(peekSize_ == 0);
+
+		u64 pos = readPos_.load(std::memory_order_relaxed);
+		while (pos != writePos_.load(std::memory_order_acquire))
+		{
+			auto p_header = reinterpret_cast<RecordHeader*>(pMemory_ + (static_cast<u32>(pos) & (capacity_ - 1)));
+			if (p_header->isPadding)
+			{
+				pos += p_header->size;
+				readPos_.store(pos, std::memory_order_release);
+				continue;
+			}
+			peekSize_ = p_header->size;
+			return reinterpret_cast<u8*>(p_header) + kRecordAlignment;
+		}
+		return nullptr;
+	}
+
+	//-----------------------------------------------------------
+	// release peeked record.
+	//-----------------------------------------------------------
+	void SpscRing::Pop()
+	{
+		assert(peekSize_ != 0);
+		readPos_.store(readPos_.load(std::memory_order_relaxed) + peekSize_, std::memory_order_release);
+		peekSize_ = 0;
+	}
+
+
+	//-----------------------------------------------------------
+	// create frame resources and start render thread.
+	//-----------------------------------------------------------
+	Result::Type RenderThread::Initialize(IDevice* pDevice, ISwapchain* pSwapchain, const RenderThreadDesc& desc)
+	{
+		if (pDevice == nullptr || pSwapchain == nullptr)
+		{
+			return Result::InvalidArgs;
+		}
+		if (thread_.joinable())
+		{
+			return Result::InvalidOperation;
+		}
+
+		u32 frame_count = (desc.frameCount != 0) ? desc.frameCount : pSwapchain->GetDesc().backBufferCount;
+		if (frame_count == 0 || frame_count > kMaxFrameCount)
+		{
+			return Result::InvalidArgs;
+		}
+
+		auto result = ring_.Initialize(desc.ringBytes);
+		if (IsFailed(result))
+		{
+			return result;
+		}
+
+		CommandListDesc cmd_desc;
+		cmd_desc.SetCommandQueueType(CommandQueueType::Graphics);
+		for (u32 i = 0; i < frame_count; i++)
+		{
+			result = pDevice->CreateCommandList(cmd_desc, cmdLists_[i]);
+			if (IsFailed(result))
+			{
+				Destroy();
+				return result;
+			}
+			pFrameData_[i] = MLL_NEW(LinearArena, desc.frameDataPageSize, AllocCategory::Transient);
+			tickets_[i] = SubmitTicket();
+		}
+
+		pDevice_ = pDevice;
+		pSwapchain_ = pSwapchain;
+		frameCount_ = frame_count;
+		syncInterval_ = desc.syncInterval;
+		context_ = RenderContext();
+		context_.pDevice = pDevice;
+		context_.pSwapchain = pSwapchain;
+
+		thread_ = std::thread([this] { ThreadMain(); });
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// stop render thread and release frame resources.
+	//-----------------------------------------------------------
+	void RenderThread::Destroy()
+	{
+		if (thread_.joinable())
+		{
+			assert(!isInFrame_);
+			AllocateRecord(RecordType::Exit, 0);
+			CommitRecord();
+			thread_.join();
+		}
+
+		for (u32 i = 0; i < kMaxFrameCount; i++)
+		{
+			cmdLists_[i].Reset();
+			tickets_[i] = SubmitTicket();
+			if (pFrameData_[i] != nullptr)
+			{
+				MLL_DELETE(pFrameData_[i]);
+				pFrameData_[i] = nullptr;
+			}
+		}
+		ring_.Destroy();
+
+		pDevice_ = nullptr;
+		pSwapchain_ = nullptr;
+		frameCount_ = 0;
+		producedFrame_ = producedRecords_ = 0;
+		commandCount_ = ringFullWaitCount_ = frameWaitCount_ = 0;
+		isInFrame_ = false;
+		retiredFrame_.store(0);
+		executedRecords_.store(0);
+		gpuWaitCount_.store(0);
+	}
+
+	//-----------------------------------------------------------
+	// start new frame.
+	//-----------------------------------------------------------
+	void RenderThread::BeginFrame()
+	{
+		assert(thread_.joinable());
+		assert(!isInFrame_);
+
+		// backpressure, slot is reused after render thread retired its previous frame.
+		u32 spin_count = 0;
+		while (producedFrame_ - retiredFrame_.load(std::memory_order_acquire) >= frameCount_)
+		{
+			if (spin_count == 0)
+			{
+				frameWaitCount_++;
+			}
+			WaitOtherThread(spin_count);
+		}
+
+		u32 slot = static_cast<u32>(producedFrame_ % frameCount_);
+		producedFrame_++;
+		pFrameData_[slot]->Reset();
+		isInFrame_ = true;
+
+		AllocateRecord(RecordType::BeginFrame, 0);
+		CommitRecord();
+	}
+
+	//-----------------------------------------------------------
+	// finish frame.
+	//-----------------------------------------------------------
+	void RenderThread::EndFrame()
+	{
+		assert(isInFrame_);
+
+		AllocateRecord(RecordType::EndFrame, 0);
+		CommitRecord();
+		isInFrame_ = false;
+	}
+
+	//-----------------------------------------------------------
+	// allocate parameter data of current frame.
+	//-----------------------------------------------------------
+	void* RenderThread::AllocateFrameData(size_t size, size_t alignment)
+	{
+		assert(isInFrame_);
+		return pFrameData_[(producedFrame_ - 1) % frameCount_]->Allocate(size, alignment);
+	}
+
+	//-----------------------------------------------------------
+	// wait all commands and GPU.
+	//-----------------------------------------------------------
+	void RenderThread::Flush()
+	{
+		EnqueueAndWait(RecordType::Flush);
+	}
+
+	//-----------------------------------------------------------
+	// get statistics.
+	//-----------------------------------------------------------
+	RenderThreadStats RenderThread::GetStats() const
+	{
+		RenderThreadStats stats;
+		stats.producedFrameCount = producedFrame_;
+		stats.retiredFrameCount = retiredFrame_.load(std::memory_order_acquire);
+		stats.commandCount = commandCount_;
+		stats.ringFullWaitCount = ringFullWaitCount_;
+		stats.frameWaitCount = frameWaitCount_;
+		stats.gpuWaitCount = gpuWaitCount_.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	//-----------------------------------------------------------
+	// allocate record in ring, wait while ring is full.
+	//-----------------------------------------------------------
+	RenderThread::Record* RenderThread::AllocateRecord(RecordType::Type type, size_t payloadSize)
+	{
+		assert(thread_.joinable());
+
+		auto size = static_cast<u32>(kRecordPayloadOffset + payloadSize);
+		assert(size <= ring_.GetMaxRecordSize());
+
+		void* p = nullptr;
+		u32 spin_count = 0;
+		while ((p = ring_.Allocate(size)) == nullptr)
+		{
+			if (spin_count == 0)
+			{
+				ringFullWaitCount_++;
+			}
+			WaitOtherThread(spin_count);
+		}
+
+		auto p_record = static_cast<Record*>(p);
+		p_record->type = type;
+		p_record->frameSlot = static_cast<u32>((producedFrame_ + frameCount_ - 1) % frameCount_);
+		p_record->pInvoke = nullptr;
+		if (type == RecordType::Command)
+		{
+			commandCount_++;
+		}
+		return p_record;
+	}
+
+	//-----------------------------------------------------------
+	// publish record and wake render thread.
+	//-----------------------------------------------------------
+	void RenderThread::CommitRecord()
+	{
+		ring_.Commit();
+		producedRecords_++;
+
+		// pairs with fence in ThreadMain, either render thread sees the record or we see it sleeping.
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (isSleeping_.load(std::memory_order_relaxed))
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			cond_.notify_one();
+		}
+	}
+
+	//-----------------------------------------------------------
+	// enqueue internal record and wait its execution.
+	//-----------------------------------------------------------
+	void RenderThread::EnqueueAndWait(RecordType::Type type)
+	{
+		AllocateRecord(type, 0);
+		CommitRecord();
+
+		u64 target = producedRecords_;
+		u32 spin_count = 0;
+		while (executedRecords_.load(std::memory_order_acquire) < target)
+		{
+			WaitOtherThread(spin_count);
+		}
+	}
+
+	//-----------------------------------------------------------
+	// wait GPU completion of frame slot.
+	//-----------------------------------------------------------
+	void RenderThread::WaitGpu(u32 frameSlot)
+	{
+		auto&& ticket = tickets_[frameSlot];
+		if (ticket.IsValid())
+		{
+			if (!pDevice_->IsTicketCompleted(ticket))
+			{
+				gpuWaitCount_.fetch_add(1, std::memory_order_relaxed);
+				pDevice_->WaitTicket(ticket);
+			}
+			ticket = SubmitTicket();
+		}
+	}
+
+	//-----------------------------------------------------------
+	// render thread main loop.
+	//-----------------------------------------------------------
+	void RenderThread::ThreadMain()
+	{
+		u32 spin_count = 0;
+		for (;;)
+		{
+			auto p_record = static_cast<Record*>(ring_.Peek());
+			if (p_record == nullptr)
+			{
+				if (++spin_count < 64)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+
+				std::unique_lock<std::mutex> lock(mutex_);
+				isSleeping_.store(true, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				cond_.wait(lock, [this] { return !ring_.IsEmpty(); });
+				isSleeping_.store(false, std::memory_order_relaxed);
+				spin_count = 0;
+				continue;
+			}
+			spin_count = 0;
+
+			bool is_exit = false;
+			u32 slot = p_record->frameSlot;
+			switch (p_record->type)
+			{
+			case RecordType::Command:
+				p_record->pInvoke(GetRecordPayload(p_record), context_);
+				break;
+			case RecordType::BeginFrame:
+				{
+					// command list and back buffer of this slot may still be used by GPU.
+					WaitGpu(slot);
+					cmdLists_[slot]->Begin();
+					context_.pCmdList = cmdLists_[slot];
+					context_.backBufferIndex = pSwapchain_->GetBackBufferIndex();
+					context_.pBackBuffer = pSwapchain_->GetBackBuffer(context_.backBufferIndex);
+					context_.frameSlot = slot;
+					context_.frameNumber++;
+				}
+				break;
+			case RecordType::EndFrame:
+				{
+					ICommandList* p_cmd = cmdLists_[slot];
+					p_cmd->End();
+					tickets_[slot] = pDevice_->Submit(CommandQueueType::Graphics, &p_cmd, 1);
+					pSwapchain_->Present(syncInterval_);
+					context_.pCmdList = nullptr;
+					context_.pBackBuffer = nullptr;
+
+					// parameter data of frame is not read anymore.
+					retiredFrame_.fetch_add(1, std::memory_order_release);
+				}
+				break;
+			case RecordType::Flush:
+			case RecordType::Exit:
+				for (u32 i = 0; i < frameCount_; i++)
+				{
+					WaitGpu(i);
+				}
+				is_exit = p_record->type == RecordType::Exit;
+				break;
+			}
+
+			ring_.Pop();
+			executedRecords_.fetch_add(1, std::memory_order_release);
+			if (is_exit)
+			{
+				return;
+			}
+		}
+	}
+
+}	// namespace mll
+
+
+//	EOF
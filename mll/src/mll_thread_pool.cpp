@@ -0,0 +1,137 @@
+﻿#include "../include/mll/mll_defines.h"
+#include "../include/mll/mll_thread_pool.h"
+
+#include <algorithm>
+
+
+namespace mll
+{
+	//-----------------------------------------------------------
+	// start worker threads.
+	//-----------------------------------------------------------
+	void ThreadPool::Initialize(u32 threadCount)
+	{
+		if (threadCount == 0)
+		{
+			// caller thread also works, so leave one core for it.
+			u32 hw = std::thread::hardware_concurrency();
+			threadCount = (hw > 1) ? hw - 1 : 0;
+		}
+
+		exit_ = false;
+		for (u32 i = 0; i < threadCount; i++)
+		{
+			threads_.emplace_back([this] { WorkerMain(); });
+		}
+	}
+
+	//-----------------------------------------------------------
+	// stop worker threads.
+	//-----------------------------------------------------------
+	void ThreadPool::Destroy()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			exit_ = true;
+		}
+		jobCond_.notify_all();
+		for (auto&& t : threads_)
+		{
+			t.join();
+		}
+		threads_.clear();
+	}
+
+	//-----------------------------------------------------------
+	// run job on caller and worker threads.
+	//-----------------------------------------------------------
+	void ThreadPool::Run(Job& job)
+	{
+		if (job.count == 0)
+		{
+			return;
+		}
+		if (threads_.empty() || job.count == 1)
+		{
+			for (u32 i = 0; i < job.count; i++)
+			{
+				job.pInvoke(job.pContext, i);
+			}
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			jobs_.push_back(&job);
+		}
+		jobCond_.notify_all();
+
+		Process(job);
+
+		// job lives on caller stack, wait until no worker refers it.
+		std::unique_lock<std::mutex> lock(mutex_);
+		doneCond_.wait(lock, [&job] { return job.done.load() == job.count && job.workerCount == 0; });
+		jobs_.erase(std::find(jobs_.begin(), jobs_.end(), &job));
+	}
+
+	//-----------------------------------------------------------
+	// process job indices until all are taken.
+	//-----------------------------------------------------------
+	void ThreadPool::Process(Job& job)
+	{
+		while (true)
+		{
+			u32 index = job.next.fetch_add(1);
+			if (index >= job.count)
+			{
+				break;
+			}
+			job.pInvoke(job.pContext, index);
+			job.done.fetch_add(1);
+		}
+	}
+
+	//-----------------------------------------------------------
+	// worker thread main function.
+	//-----------------------------------------------------------
+	void ThreadPool::WorkerMain()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		while (true)
+		{
+			Job* p_job = nullptr;
+			jobCond_.wait(lock, [&]
+			{
+				if (exit_)
+				{
+					return true;
+				}
+				for (auto&& job : jobs_)
+				{
+					if (job->next.load() < job->count)
+					{
+						p_job = job;
+						return true;
+					}
+				}
+				return false;
+			});
+			if (p_job == nullptr)
+			{
+				break;
+			}
+
+			p_job->workerCount++;
+			lock.unlock();
+			Process(*p_job);
+			lock.lock();
+			p_job->workerCount--;
+			if (p_job->workerCount == 0)
+			{
+				doneCond_.notify_all();
+			}
+		}
+	}
+
+}
+//	EOF
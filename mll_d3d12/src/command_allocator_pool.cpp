@@ -0,0 +1,89 @@
+﻿#include "command_allocator_pool.h"
+
+#include <cassert>
+#include <algorithm>
+
+#include "device.h"
+
+
+namespace mll
+{
+	//-----------------------------------------------------------
+	// initialize pool.
+	//-----------------------------------------------------------
+	Result::Type CommandAllocatorPool::Initialize(Device* pDevice, CommandQueueType::Type type)
+	{
+		pDevice_ = pDevice;
+		type_ = type;
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// destroy pool.
+	//-----------------------------------------------------------
+	void CommandAllocatorPool::Destroy()
+	{
+		// all command lists are destroyed and queues are idle here.
+		assert(stats_.heldCount == 0);
+		for (auto&& entry : pending_)
+		{
+			SafeRelease(entry.pAllocator);
+		}
+		pending_.clear();
+		stats_ = CommandAllocatorStats();
+	}
+
+	//-----------------------------------------------------------
+	// acquire reset allocator.
+	//-----------------------------------------------------------
+	ID3D12CommandAllocator* CommandAllocatorPool::Acquire()
+	{
+		auto completed = pDevice_->GetCommandQueue()->GetCompletedFenceValue(type_);
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		stats_.acquireCount++;
+
+		// allocators are returned nearly in submission order, so front is the oldest.
+		for (size_t i = 0; i < pending_.size(); i++)
+		{
+			if (pending_[i].fenceValue <= completed)
+			{
+				auto p_allocator = pending_[i].pAllocator;
+				pending_.erase(pending_.begin() + i);
+
+				auto hr = p_allocator->Reset();
+				assert(SUCCEEDED(hr));
+				(void)hr;
+				stats_.heldCount++;
+				stats_.recycleCount++;
+				return p_allocator;
+			}
+		}
+
+		// no completed allocator, add new one.
+		ID3D12CommandAllocator* p_allocator = nullptr;
+		auto hr = pDevice_->GetNativeDevice()->CreateCommandAllocator(GetNativeCommandListType(type_), IID_PPV_ARGS(&p_allocator));
+		if (FAILED(hr))
+		{
+			return nullptr;
+		}
+		stats_.allocatorCount++;
+		stats_.heldCount++;
+		return p_allocator;
+	}
+
+	//-----------------------------------------------------------
+	// return allocator to pool.
+	//-----------------------------------------------------------
+	void CommandAllocatorPool::Release(ID3D12CommandAllocator* pAllocator, u64 fenceValue, u64 recordBytes)
+	{
+		assert(pAllocator != nullptr);
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		pending_.push_back(Entry{ pAllocator, fenceValue });
+		stats_.heldCount--;
+		stats_.peakRecordBytes = std::max(stats_.peakRecordBytes, recordBytes);
+	}
+
+}
+//	EOF
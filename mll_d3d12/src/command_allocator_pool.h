@@ -0,0 +1,73 @@
+﻿#pragma once
+
+#include "native.h"
+
+#include <vector>
+#include <mutex>
+
+
+namespace mll
+{
+	class Device;
+
+	//-----------------------------------------------------------
+	//! @brief command allocator pool of a command queue type.
+	//!
+	//! Allocators are returned with fence value of their last submission,
+	//! and handed out again after the fence is completed.
+	//! If no allocator is completed, new one is created instead of waiting.
+	//-----------------------------------------------------------
+	class CommandAllocatorPool
+	{
+		MLL_DECLARE_CLASS_ALLOCATOR(AllocCategory::CommandList);
+
+	public:
+		CommandAllocatorPool()
+		{}
+		~CommandAllocatorPool()
+		{
+			Destroy();
+		}
+
+		Result::Type Initialize(Device* pDevice, CommandQueueType::Type type);
+		void Destroy();
+
+		/**
+		 * @brief acquire reset allocator.
+		 *
+		 * @return			allocator. (nullptr if creation failed)
+		*/
+		ID3D12CommandAllocator* Acquire();
+
+		/**
+		 * @brief return allocator to pool.
+		 *
+		 * @param[in]	pAllocator		allocator acquired from this pool.
+		 * @param[in]	fenceValue		fence value of last submission. 0 if not submitted.
+		 * @param[in]	recordBytes		command stream bytes recorded into allocator.
+		*/
+		void Release(ID3D12CommandAllocator* pAllocator, u64 fenceValue, u64 recordBytes);
+
+		// getter
+		CommandAllocatorStats GetStats()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return stats_;
+		}
+
+	private:
+		struct Entry
+		{
+			ID3D12CommandAllocator*	pAllocator;
+			u64						fenceValue;
+		};	// struct Entry
+
+		Device*					pDevice_ = nullptr;
+		CommandQueueType::Type	type_ = CommandQueueType::Graphics;
+		std::mutex				mutex_;
+		std::vector<Entry>		pending_;			// returned allocators in release order.
+		CommandAllocatorStats	stats_;
+	};	// class CommandAllocatorPool
+
+}
+//	EOF
@@ -3,56 +3,86 @@
 #include <cassert>
 
 #include "device.h"
+#include "texture.h"
 
 
 namespace mll
 {
+	MLL_IMPLEMENT_POOL_ALLOCATOR(CommandList, AllocCategory::CommandList);
+
+	namespace
+	{
+		static const u32	kClearViewCount = 64;
+	}
+
 	void CommandList::Release()
 	{
 		KillSelf();
 	}
 
+	void CommandList::OnObjectNameChanged()
+	{
+		auto device = static_cast<Device*>(pParentDevice_);
+		if (device->IsNativeObjectNameEnabled() && pCmdList_ != nullptr)
+		{
+			SetNativeObjectName(pCmdList_, GetObjectName());
+		}
+	}
+
 	//-----------------------------------------------------------
 	// initialize native command list.
 	//-----------------------------------------------------------
 	Result::Type CommandList::Initialize(Device* pDevice, const CommandListDesc& desc)
 	{
 		desc_ = desc;
+		if (IsBundle())
+		{
+			// bundle is translated into command lists executing it, no native object.
+			return Result::Ok;
+		}
 
-		// create command allocator.
+		pAllocatorPool_ = pDevice->GetCommandAllocatorPool(desc.typeCommandQueue);
+
+		// create closed command list without allocator, allocator is acquired from pool in End.
 		auto native_device = pDevice->GetNativeDevice();
 		auto native_type = GetNativeCommandListType(desc.typeCommandQueue);
-		auto hr = native_device->CreateCommandAllocator(native_type, IID_PPV_ARGS(&pCmdAllocator_));
+		auto hr = native_device->CreateCommandList1(GetNodeMask(), native_type, D3D12_COMMAND_LIST_FLAG_NONE, IID_PPV_ARGS(&pCmdList_));
 		if (FAILED(hr))
 		{
 			return Result::InvalidArgs;
 		}
 
-		// create command list.
-		ID3D12CommandList* cmd_list_base;
-		hr = native_device->CreateCommandList(GetNodeMask(), native_type, pCmdAllocator_, nullptr, IID_PPV_ARGS(&cmd_list_base));
-		if (FAILED(hr))
-		{
-			return Result::InvalidArgs;
-		}
-		hr = cmd_list_base->QueryInterface(IID_PPV_ARGS(&pCmdList_));
-		if (FAILED(hr))
+		// create CPU descriptor heaps for clear views.
+		if (desc.typeCommandQueue == CommandQueueType::Graphics)
 		{
-			return Result::InvalidArgs;
+			D3D12_DESCRIPTOR_HEAP_TYPE heap_types[] = { D3D12_DESCRIPTOR_HEAP_TYPE_RTV, D3D12_DESCRIPTOR_HEAP_TYPE_DSV };
+			for (u32 i = 0; i < 2; i++)
+			{
+				D3D12_DESCRIPTOR_HEAP_DESC hd{};
+				hd.Type = heap_types[i];
+				hd.NumDescriptors = kClearViewCount;
+				hd.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+				hd.NodeMask = GetNodeMask();
+				hr = native_device->CreateDescriptorHeap(&hd, IID_PPV_ARGS(&pClearViewHeaps_[i]));
+				if (FAILED(hr))
+				{
+					return Result::InvalidArgs;
+				}
+				clearViewSizes_[i] = native_device->GetDescriptorHandleIncrementSize(heap_types[i]);
+				clearViewCounts_[i] = 0;
+				clearViewKeys_[i].reserve(kClearViewCount);
+			}
 		}
-		SafeRelease(cmd_list_base);
-
-		pCmdList_->Close();
 
 		// create descriptor stack.
 		if (desc.typeCommandQueue == CommandQueueType::Graphics || desc.typeCommandQueue == CommandQueueType::Compute)
 		{
 			pResourceDescriptorStack_ = std::make_unique<ResourceDescriptorStack>();
-			auto result = pResourceDescriptorStack_->Initialize(pDevice);
+			auto result = pResourceDescriptorStack_->Initialize(pDevice, pDevice->GetDescriptorRing(desc.typeCommandQueue));
 			assert(IsSucceeded(result));
 
 			pSamplerDescriptorStack_ = std::make_unique<SamplerDescriptorStack>();
-			result = pSamplerDescriptorStack_->Initialize(pDevice);
+			result = pSamplerDescriptorStack_->Initialize(pDevice->GetSamplerDescriptorCache(), desc.typeCommandQueue);
 			assert(IsSucceeded(result));
 		}
 
@@ -64,10 +94,130 @@ namespace mll
 	//-----------------------------------------------------------
 	void CommandList::Destroy()
 	{
+		// descriptors are returned with allocator.
+		ReleaseAllocator();
 		pSamplerDescriptorStack_.reset(nullptr);
 		pResourceDescriptorStack_.reset(nullptr);
+		for (auto&& heap : pClearViewHeaps_)
+		{
+			SafeRelease(heap);
+		}
 		SafeRelease(pCmdList_);
-		SafeRelease(pCmdAllocator_);
+	}
+
+	//-----------------------------------------------------------
+	// return allocator and descriptors with fence value of last submission.
+	//-----------------------------------------------------------
+	void CommandList::ReleaseAllocator()
+	{
+		if (pResourceDescriptorStack_)
+		{
+			pResourceDescriptorStack_->Release(submittedFenceValue_);
+			pSamplerDescriptorStack_->Release(submittedFenceValue_);
+		}
+		if (pCmdAllocator_ != nullptr)
+		{
+			pAllocatorPool_->Release(pCmdAllocator_, submittedFenceValue_, recordBytes_);
+			pCmdAllocator_ = nullptr;
+		}
+		submittedFenceValue_ = 0;
+		recordBytes_ = 0;
+	}
+
+	//-----------------------------------------------------------
+	// hold descriptors again before submission.
+	//-----------------------------------------------------------
+	void CommandList::PrepareSubmit()
+	{
+		// first submission after End holds descriptors already.
+		if (pResourceDescriptorStack_ && !pResourceDescriptorStack_->Hold())
+		{
+			Translate();
+		}
+	}
+
+	//-----------------------------------------------------------
+	// return descriptor blocks with fence value of submission.
+	//-----------------------------------------------------------
+	void CommandList::OnSubmitted(u64 fenceValue)
+	{
+		submittedFenceValue_ = fenceValue;
+		if (pResourceDescriptorStack_)
+		{
+			pResourceDescriptorStack_->Submit(fenceValue);
+		}
+	}
+
+	//-----------------------------------------------------------
+	// record native command list from command stream.
+	//-----------------------------------------------------------
+	void CommandList::Translate()
+	{
+		stateStats_ = CommandStateStats();
+
+		// previous allocator may still be executing, exchange it for completed one.
+		ReleaseAllocator();
+		pCmdAllocator_ = pAllocatorPool_->Acquire();
+		assert(pCmdAllocator_ != nullptr);
+		recordBytes_ = stream_.GetUsedBytes();
+
+		auto hr = pCmdList_->Reset(pCmdAllocator_, nullptr);
+		assert(SUCCEEDED(hr));
+
+		clearViewCounts_[0] = clearViewCounts_[1] = 0;
+		clearViewKeys_[0].clear();
+		clearViewKeys_[1].clear();
+		descriptorHeaps_.Invalidate();
+
+		TranslateCommandStream(stream_);
+
+		// descriptor tables staged during translation are copied at once.
+		if (pResourceDescriptorStack_)
+		{
+			pResourceDescriptorStack_->Flush();
+		}
+		hr = pCmdList_->Close();
+		assert(SUCCEEDED(hr));
+	}
+
+	//-----------------------------------------------------------
+	// find or allocate CPU descriptor for clear view.
+	//-----------------------------------------------------------
+	bool CommandList::AllocateClearView(bool isDepth, ID3D12Resource* pResource, u32 subresource, D3D12_CPU_DESCRIPTOR_HANDLE& outHandle)
+	{
+		u32 index = isDepth ? 1 : 0;
+		assert(pClearViewHeaps_[index] != nullptr);
+
+		// same subresource is usually cleared several times in a command list.
+		auto&& keys = clearViewKeys_[index];
+		u32 slot = 0;
+		for (; slot < keys.size(); slot++)
+		{
+			if (keys[slot].pResource == pResource && keys[slot].subresource == subresource)
+			{
+				break;
+			}
+		}
+
+		bool bCreate = (slot == keys.size());
+		if (bCreate)
+		{
+			// clear reads CPU descriptor at record time, so the oldest slot is recreated when heap is full.
+			slot = clearViewCounts_[index]++ % kClearViewCount;
+			if (slot == keys.size())
+			{
+				keys.push_back(ClearViewKey{ pResource, subresource });
+			}
+			else
+			{
+				keys[slot] = ClearViewKey{ pResource, subresource };
+			}
+		}
+		CountState(CommandStateType::ClearView, bCreate ? 1 : 0, bCreate ? 0 : 1);
+
+		outHandle = pClearViewHeaps_[index]->GetCPUDescriptorHandleForHeapStart();
+		outHandle.ptr += static_cast<SIZE_T>(clearViewSizes_[index]) * slot;
+		return bCreate;
 	}
 
 	//-----------------------------------------------------------
@@ -77,20 +227,129 @@ namespace mll
 	{
 		if (desc_.typeCommandQueue == CommandQueueType::Graphics || desc_.typeCommandQueue == CommandQueueType::Compute)
 		{
-			if (pResourceDescriptorStack_->IsHeapDirty() || pSamplerDescriptorStack_->IsHeapDirty())
+			// resource ring and sampler cache are device wide, so heaps are set once per command list.
+			DescriptorHeapPair heaps(
+				pResourceDescriptorStack_->GetNativeHeap(),
+				pSamplerDescriptorStack_->GetNativeHeap());
+			if (ApplyState(CommandStateType::DescriptorHeaps, descriptorHeaps_, heaps))
 			{
-				ID3D12DescriptorHeap* p_heaps[] = {
-					pResourceDescriptorStack_->GetCurrentHeap()->GetNativeHeap(),
-					pSamplerDescriptorStack_->GetCurrentHeap()->GetNativeHeap(),
-				};
+				ID3D12DescriptorHeap* p_heaps[] = { heaps.first, heaps.second };
 				pCmdList_->SetDescriptorHeaps(ARRAYSIZE(p_heaps), p_heaps);
+			}
+		}
+	}
 
-				pResourceDescriptorStack_->UnmarkHeapDirty();
-				pSamplerDescriptorStack_->UnmarkHeapDirty();
+	//-----------------------------------------------------------
+	// translate clear texture packet.
+	//-----------------------------------------------------------
+	void CommandList::TranslateClearTexture(const ClearTexturePacket& packet)
+	{
+		auto p_texture = static_cast<Texture*>(packet.pTexture);
+		auto p_native = p_texture->GetNativeTexture();
+		auto p_device = static_cast<Device*>(pParentDevice_)->GetNativeDevice();
+		auto&& tex_desc = packet.pTexture->GetDesc();
+		auto subresource = packet.subresource;
+		auto color = packet.color;
+
+		// subresource 0 uses persistent view of texture, others are created per command list.
+		if (tex_desc.usageFlags & ResourceUsageFlag::DepthStencil)
+		{
+			D3D12_CPU_DESCRIPTOR_HANDLE handle;
+			if (subresource == 0 && p_texture->GetDepthStencilView().IsValid())
+			{
+				handle = p_texture->GetDepthStencilView().cpuHandle;
+			}
+			else if (AllocateClearView(true, p_native, subresource, handle))
+			{
+				D3D12_DEPTH_STENCIL_VIEW_DESC vd;
+				p_texture->GetDepthStencilViewDesc(subresource, vd);
+				p_device->CreateDepthStencilView(p_native, &vd, handle);
+			}
+
+			auto flags = D3D12_CLEAR_FLAG_DEPTH;
+			if (tex_desc.format == ResourceFormat::D24_Unorm_S8_Uint)
+			{
+				flags |= D3D12_CLEAR_FLAG_STENCIL;
+			}
+			pCmdList_->ClearDepthStencilView(handle, flags, color[0], static_cast<UINT8>(color[1]), 0, nullptr);
+		}
+		else
+		{
+			assert(tex_desc.usageFlags & ResourceUsageFlag::RenderTarget);
+
+			D3D12_CPU_DESCRIPTOR_HANDLE handle;
+			if (subresource == 0 && p_texture->GetRenderTargetView().IsValid())
+			{
+				handle = p_texture->GetRenderTargetView().cpuHandle;
+			}
+			else if (AllocateClearView(false, p_native, subresource, handle))
+			{
+				D3D12_RENDER_TARGET_VIEW_DESC vd;
+				p_texture->GetRenderTargetViewDesc(subresource, vd);
+				p_device->CreateRenderTargetView(p_native, &vd, handle);
 			}
+			pCmdList_->ClearRenderTargetView(handle, color, 0, nullptr);
 		}
 	}
 
+	//-----------------------------------------------------------
+	// translate copy texture packet.
+	//-----------------------------------------------------------
+	void CommandList::TranslateCopyTexture(const CopyTexturePacket& packet)
+	{
+		D3D12_TEXTURE_COPY_LOCATION dst{};
+		dst.pResource = static_cast<Texture*>(packet.pDst)->GetNativeTexture();
+		dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+		dst.SubresourceIndex = packet.dstSubresource;
+
+		D3D12_TEXTURE_COPY_LOCATION src{};
+		src.pResource = static_cast<Texture*>(packet.pSrc)->GetNativeTexture();
+		src.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+		src.SubresourceIndex = packet.srcSubresource;
+
+		pCmdList_->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+	}
+
+	//-----------------------------------------------------------
+	// translate resolve texture packet.
+	//-----------------------------------------------------------
+	void CommandList::TranslateResolveTexture(const ResolveTexturePacket& packet)
+	{
+		pCmdList_->ResolveSubresource(
+			static_cast<Texture*>(packet.pDst)->GetNativeTexture(), packet.dstSubresource,
+			static_cast<Texture*>(packet.pSrc)->GetNativeTexture(), packet.srcSubresource,
+			GetNativeResourceFormat(packet.pDst->GetDesc().format));
+	}
+
+	//-----------------------------------------------------------
+	// translate recorded command stream to native command list.
+	//-----------------------------------------------------------
+	void CommandList::TranslateCommandStream(const CommandStream& stream)
+	{
+		stream.ForEach([&](const CommandPacketHeader& header)
+		{
+			switch (header.type)
+			{
+			case CommandPacketType::ClearTexture:
+				TranslateClearTexture(CommandStream::Cast<ClearTexturePacket>(header));
+				break;
+			case CommandPacketType::CopyTexture:
+				TranslateCopyTexture(CommandStream::Cast<CopyTexturePacket>(header));
+				break;
+			case CommandPacketType::ResolveTexture:
+				TranslateResolveTexture(CommandStream::Cast<ResolveTexturePacket>(header));
+				break;
+			case CommandPacketType::ExecuteBundle:
+				// native bundles can not clear, copy or resolve, bundle stream is translated inline.
+				TranslateCommandStream(CommandStream::Cast<ExecuteBundlePacket>(header).pBundle->GetCommandStream());
+				break;
+			default:
+				assert(false);
+				break;
+			}
+		});
+	}
+
 
 #define Self()	static_cast<CommandList*>(this)
 
@@ -100,18 +359,9 @@ namespace mll
 	void ICommandList::Begin()
 	{
 		auto p_this = Self();
-
-		auto hr = p_this->GetNativeCmdAllocator()->Reset();
-		assert(SUCCEEDED(hr));
-
-		hr = p_this->GetNativeCmdList()->Reset(p_this->GetNativeCmdAllocator(), nullptr);
-		assert(SUCCEEDED(hr));
-
-		if (desc_.typeCommandQueue == CommandQueueType::Graphics || desc_.typeCommandQueue == CommandQueueType::Compute)
-		{
-			p_this->GetResourceDescriptorStack()->Reset();
-			p_this->GetSamplerDescriptorStack()->Reset();
-		}
+		assert(!p_this->isRecording_);
+		p_this->isRecording_ = true;
+		p_this->ResetStream();
 	}
 
 	//-----------------------------------------------------------
@@ -120,8 +370,17 @@ namespace mll
 	void ICommandList::End()
 	{
 		auto p_this = Self();
-		auto hr = p_this->GetNativeCmdList()->Close();
-		assert(SUCCEEDED(hr));
+		assert(p_this->isRecording_);
+		p_this->isRecording_ = false;
+		p_this->stateStats_ = CommandStateStats();
+
+		if (IsBundle())
+		{
+			// bundle keeps command stream only.
+			return;
+		}
+
+		p_this->Translate();
 	}
 
 #undef Self
@@ -2,6 +2,7 @@
 
 #include "native.h"
 
+#include "command_allocator_pool.h"
 #include "descriptor_util.h"
 
 
@@ -11,11 +12,16 @@ namespace mll
 
 	//-----------------------------------------------------------
 	//! @brief command list.
+	//!
+	//! Bundle has no native command list, its stream is translated into command lists executing it.
 	//-----------------------------------------------------------
 	class CommandList
 		: public ICommandList
 	{
+		MLL_DECLARE_POOL_ALLOCATOR();
+
 		friend class IDevice;
+		friend class ICommandList;
 
 	public:
 		/**
@@ -23,6 +29,20 @@ namespace mll
 		*/
 		void SetDescriptorHeap();
 
+		/**
+		 * @brief hold descriptors again before command list is submitted again.
+		 *
+		 * @note Command list is translated again if descriptor ring reused them.
+		*/
+		void PrepareSubmit();
+
+		/**
+		 * @brief set fence value of submission and return descriptor blocks to ring.
+		 *
+		 * @note Allocator is returned to pool with this value at next End.
+		*/
+		void OnSubmitted(u64 fenceValue);
+
 		// getter
 		ID3D12CommandAllocator* GetNativeCmdAllocator()
 		{
@@ -41,6 +61,14 @@ namespace mll
 			return pSamplerDescriptorStack_;
 		}
 
+		/**
+		 * @brief find or allocate CPU descriptor for clear view of subresource.
+		 *
+		 * @return					true if view is newly allocated and must be created.
+		 * @note Views are valid until next End.
+		*/
+		bool AllocateClearView(bool isDepth, ID3D12Resource* pResource, u32 subresource, D3D12_CPU_DESCRIPTOR_HANDLE& outHandle);
+
 	private:
 		CommandList()
 			: ICommandList()
@@ -53,15 +81,57 @@ namespace mll
 		Result::Type Initialize(Device* pDevice, const CommandListDesc& desc);
 		void Destroy();
 
+		/**
+		 * @brief return allocator to pool.
+		*/
+		void ReleaseAllocator();
+
+		/**
+		 * @brief record native command list from command stream with completed allocator.
+		*/
+		void Translate();
+
+		/**
+		 * @brief translate recorded command stream to native command list.
+		 *
+		 * @note Executed bundles are translated recursively.
+		*/
+		void TranslateCommandStream(const CommandStream& stream);
+		void TranslateClearTexture(const ClearTexturePacket& packet);
+		void TranslateCopyTexture(const CopyTexturePacket& packet);
+		void TranslateResolveTexture(const ResolveTexturePacket& packet);
+
 		/**
 		 * @brief Release self.
 		*/
 		void Release() override;
 
+		/**
+		 * @brief Propagate object name to native object.
+		*/
+		void OnObjectNameChanged() override;
+
 	private:
-		ID3D12CommandAllocator*		pCmdAllocator_ = nullptr;
+		CommandAllocatorPool*		pAllocatorPool_ = nullptr;
+		ID3D12CommandAllocator*		pCmdAllocator_ = nullptr;		// held from End until next End.
+		u64							submittedFenceValue_ = 0;
+		u64							recordBytes_ = 0;
 		NativeCommandList*			pCmdList_ = nullptr;
 
+		struct ClearViewKey
+		{
+			ID3D12Resource*		pResource;
+			u32					subresource;
+		};	// struct ClearViewKey
+
+		ID3D12DescriptorHeap*		pClearViewHeaps_[2] = {};		// RTV, DSV
+		u32							clearViewSizes_[2] = {};
+		u32							clearViewCounts_[2] = {};
+		std::vector<ClearViewKey>	clearViewKeys_[2];				// subresources of created views.
+
+		using DescriptorHeapPair = std::pair<ID3D12DescriptorHeap*, ID3D12DescriptorHeap*>;
+		ShadowState<DescriptorHeapPair>	descriptorHeaps_;			// resource, sampler
+
 		std::unique_ptr<ResourceDescriptorStack>	pResourceDescriptorStack_;
 		std::unique_ptr<SamplerDescriptorStack>		pSamplerDescriptorStack_;
 	};	// class CommandList
@@ -2,6 +2,8 @@
 
 #include <cassert>
 #include <algorithm>
+#include <atomic>
+#include <cstring>
 
 #include "device.h"
 #include "command_list.h"
@@ -11,26 +13,87 @@ namespace mll
 {
 	namespace
 	{
-		static const u32	kDefaultResourceHeapSize = 2048;
-		static const u32	kMaxSamplerHeapSize = 2048;
+		static const u32	kDescriptorBlockSize = 256;		// ring lock is taken once per block.
+		static const u32	kInitialTableSlotCount = 64;	// per command list table hash, power of two.
+		static const u32	kSamplerTableSize = SamplerDescriptorCache::kHeapSize * 2;		// open addressing slots, power of two.
+
+		// live CPU descriptor allocators, thread caches return indices to their owner through this.
+		std::mutex& GetCpuAllocatorRegistryMutex()
+		{
+			static std::mutex s_mutex;
+			return s_mutex;
+		}
+		std::vector<CpuDescriptorAllocator*>& GetCpuAllocatorRegistry()
+		{
+			static std::vector<CpuDescriptorAllocator*> s_allocators;
+			return s_allocators;
+		}
+		std::atomic<u64> g_cpuAllocatorId{ 0 };
 	}
 
 	//-----------------------------------------------------------
-	// destructor for descriptor stack heap.
+	// push index with currently signaled fence values.
 	//-----------------------------------------------------------
-	DescriptorStackHeap::~DescriptorStackHeap()
+	void DeferredIndexQueue::Push(CommandQueue* pQueue, u32 index)
 	{
-		SafeRelease(pHeap_);
+		Entry entry;
+		entry.index = index;
+		for (u32 type = 0; type < CommandQueueType::MAX; type++)
+		{
+			entry.fenceValues[type] = pQueue->GetSignaledFenceValue(static_cast<CommandQueueType::Type>(type));
+		}
+		entries_.push_back(entry);
 	}
 
 	//-----------------------------------------------------------
-	// initialize descriptor stack heap.
+	// pop indices whose fences are completed.
 	//-----------------------------------------------------------
-	Result::Type DescriptorStackHeap::Initialize(Device* pDevice, D3D12_DESCRIPTOR_HEAP_TYPE type, u32 stackSize)
+	void DeferredIndexQueue::Retire(CommandQueue* pQueue, bool bWaitOldest, std::vector<u32>& outIndices)
+	{
+		if (entries_.empty())
+		{
+			return;
+		}
+
+		if (bWaitOldest)
+		{
+			auto&& front = entries_.front();
+			for (u32 type = 0; type < CommandQueueType::MAX; type++)
+			{
+				pQueue->WaitFence(static_cast<CommandQueueType::Type>(type), front.fenceValues[type]);
+			}
+		}
+
+		u64 completed[CommandQueueType::MAX];
+		for (u32 type = 0; type < CommandQueueType::MAX; type++)
+		{
+			completed[type] = pQueue->GetCompletedFenceValue(static_cast<CommandQueueType::Type>(type));
+		}
+		while (!entries_.empty())
+		{
+			auto&& front = entries_.front();
+			bool is_completed = true;
+			for (u32 type = 0; type < CommandQueueType::MAX; type++)
+			{
+				is_completed = is_completed && (front.fenceValues[type] <= completed[type]);
+			}
+			if (!is_completed)
+			{
+				break;
+			}
+			outIndices.push_back(front.index);
+			entries_.pop_front();
+		}
+	}
+
+	//-----------------------------------------------------------
+	// initialize descriptor ring.
+	//-----------------------------------------------------------
+	Result::Type DescriptorRing::Initialize(Device* pDevice, CommandQueueType::Type type, u32 size, u32 reservedCount)
 	{
 		D3D12_DESCRIPTOR_HEAP_DESC desc{};
-		desc.Type = type;
-		desc.NumDescriptors = stackSize;
+		desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+		desc.NumDescriptors = reservedCount + size;
 		desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 		desc.NodeMask = GetNodeMask();
 
@@ -40,32 +103,160 @@ namespace mll
 			return Result::OutOfMemory;
 		}
 
+		pDevice_ = pDevice;
+		type_ = type;
 		cpuHandleStart_ = pHeap_->GetCPUDescriptorHandleForHeapStart();
 		gpuHandleStart_ = pHeap_->GetGPUDescriptorHandleForHeapStart();
 		descSize_ = pDevice->GetNativeDevice()->GetDescriptorHandleIncrementSize(desc.Type);
-		stackMax_ = stackSize;
-		stackPosition_ = 0;
+		size_ = size;
+		reservedCount_ = reservedCount;
+		head_ = tail_ = 0;
+		stats_ = DescriptorRingStats();
+		stats_.capacity = size;
 
 		return Result::Ok;
 	}
 
 	//-----------------------------------------------------------
-	// allocate from stack heap.
+	// destroy descriptor ring.
+	//-----------------------------------------------------------
+	void DescriptorRing::Destroy()
+	{
+		// all command lists are destroyed and queues are idle here.
+		for (auto&& block : blocks_)
+		{
+			assert(!block.isHeld);
+			(void)block;
+		}
+		blocks_.clear();
+		SafeRelease(pHeap_);
+	}
+
+	//-----------------------------------------------------------
+	// advance tail over completed blocks.
+	//-----------------------------------------------------------
+	void DescriptorRing::Retire(u64 completedFenceValue)
+	{
+		// held block stops tail even if later blocks are completed.
+		while (!blocks_.empty())
+		{
+			auto&& block = blocks_.front();
+			if (block.isHeld || block.fenceValue > completedFenceValue)
+			{
+				break;
+			}
+			tail_ = block.end;
+			blocks_.pop_front();
+		}
+		if (blocks_.empty())
+		{
+			tail_ = head_;
+		}
+		stats_.usedCount = static_cast<u32>(head_ - tail_);
+	}
+
+	//-----------------------------------------------------------
+	// take block from ring head.
 	//-----------------------------------------------------------
-	Result::Type DescriptorStackHeap::Allocate(u32 count, D3D12_CPU_DESCRIPTOR_HANDLE& outCpu, D3D12_GPU_DESCRIPTOR_HANDLE& outGpu)
+	Result::Type DescriptorRing::AcquireBlock(u32 count, u64& outBlock, u32& outIndex)
 	{
-		if (stackPosition_ + count < stackMax_)
+		assert(count > 0);
+		if (count > size_)
 		{
 			return Result::OutOfMemory;
 		}
 
-		outCpu = cpuHandleStart_;
-		outGpu = gpuHandleStart_;
-		outCpu.ptr += ((SIZE_T)stackPosition_ * (SIZE_T)descSize_);
-		outGpu.ptr += ((u64)stackPosition_ * (u64)descSize_);
-		stackPosition_ += count;
+		auto p_queue = pDevice_->GetCommandQueue();
+		auto completed = p_queue->GetCompletedFenceValue(type_);
 
-		return Result::Ok;
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (;;)
+		{
+			Retire(completed);
+
+			// block is contiguous, skip ring end if it does not fit.
+			u32 offset = static_cast<u32>(head_ % size_);
+			u32 padding = (offset + count > size_) ? size_ - offset : 0;
+			u64 end = head_ + padding + count;
+			if (end - tail_ <= size_)
+			{
+				blocks_.push_back(Block{ head_, end, 0, true });
+				outBlock = head_;
+				outIndex = reservedCount_ + (offset + padding) % size_;
+				head_ = end;
+
+				stats_.usedCount = static_cast<u32>(head_ - tail_);
+				stats_.peakUsedCount = std::max(stats_.peakUsedCount, stats_.usedCount);
+				stats_.allocatedCount += count;
+				stats_.blockCount++;
+				return Result::Ok;
+			}
+
+			if (blocks_.empty())
+			{
+				// block does not fit after padding, restart from heap start.
+				head_ = tail_ = (head_ + size_ - 1) / size_ * size_;
+				continue;
+			}
+
+			// ring is full, wait oldest block if GPU is still using it.
+			auto&& front = blocks_.front();
+			if (front.isHeld)
+			{
+				return Result::OutOfMemory;
+			}
+			stats_.waitCount++;
+			p_queue->WaitFence(type_, front.fenceValue);
+			completed = std::max(completed, front.fenceValue);
+		}
+	}
+
+	//-----------------------------------------------------------
+	// return block to ring.
+	//-----------------------------------------------------------
+	void DescriptorRing::ReleaseBlock(u64 block, u64 fenceValue)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (auto&& b : blocks_)
+		{
+			if (b.begin == block)
+			{
+				assert(b.isHeld);
+				b.isHeld = false;
+				b.fenceValue = fenceValue;
+				return;
+			}
+		}
+		assert(!"descriptor block is not found.");
+	}
+
+	//-----------------------------------------------------------
+	// hold returned blocks again.
+	//-----------------------------------------------------------
+	bool DescriptorRing::HoldBlocks(const u64* pBlocks, u32 count)
+	{
+		if (count == 0)
+		{
+			return true;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		// tail passes blocks in ring order, later blocks remain if the first one remains.
+		auto less = [](const Block& b, u64 pos) { return b.begin < pos; };
+		auto it = std::lower_bound(blocks_.begin(), blocks_.end(), pBlocks[0], less);
+		if (it == blocks_.end() || it->begin != pBlocks[0])
+		{
+			return false;
+		}
+		for (u32 i = 0; i < count; i++)
+		{
+			it = std::lower_bound(it, blocks_.end(), pBlocks[i], less);
+			assert(it != blocks_.end() && it->begin == pBlocks[i]);
+			assert(!it->isHeld);
+			it->isHeld = true;
+		}
+		return true;
 	}
 
 
@@ -74,81 +265,533 @@ namespace mll
 	//-----------------------------------------------------------
 	ResourceDescriptorStack::~ResourceDescriptorStack()
 	{
-		heaps_.clear();
+		// command list returns blocks with fence value before destruction.
+		assert(blocks_.empty());
 	}
 
 	//-----------------------------------------------------------
 	// initialize resource descriptor stack.
 	//-----------------------------------------------------------
-	Result::Type ResourceDescriptorStack::Initialize(Device* pDevice)
+	Result::Type ResourceDescriptorStack::Initialize(Device* pDevice, DescriptorRing* pRing)
 	{
 		assert(pDevice != nullptr);
+		assert(pRing != nullptr);
 
 		pParentDevice_ = pDevice;
+		pRing_ = pRing;
+		slots_.assign(kInitialTableSlotCount, 0);
 
 		return Result::Ok;
 	}
 
 	//-----------------------------------------------------------
-	// reset stack.
+	// return held blocks to ring.
 	//-----------------------------------------------------------
-	void ResourceDescriptorStack::Reset()
+	void ResourceDescriptorStack::Release(u64 fenceValue)
 	{
-		u32 stack_size = kDefaultResourceHeapSize;
+		// blocks returned at submission are not released twice.
+		if (isHeld_)
+		{
+			for (auto block : blocks_)
+			{
+				pRing_->ReleaseBlock(block, fenceValue);
+			}
+		}
+		blocks_.clear();
+		isHeld_ = true;
+		blockIndex_ = blockPosition_ = blockSize_ = 0;
+
+		// copied tables are gone with blocks.
+		tables_.clear();
+		std::fill(slots_.begin(), slots_.end(), 0);
+		srcHandles_.clear();
+		stagedDst_.clear();
+		stagedSizes_.clear();
+		flushedSrcCount_ = 0;
+	}
 
-		if (heaps_.size() > 1)
+	//-----------------------------------------------------------
+	// return blocks to ring at submission.
+	//-----------------------------------------------------------
+	void ResourceDescriptorStack::Submit(u64 fenceValue)
+	{
+		assert(stagedDst_.empty());
+		if (isHeld_)
 		{
-			stack_size = heaps_[0]->GetStackMax() * (u32)heaps_.size();
-			heaps_.clear();
+			// kept command list does not stop ring tail.
+			for (auto block : blocks_)
+			{
+				pRing_->ReleaseBlock(block, fenceValue);
+			}
+			isHeld_ = false;
 		}
+	}
 
-		if (heaps_.empty())
+	//-----------------------------------------------------------
+	// hold blocks returned at previous submission again.
+	//-----------------------------------------------------------
+	bool ResourceDescriptorStack::Hold()
+	{
+		if (!isHeld_)
 		{
-			std::unique_ptr<DescriptorStackHeap> heap(new DescriptorStackHeap());
-			auto result = heap->Initialize(pParentDevice_, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, stack_size);
-			assert(IsSucceeded(result));
+			isHeld_ = pRing_->HoldBlocks(blocks_.data(), static_cast<u32>(blocks_.size()));
+		}
+		return isHeld_;
+	}
 
-			heaps_.push_back(std::move(heap));
+	//-----------------------------------------------------------
+	// find slot of table, or empty slot to insert.
+	//-----------------------------------------------------------
+	u32 ResourceDescriptorStack::FindSlot(u64 hash, u32 count, const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcCpu) const
+	{
+		const u32 mask = static_cast<u32>(slots_.size()) - 1;
+		for (u32 slot = static_cast<u32>(hash) & mask; ; slot = (slot + 1) & mask)
+		{
+			if (slots_[slot] == 0)
+			{
+				return slot;
+			}
+			auto&& table = tables_[slots_[slot] - 1];
+			if (table.hash == hash && table.count == count
+				&& memcmp(&srcHandles_[table.srcOffset], pSrcCpu, sizeof(pSrcCpu[0]) * count) == 0)
+			{
+				return slot;
+			}
 		}
+	}
 
-		pCurrentHeap_ = heaps_[0].get();
-		pCurrentHeap_->Reset();
-		MarkHeapDirty();
+	//-----------------------------------------------------------
+	// resize table hash.
+	//-----------------------------------------------------------
+	void ResourceDescriptorStack::Rehash(u32 slotCount)
+	{
+		slots_.assign(slotCount, 0);
+		const u32 mask = slotCount - 1;
+		for (u32 i = 0; i < tables_.size(); i++)
+		{
+			u32 slot = static_cast<u32>(tables_[i].hash) & mask;
+			while (slots_[slot] != 0)
+			{
+				slot = (slot + 1) & mask;
+			}
+			slots_[slot] = i + 1;
+		}
 	}
 
 	//-----------------------------------------------------------
-	// allocate handle from stack and copy cpu handles.
+	// find or allocate table and stage copy.
 	//-----------------------------------------------------------
-	void ResourceDescriptorStack::AllocateAndCopy(u32 count, const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcCpu, D3D12_CPU_DESCRIPTOR_HANDLE* pOutCpu, D3D12_GPU_DESCRIPTOR_HANDLE* pOutGpu)
+	Result::Type ResourceDescriptorStack::AllocateAndCopy(u32 count, const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcCpu, D3D12_CPU_DESCRIPTOR_HANDLE* pOutCpu, D3D12_GPU_DESCRIPTOR_HANDLE* pOutGpu)
 	{
-		// try allocate from current heap.
-		D3D12_CPU_DESCRIPTOR_HANDLE cpu_handle;
-		D3D12_GPU_DESCRIPTOR_HANDLE gpu_handle;
-		auto result = pCurrentHeap_->Allocate(count, cpu_handle, gpu_handle);
-		if (IsFailed(result))
+		assert(count > 0);
+		assert(isHeld_);
+
+		// many draws bind the same table, reuse it while blocks are held.
+		u64 hash = CalcHash64(pSrcCpu, sizeof(pSrcCpu[0]) * count);
+		u32 slot = FindSlot(hash, count, pSrcCpu);
+		u32 heap_index;
+		if (slots_[slot] != 0)
+		{
+			heap_index = tables_[slots_[slot] - 1].heapIndex;
+		}
+		else
 		{
-			// create new heap because current heap is lack!
-			std::unique_ptr<DescriptorStackHeap> heap(new DescriptorStackHeap());
-			auto result = heap->Initialize(pParentDevice_, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, std::max(pCurrentHeap_->GetStackMax(), count));
-			assert(IsSucceeded(result));
+			// take next block when current block is lack, heap is not changed.
+			if (blockPosition_ + count > blockSize_)
+			{
+				u32 block_size = std::max(kDescriptorBlockSize, count);
+				u64 block;
+				u32 block_index;
+				auto result = pRing_->AcquireBlock(block_size, block, block_index);
+				if (IsFailed(result))
+				{
+					// current block is kept, caller may retry after submission.
+					return result;
+				}
+
+				blocks_.push_back(block);
+				blockIndex_ = block_index;
+				blockPosition_ = 0;
+				blockSize_ = block_size;
+			}
+
+			heap_index = blockIndex_ + blockPosition_;
+			blockPosition_ += count;
 
-			pCurrentHeap_ = heap.get();
-			heaps_.push_back(std::move(heap));
-			MarkHeapDirty();
+			// stage copy.
+			u32 src_offset = static_cast<u32>(srcHandles_.size());
+			srcHandles_.insert(srcHandles_.end(), pSrcCpu, pSrcCpu + count);
+			stagedDst_.push_back(pRing_->GetCpuHandle(heap_index));
+			stagedSizes_.push_back(count);
 
-			// allocater from current heap.
-			result = pCurrentHeap_->Allocate(count, cpu_handle, gpu_handle);
-			assert(IsSucceeded(result));
+			tables_.push_back(Table{ hash, src_offset, count, heap_index });
+			slots_[slot] = static_cast<u32>(tables_.size());
+			if (tables_.size() * 2 > slots_.size())
+			{
+				Rehash(static_cast<u32>(slots_.size()) * 2);
+			}
 		}
 
-		// copy descriptors.
+		if (pOutCpu) *pOutCpu = pRing_->GetCpuHandle(heap_index);
+		if (pOutGpu) *pOutGpu = pRing_->GetGpuHandle(heap_index);
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// copy all staged tables at once.
+	//-----------------------------------------------------------
+	void ResourceDescriptorStack::Flush()
+	{
+		if (stagedDst_.empty())
+		{
+			return;
+		}
+
+		// source ranges are one descriptor each, destination ranges are tables.
+		u32 src_count = static_cast<u32>(srcHandles_.size()) - flushedSrcCount_;
 		pParentDevice_->GetNativeDevice()->CopyDescriptors(
-			1, &cpu_handle, &count,
-			count, pSrcCpu, nullptr,
+			static_cast<UINT>(stagedDst_.size()), stagedDst_.data(), stagedSizes_.data(),
+			src_count, srcHandles_.data() + flushedSrcCount_, nullptr,
 			D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
-		if (pOutCpu) *pOutCpu = cpu_handle;
-		if (pOutGpu) *pOutGpu = gpu_handle;
+		stagedDst_.clear();
+		stagedSizes_.clear();
+		flushedSrcCount_ = static_cast<u32>(srcHandles_.size());
+	}
+
+	//-----------------------------------------------------------
+	// initialize sampler descriptor cache.
+	//-----------------------------------------------------------
+	Result::Type SamplerDescriptorCache::Initialize(Device* pDevice)
+	{
+		D3D12_DESCRIPTOR_HEAP_DESC desc{};
+		desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER;
+		desc.NumDescriptors = kHeapSize;
+		desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+		desc.NodeMask = GetNodeMask();
+
+		auto hr = pDevice->GetNativeDevice()->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&pHeap_));
+		if (FAILED(hr))
+		{
+			return Result::OutOfMemory;
+		}
+
+		pDevice_ = pDevice;
+		cpuHandleStart_ = pHeap_->GetCPUDescriptorHandleForHeapStart();
+		gpuHandleStart_ = pHeap_->GetGPUDescriptorHandleForHeapStart();
+		descSize_ = pDevice->GetNativeDevice()->GetDescriptorHandleIncrementSize(desc.Type);
+
+		// every table has one sampler at least, so entries never exceed heap size.
+		entries_.resize(kHeapSize);
+		freeEntries_.resize(kHeapSize);
+		for (u32 i = 0; i < kHeapSize; i++)
+		{
+			freeEntries_[i] = kHeapSize - 1 - i;
+		}
+		table_.assign(kSamplerTableSize, 0);
+		stats_ = SamplerCacheStats();
+		stats_.capacity = kHeapSize;
+
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// destroy sampler descriptor cache.
+	//-----------------------------------------------------------
+	void SamplerDescriptorCache::Destroy()
+	{
+		// all command lists are destroyed here.
+		for (u32 e = lruHead_; e != kInvalidEntry; e = entries_[e].lruNext)
+		{
+			assert(entries_[e].holdCount == 0);
+		}
+		entries_.clear();
+		freeEntries_.clear();
+		table_.clear();
+		lruHead_ = lruTail_ = kInvalidEntry;
+		SafeRelease(pHeap_);
+	}
+
+	//-----------------------------------------------------------
+	// find table slot of sampler set, or empty slot to insert.
+	//-----------------------------------------------------------
+	u32 SamplerDescriptorCache::FindSlot(u64 hash, u32 count, const D3D12_SAMPLER_DESC* pDescs) const
+	{
+		const u32 mask = kSamplerTableSize - 1;
+		u32 slot = static_cast<u32>(hash) & mask;
+		while (table_[slot] != 0)
+		{
+			// hash is only a filter, whole description set is compared.
+			auto&& entry = entries_[table_[slot] - 1];
+			if (entry.hash == hash && entry.count == count
+				&& memcmp(&keys_[entry.heapIndex], pDescs, sizeof(pDescs[0]) * count) == 0)
+			{
+				return slot;
+			}
+			slot = (slot + 1) & mask;
+		}
+		return slot;
+	}
+
+	//-----------------------------------------------------------
+	// remove entry from table with backward shift.
+	//-----------------------------------------------------------
+	void SamplerDescriptorCache::RemoveFromTable(u32 entry)
+	{
+		const u32 mask = kSamplerTableSize - 1;
+		u32 slot = static_cast<u32>(entries_[entry].hash) & mask;
+		while (table_[slot] != entry + 1)
+		{
+			assert(table_[slot] != 0);
+			slot = (slot + 1) & mask;
+		}
+
+		// move following entries back unless it passes their home slot.
+		table_[slot] = 0;
+		u32 next = (slot + 1) & mask;
+		while (table_[next] != 0)
+		{
+			u32 home = static_cast<u32>(entries_[table_[next] - 1].hash) & mask;
+			if (((next - home) & mask) >= ((next - slot) & mask))
+			{
+				table_[slot] = table_[next];
+				table_[next] = 0;
+				slot = next;
+			}
+			next = (next + 1) & mask;
+		}
+	}
+
+	//-----------------------------------------------------------
+	// find contiguous free descriptors in heap.
+	//-----------------------------------------------------------
+	bool SamplerDescriptorCache::AllocateRange(u32 count, u32& outIndex)
+	{
+		u32 run = 0;
+		for (u32 i = 0; i < kHeapSize; i++)
+		{
+			if (usedBits_[i / 64] == ~0ull)
+			{
+				run = 0;
+				i += 63 - (i % 64);
+				continue;
+			}
+			if (usedBits_[i / 64] & (1ull << (i % 64)))
+			{
+				run = 0;
+				continue;
+			}
+			if (++run == count)
+			{
+				outIndex = i + 1 - count;
+				for (u32 j = outIndex; j <= i; j++)
+				{
+					usedBits_[j / 64] |= 1ull << (j % 64);
+				}
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//-----------------------------------------------------------
+	// free descriptors in heap.
+	//-----------------------------------------------------------
+	void SamplerDescriptorCache::FreeRange(u32 index, u32 count)
+	{
+		for (u32 j = index; j < index + count; j++)
+		{
+			usedBits_[j / 64] &= ~(1ull << (j % 64));
+		}
+	}
+
+	//-----------------------------------------------------------
+	// link entry as most recently used.
+	//-----------------------------------------------------------
+	void SamplerDescriptorCache::LinkFront(u32 entry)
+	{
+		auto&& e = entries_[entry];
+		e.lruPrev = kInvalidEntry;
+		e.lruNext = lruHead_;
+		if (lruHead_ != kInvalidEntry)
+		{
+			entries_[lruHead_].lruPrev = entry;
+		}
+		lruHead_ = entry;
+		if (lruTail_ == kInvalidEntry)
+		{
+			lruTail_ = entry;
+		}
+	}
+
+	//-----------------------------------------------------------
+	// unlink entry from LRU list.
+	//-----------------------------------------------------------
+	void SamplerDescriptorCache::Unlink(u32 entry)
+	{
+		auto&& e = entries_[entry];
+		if (e.lruPrev != kInvalidEntry)
+		{
+			entries_[e.lruPrev].lruNext = e.lruNext;
+		}
+		else
+		{
+			lruHead_ = e.lruNext;
+		}
+		if (e.lruNext != kInvalidEntry)
+		{
+			entries_[e.lruNext].lruPrev = e.lruPrev;
+		}
+		else
+		{
+			lruTail_ = e.lruPrev;
+		}
+	}
+
+	//-----------------------------------------------------------
+	// check GPU has completed all submissions using entry.
+	//-----------------------------------------------------------
+	bool SamplerDescriptorCache::IsCompleted(const Entry& entry, const u64* pCompletedValues) const
+	{
+		for (u32 type = 0; type < CommandQueueType::MAX; type++)
+		{
+			if (entry.fenceValues[type] > pCompletedValues[type])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//-----------------------------------------------------------
+	// find or create sampler table.
+	//-----------------------------------------------------------
+	u32 SamplerDescriptorCache::Acquire(u32 count, const D3D12_SAMPLER_DESC* pDescs, u32& outHeapIndex)
+	{
+		assert(count > 0 && count <= kHeapSize);
+		u64 hash = CalcHash64(pDescs, sizeof(pDescs[0]) * count);
+
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		u32 slot = FindSlot(hash, count, pDescs);
+		if (table_[slot] != 0)
+		{
+			u32 entry = table_[slot] - 1;
+			auto&& e = entries_[entry];
+			e.holdCount++;
+			Unlink(entry);
+			LinkFront(entry);
+			stats_.hitCount++;
+			outHeapIndex = e.heapIndex;
+			return entry;
+		}
+		stats_.missCount++;
+
+		// evict least recently used tables until set fits.
+		auto p_queue = pDevice_->GetCommandQueue();
+		u64 completed[CommandQueueType::MAX];
+		for (u32 type = 0; type < CommandQueueType::MAX; type++)
+		{
+			completed[type] = p_queue->GetCompletedFenceValue(static_cast<CommandQueueType::Type>(type));
+		}
+		u32 heap_index = 0;
+		while (!AllocateRange(count, heap_index))
+		{
+			u32 victim = lruTail_;
+			u32 pending = kInvalidEntry;
+			for (; victim != kInvalidEntry; victim = entries_[victim].lruPrev)
+			{
+				auto&& e = entries_[victim];
+				if (e.holdCount > 0)
+				{
+					continue;
+				}
+				if (IsCompleted(e, completed))
+				{
+					break;
+				}
+				if (pending == kInvalidEntry)
+				{
+					pending = victim;
+				}
+			}
+
+			if (victim == kInvalidEntry)
+			{
+				if (pending == kInvalidEntry)
+				{
+					// every table is held by command lists.
+					return kInvalidEntry;
+				}
+
+				// wait least recently used table which GPU may still read.
+				stats_.waitCount++;
+				for (u32 type = 0; type < CommandQueueType::MAX; type++)
+				{
+					auto value = entries_[pending].fenceValues[type];
+					if (value > completed[type])
+					{
+						p_queue->WaitFence(static_cast<CommandQueueType::Type>(type), value);
+						completed[type] = value;
+					}
+				}
+				continue;
+			}
+
+			auto&& e = entries_[victim];
+			RemoveFromTable(victim);
+			Unlink(victim);
+			FreeRange(e.heapIndex, e.count);
+			freeEntries_.push_back(victim);
+			stats_.entryCount--;
+			stats_.usedCount -= e.count;
+			stats_.evictCount++;
+		}
+
+		// create samplers in heap.
+		auto p_native = pDevice_->GetNativeDevice();
+		for (u32 i = 0; i < count; i++)
+		{
+			p_native->CreateSampler(&pDescs[i], GetCpuHandle(heap_index + i));
+			keys_[heap_index + i] = pDescs[i];
+		}
+
+		assert(!freeEntries_.empty());
+		u32 entry = freeEntries_.back();
+		freeEntries_.pop_back();
+		auto&& e = entries_[entry];
+		e.hash = hash;
+		e.heapIndex = heap_index;
+		e.count = count;
+		e.holdCount = 1;
+		for (auto&& v : e.fenceValues)
+		{
+			v = 0;
+		}
+		LinkFront(entry);
+
+		// eviction may shift entries, so slot is searched again.
+		slot = FindSlot(hash, count, pDescs);
+		assert(table_[slot] == 0);
+		table_[slot] = entry + 1;
+
+		stats_.entryCount++;
+		stats_.usedCount += count;
+		stats_.peakUsedCount = std::max(stats_.peakUsedCount, stats_.usedCount);
+		outHeapIndex = heap_index;
+		return entry;
+	}
+
+	//-----------------------------------------------------------
+	// release held table.
+	//-----------------------------------------------------------
+	void SamplerDescriptorCache::Release(u32 entry, CommandQueueType::Type type, u64 fenceValue)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto&& e = entries_[entry];
+		assert(e.holdCount > 0);
+		e.holdCount--;
+		e.fenceValues[type] = std::max(e.fenceValues[type], fenceValue);
 	}
 
 
@@ -157,89 +800,338 @@ namespace mll
 	//-----------------------------------------------------------
 	SamplerDescriptorStack::~SamplerDescriptorStack()
 	{
-		heaps_.clear();
+		// command list releases tables with fence value before destruction.
+		assert(heldEntries_.empty());
 	}
 
 	//-----------------------------------------------------------
-	// add descriptor stack heap.
+	// initialize sampler descriptor stack.
 	//-----------------------------------------------------------
-	void SamplerDescriptorStack::AddHeap()
+	Result::Type SamplerDescriptorStack::Initialize(SamplerDescriptorCache* pCache, CommandQueueType::Type type)
 	{
-		std::unique_ptr<DescriptorStackHeap> heap(new DescriptorStackHeap());
-		auto result = heap->Initialize(pParentDevice_, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, kMaxSamplerHeapSize);
-		assert(IsSucceeded(result));
+		assert(pCache != nullptr);
+
+		pCache_ = pCache;
+		type_ = type;
 
-		pLastAllocateHeap_ = heap.get();
-		heaps_.push_back(std::move(heap));
+		return Result::Ok;
 	}
 
 	//-----------------------------------------------------------
-	// initialize resource descriptor stack.
+	// release held tables.
 	//-----------------------------------------------------------
-	Result::Type SamplerDescriptorStack::Initialize(Device* pDevice)
+	void SamplerDescriptorStack::Release(u64 fenceValue)
 	{
-		assert(pDevice != nullptr);
+		for (auto entry : heldEntries_)
+		{
+			pCache_->Release(entry, type_, fenceValue);
+		}
+		heldEntries_.clear();
+	}
 
-		pParentDevice_ = pDevice;
-		AddHeap();
+	//-----------------------------------------------------------
+	// find or create sampler table.
+	//-----------------------------------------------------------
+	Result::Type SamplerDescriptorStack::Allocate(u32 count, const D3D12_SAMPLER_DESC* pDescs, D3D12_CPU_DESCRIPTOR_HANDLE* pOutCpu, D3D12_GPU_DESCRIPTOR_HANDLE* pOutGpu)
+	{
+		u32 heap_index = 0;
+		u32 entry = pCache_->Acquire(count, pDescs, heap_index);
+		if (entry == SamplerDescriptorCache::kInvalidEntry)
+		{
+			// held tables fill the heap, nothing is held for this call.
+			return Result::OutOfMemory;
+		}
+		heldEntries_.push_back(entry);
 
+		if (pOutCpu) *pOutCpu = pCache_->GetCpuHandle(heap_index);
+		if (pOutGpu) *pOutGpu = pCache_->GetGpuHandle(heap_index);
 		return Result::Ok;
 	}
 
 	//-----------------------------------------------------------
-	// reset stack.
+	// return cached indices of exiting thread.
 	//-----------------------------------------------------------
-	void SamplerDescriptorStack::Reset()
+	CpuDescriptorAllocator::ThreadCache::~ThreadCache()
 	{
-		pCurrentHeap_ = nullptr;
-		MarkHeapDirty();
+		if (count > 0)
+		{
+			ReturnToOwner(ownerId, indices, count);
+		}
 	}
 
 	//-----------------------------------------------------------
-	// allocate handle from stack and copy cpu handles.
+	// initialize CPU descriptor allocator.
 	//-----------------------------------------------------------
-	void SamplerDescriptorStack::AllocateAndCopy(u32 count, const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcCpu, D3D12_CPU_DESCRIPTOR_HANDLE* pOutCpu, D3D12_GPU_DESCRIPTOR_HANDLE* pOutGpu)
+	Result::Type CpuDescriptorAllocator::Initialize(Device* pDevice, D3D12_DESCRIPTOR_HEAP_TYPE type)
 	{
-		// calc hash.
-		u32 hash = CalcFnv1a32(pSrcCpu, sizeof(pSrcCpu[0]) * count);
+		pDevice_ = pDevice;
+		type_ = type;
+		descSize_ = pDevice->GetNativeDevice()->GetDescriptorHandleIncrementSize(type);
+		id_ = ++g_cpuAllocatorId;
 
-		// find cache.
-		auto it = caches_.find(hash);
-		if (it != caches_.end())
+		if (!AddPage())
+		{
+			return Result::OutOfMemory;
+		}
+
+		std::lock_guard<std::mutex> lock(GetCpuAllocatorRegistryMutex());
+		GetCpuAllocatorRegistry().push_back(this);
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// destroy CPU descriptor allocator.
+	//-----------------------------------------------------------
+	void CpuDescriptorAllocator::Destroy()
+	{
+		// indices left in thread caches are dropped when the threads use them next.
+		{
+			std::lock_guard<std::mutex> lock(GetCpuAllocatorRegistryMutex());
+			auto&& registry = GetCpuAllocatorRegistry();
+			registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (u32 i = 0; i < pageCount_; i++)
+		{
+			SafeRelease(pPages_[i]);
+		}
+		pageCount_ = 0;
+		freeIndices_.clear();
+		pendingFrees_.Clear();
+	}
+
+	//-----------------------------------------------------------
+	// get cache of calling thread, take it over from other allocator of same heap type.
+	//-----------------------------------------------------------
+	CpuDescriptorAllocator::ThreadCache& CpuDescriptorAllocator::GetThreadCache()
+	{
+		static thread_local ThreadCache s_caches[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+
+		auto&& cache = s_caches[type_];
+		if (cache.ownerId != id_)
+		{
+			if (cache.count > 0)
+			{
+				ReturnToOwner(cache.ownerId, cache.indices, cache.count);
+			}
+			cache.ownerId = id_;
+			cache.count = 0;
+		}
+		return cache;
+	}
+
+	//-----------------------------------------------------------
+	// return indices to allocator if it is alive.
+	//-----------------------------------------------------------
+	void CpuDescriptorAllocator::ReturnToOwner(u64 ownerId, const u32* pIndices, u32 count)
+	{
+		std::lock_guard<std::mutex> registry_lock(GetCpuAllocatorRegistryMutex());
+		for (auto p : GetCpuAllocatorRegistry())
+		{
+			if (p->id_ == ownerId)
+			{
+				std::lock_guard<std::mutex> lock(p->mutex_);
+				p->freeIndices_.insert(p->freeIndices_.end(), pIndices, pIndices + count);
+				return;
+			}
+		}
+	}
+
+	//-----------------------------------------------------------
+	// add heap page and push its indices. (lock must be taken)
+	//-----------------------------------------------------------
+	bool CpuDescriptorAllocator::AddPage()
+	{
+		if (pageCount_ >= kMaxPageCount)
+		{
+			return false;
+		}
+
+		D3D12_DESCRIPTOR_HEAP_DESC desc{};
+		desc.Type = type_;
+		desc.NumDescriptors = kPageSize;
+		desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+		desc.NodeMask = GetNodeMask();
+
+		auto hr = pDevice_->GetNativeDevice()->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&pPages_[pageCount_]));
+		if (FAILED(hr))
+		{
+			return false;
+		}
+		pageStarts_[pageCount_] = pPages_[pageCount_]->GetCPUDescriptorHandleForHeapStart().ptr;
+
+		// lower indices are popped first.
+		u32 base = pageCount_ * kPageSize;
+		for (u32 i = 0; i < kPageSize; i++)
+		{
+			freeIndices_.push_back(base + kPageSize - 1 - i);
+		}
+		pageCount_++;
+		return true;
+	}
+
+	//-----------------------------------------------------------
+	// move half of thread cache from shared free indices.
+	//-----------------------------------------------------------
+	bool CpuDescriptorAllocator::Refill(ThreadCache& cache)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		auto p_queue = pDevice_->GetCommandQueue();
+		pendingFrees_.Retire(p_queue, false, freeIndices_);
+		if (freeIndices_.empty() && !AddPage())
+		{
+			if (pendingFrees_.IsEmpty())
+			{
+				return false;
+			}
+			pendingFrees_.Retire(p_queue, true, freeIndices_);
+		}
+
+		u32 count = std::min<u32>(kThreadCacheSize / 2, static_cast<u32>(freeIndices_.size()));
+		for (u32 i = 0; i < count; i++)
+		{
+			cache.indices[cache.count++] = freeIndices_.back();
+			freeIndices_.pop_back();
+		}
+		return true;
+	}
+
+	//-----------------------------------------------------------
+	// move indices of thread cache to shared free indices.
+	//-----------------------------------------------------------
+	void CpuDescriptorAllocator::Drain(ThreadCache& cache, u32 count)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (u32 i = 0; i < count; i++)
+		{
+			freeIndices_.push_back(cache.indices[--cache.count]);
+		}
+	}
+
+	//-----------------------------------------------------------
+	// allocate descriptor.
+	//-----------------------------------------------------------
+	CpuDescriptor CpuDescriptorAllocator::Allocate()
+	{
+		CpuDescriptor ret;
+		auto&& cache = GetThreadCache();
+		if (cache.count == 0 && !Refill(cache))
+		{
+			return ret;
+		}
+		ret.index = cache.indices[--cache.count];
+		ret.cpuHandle = GetCpuHandle(ret.index);
+		return ret;
+	}
+
+	//-----------------------------------------------------------
+	// free descriptor immediately.
+	//-----------------------------------------------------------
+	void CpuDescriptorAllocator::Free(const CpuDescriptor& descriptor)
+	{
+		if (!descriptor.IsValid())
 		{
-			if (pOutCpu) *pOutCpu = it->second.cpuHandle;
-			if (pOutGpu) *pOutGpu = it->second.gpuHandle;
-			heapDirty_ = (pCurrentHeap_ != it->second.pHeap);
-			pCurrentHeap_ = it->second.pHeap;
 			return;
 		}
+		assert(descriptor.index < kMaxPageCount * kPageSize);
 
-		// try allocate from last allocate heap.
-		D3D12_CPU_DESCRIPTOR_HANDLE cpu_handle;
-		D3D12_GPU_DESCRIPTOR_HANDLE gpu_handle;
-		auto result = pLastAllocateHeap_->Allocate(count, cpu_handle, gpu_handle);
-		if (IsFailed(result))
+		auto&& cache = GetThreadCache();
+		if (cache.count == kThreadCacheSize)
 		{
-			// create new heap because current heap is lack!
-			AddHeap();
+			Drain(cache, kThreadCacheSize / 2);
+		}
+		cache.indices[cache.count++] = descriptor.index;
+	}
 
-			// allocater from last allocate heap.
-			result = pLastAllocateHeap_->Allocate(count, cpu_handle, gpu_handle);
-			assert(IsSucceeded(result));
+	//-----------------------------------------------------------
+	// free descriptor after in flight submissions.
+	//-----------------------------------------------------------
+	void CpuDescriptorAllocator::FreeDeferred(const CpuDescriptor& descriptor)
+	{
+		if (!descriptor.IsValid())
+		{
+			return;
 		}
 
-		heapDirty_ = (pCurrentHeap_ != pLastAllocateHeap_);
-		pCurrentHeap_ = pLastAllocateHeap_;
+		std::lock_guard<std::mutex> lock(mutex_);
+		pendingFrees_.Push(pDevice_->GetCommandQueue(), descriptor.index);
+	}
 
-		// copy descriptors.
-		pParentDevice_->GetNativeDevice()->CopyDescriptors(
-			1, &cpu_handle, &count,
-			count, pSrcCpu, nullptr,
-			D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+	//-----------------------------------------------------------
+	// initialize bindless descriptor heap.
+	//-----------------------------------------------------------
+	Result::Type BindlessDescriptorHeap::Initialize(Device* pDevice, u32 size)
+	{
+		pDevice_ = pDevice;
+		size_ = size;
+
+		// lower indices are popped first.
+		freeIndices_.resize(size);
+		for (u32 i = 0; i < size; i++)
+		{
+			freeIndices_[i] = size - 1 - i;
+		}
+		return Result::Ok;
+	}
 
-		if (pOutCpu) *pOutCpu = cpu_handle;
-		if (pOutGpu) *pOutGpu = gpu_handle;
+	//-----------------------------------------------------------
+	// destroy bindless descriptor heap.
+	//-----------------------------------------------------------
+	void BindlessDescriptorHeap::Destroy()
+	{
+		freeIndices_.clear();
+		pendingFrees_.Clear();
+		size_ = 0;
+	}
+
+	//-----------------------------------------------------------
+	// allocate index and copy view to all ring heaps.
+	//-----------------------------------------------------------
+	u32 BindlessDescriptorHeap::Allocate(D3D12_CPU_DESCRIPTOR_HANDLE srcCpu)
+	{
+		u32 index;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			auto p_queue = pDevice_->GetCommandQueue();
+			pendingFrees_.Retire(p_queue, false, freeIndices_);
+			if (freeIndices_.empty())
+			{
+				if (pendingFrees_.IsEmpty())
+				{
+					return kInvalidIndex;
+				}
+				pendingFrees_.Retire(p_queue, true, freeIndices_);
+			}
+			index = freeIndices_.back();
+			freeIndices_.pop_back();
+		}
+
+		// index is owned by caller here, so copies need no lock.
+		for (auto type : { CommandQueueType::Graphics, CommandQueueType::Compute })
+		{
+			auto p_ring = pDevice_->GetDescriptorRing(type);
+			pDevice_->GetNativeDevice()->CopyDescriptorsSimple(1, p_ring->GetCpuHandle(index), srcCpu, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+		}
+		return index;
 	}
 
+	//-----------------------------------------------------------
+	// free index after in flight submissions.
+	//-----------------------------------------------------------
+	void BindlessDescriptorHeap::FreeDeferred(u32 index)
+	{
+		if (index == kInvalidIndex)
+		{
+			return;
+		}
+		assert(index < size_);
+
+		// GPU may read the slot until submissions using it complete.
+		std::lock_guard<std::mutex> lock(mutex_);
+		pendingFrees_.Push(pDevice_->GetCommandQueue(), index);
+	}
 }
 //	EOF
@@ -4,77 +4,174 @@
 
 #include <vector>
 #include <memory>
-#include <map>
+#include <deque>
+#include <mutex>
 
 
 namespace mll
 {
 	class Device;
 	class CommandList;
+	class CommandQueue;
 
 	//-----------------------------------------------------------
-	//! @brief descriptor stack heap.
+	//! @brief indices freed after fence values signaled at free are completed.
+	//!
+	//! Not thread safe, owner takes its lock.
 	//-----------------------------------------------------------
-	class DescriptorStackHeap
+	class DeferredIndexQueue
 	{
-		friend class ResourceDescriptorStack;
-		friend class SamplerDescriptorStack;
-
 	public:
-		~DescriptorStackHeap();
+		/**
+		 * @brief push index with currently signaled fence values of all command queues.
+		*/
+		void Push(CommandQueue* pQueue, u32 index);
 
-		// getter
-		ID3D12DescriptorHeap* GetNativeHeap()
+		/**
+		 * @brief pop indices whose fences are completed.
+		 *
+		 * @param[in]		bWaitOldest		wait fences of the oldest index on CPU first.
+		 * @param[out]		outIndices		popped indices are appended.
+		*/
+		void Retire(CommandQueue* pQueue, bool bWaitOldest, std::vector<u32>& outIndices);
+
+		bool IsEmpty() const
 		{
-			return pHeap_;
+			return entries_.empty();
 		}
-		u32 GetStackMax() const
+		void Clear()
 		{
-			return stackMax_;
+			entries_.clear();
 		}
 
 	private:
-		DescriptorStackHeap()
+		struct Entry
+		{
+			u32		index;
+			u64		fenceValues[CommandQueueType::MAX];
+		};	// struct Entry
+
+		std::deque<Entry>		entries_;		// in fence order.
+	};	// class DeferredIndexQueue
+
+	//-----------------------------------------------------------
+	//! @brief shader visible CBV/SRV/UAV descriptor ring of a command queue type.
+	//!
+	//! One native heap is shared by all command lists of the queue type, so a command list
+	//! never switches heaps. Command lists take blocks from ring head and return them
+	//! at submission with its fence value, tail passes blocks whose fence is completed.
+	//! If ring is full, CPU waits for the oldest returned block.
+	//-----------------------------------------------------------
+	class DescriptorRing
+	{
+		MLL_DECLARE_CLASS_ALLOCATOR(AllocCategory::Descriptor);
+
+	public:
+		DescriptorRing()
 		{}
+		~DescriptorRing()
+		{
+			Destroy();
+		}
 
 		/**
-		 * @brief initialize class.
+		 * @brief create ring heap.
 		 *
-		 * @param[in]		pDevice			parent device.
-		 * @param[in]		stackSize		stack heap size.
-		 * @return			initialize result.
+		 * @param[in]		size			descriptors of ring.
+		 * @param[in]		reservedCount	descriptors at heap start which are not used by ring.
 		*/
-		Result::Type Initialize(Device* pDevice, D3D12_DESCRIPTOR_HEAP_TYPE type, u32 stackSize);
+		Result::Type Initialize(Device* pDevice, CommandQueueType::Type type, u32 size, u32 reservedCount);
+		void Destroy();
 
 		/**
-		 * @brief reset stack.
+		 * @brief take contiguous block from ring head.
+		 *
+		 * @param[in]		count			descriptor count of block.
+		 * @param[out]		outBlock		ring position of block, used to return it.
+		 * @param[out]		outIndex		descriptor index of block start in heap.
+		 * @return			OutOfMemory if blocks held by command lists fill the ring.
 		*/
-		void Reset()
+		Result::Type AcquireBlock(u32 count, u64& outBlock, u32& outIndex);
+
+		/**
+		 * @brief return block to ring.
+		 *
+		 * @param[in]		block			ring position from AcquireBlock.
+		 * @param[in]		fenceValue		fence value of last submission. 0 if not submitted.
+		*/
+		void ReleaseBlock(u64 block, u64 fenceValue);
+
+		/**
+		 * @brief hold returned blocks again for resubmission.
+		 *
+		 * @param[in]		pBlocks			ring positions from AcquireBlock, in acquired order.
+		 * @param[in]		count			block count.
+		 * @return			false if tail passed blocks, no block is held then.
+		*/
+		bool HoldBlocks(const u64* pBlocks, u32 count);
+
+		// getter
+		ID3D12DescriptorHeap* GetNativeHeap()
 		{
-			stackPosition_ = 0;
+			return pHeap_;
+		}
+		D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(u32 index) const
+		{
+			D3D12_CPU_DESCRIPTOR_HANDLE ret = cpuHandleStart_;
+			ret.ptr += (SIZE_T)index * (SIZE_T)descSize_;
+			return ret;
+		}
+		D3D12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(u32 index) const
+		{
+			D3D12_GPU_DESCRIPTOR_HANDLE ret = gpuHandleStart_;
+			ret.ptr += (u64)index * (u64)descSize_;
+			return ret;
+		}
+		DescriptorRingStats GetStats()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return stats_;
 		}
 
+	private:
 		/**
-		 * @brief allocate from stack heap.
-		 *
-		 * @param[in]		count			alloc descriptor count.
-		 * @param[out]		outCpu			alloc cpu handle.
-		 * @param[out]		outGpu			alloc gpu handle.
-		 * @return			allocate result.
+		 * @brief advance tail over completed blocks.
 		*/
-		Result::Type Allocate(u32 count, D3D12_CPU_DESCRIPTOR_HANDLE& outCpu, D3D12_GPU_DESCRIPTOR_HANDLE& outGpu);
+		void Retire(u64 completedFenceValue);
 
 	private:
+		struct Block
+		{
+			u64		begin;				// ring position including padding before block.
+			u64		end;
+			u64		fenceValue;
+			bool	isHeld;
+		};	// struct Block
+
+		Device*						pDevice_ = nullptr;
+		CommandQueueType::Type		type_ = CommandQueueType::Graphics;
 		ID3D12DescriptorHeap*		pHeap_ = nullptr;
 		D3D12_CPU_DESCRIPTOR_HANDLE	cpuHandleStart_{};
 		D3D12_GPU_DESCRIPTOR_HANDLE	gpuHandleStart_{};
 		u32							descSize_ = 0;
-		u32							stackMax_ = 0;
-		u32							stackPosition_ = 0;
-	};	// class DescriptorStackHeap
+		u32							size_ = 0;
+		u32							reservedCount_ = 0;
+
+		std::mutex					mutex_;
+		std::deque<Block>			blocks_;			// acquired blocks in ring order.
+		u64							head_ = 0;
+		u64							tail_ = 0;
+		DescriptorRingStats			stats_;
+	};	// class DescriptorRing
 
 	//-----------------------------------------------------------
 	//! @brief descriptor stack for shader resource views.
+	//!
+	//! Descriptors are allocated from blocks of device descriptor ring.
+	//! Blocks are held while command list is translated and returned to ring at submission.
+	//! Submitting again holds them again if ring has not reused them.
+	//! Tables are hashed by source handles, same table bound again reuses copied descriptors.
+	//! Copies are staged and issued by Flush as one multi range CopyDescriptors.
 	//-----------------------------------------------------------
 	class ResourceDescriptorStack
 	{
@@ -87,71 +184,201 @@ namespace mll
 		 * @brief initialize class.
 		 *
 		 * @param[in]		pDevice				parent device.
+		 * @param[in]		pRing				descriptor ring of command queue type.
 		 * @return			initialize result.
 		*/
-		Result::Type Initialize(Device* pDevice);
+		Result::Type Initialize(Device* pDevice, DescriptorRing* pRing);
+
+		/**
+		 * @brief return held blocks to ring.
+		 *
+		 * @param[in]		fenceValue			fence value of last submission. 0 if not submitted.
+		*/
+		void Release(u64 fenceValue);
+
+		/**
+		 * @brief return blocks to ring at submission, tables are kept.
+		 *
+		 * @param[in]		fenceValue			fence value of submission.
+		*/
+		void Submit(u64 fenceValue);
 
 		/**
-		 * @brief reset stack.
+		 * @brief hold blocks returned at previous submission again.
+		 *
+		 * @return			false if ring reused blocks, tables must be copied again.
 		*/
-		void Reset();
+		bool Hold();
 
 		/**
-		 * @brief allocate handle from stack and copy cpu handles.
+		 * @brief find or allocate table and stage copy of cpu handles.
 		 *
 		 * @param[in]		count				alloc descriptor count.
 		 * @param[in]		pSrcCpu				copy source cpu handle.
 		 * @param[out]		pOutCpu				alloc cpu handle. (nullptr ok)
 		 * @param[out]		pOutGpu				alloc gpu handle. (nullptr ok)
+		 * @return			OutOfMemory if descriptor ring is full, outputs and stack are not changed.
+		 * @note Descriptors are written by Flush, which must be called before submission.
 		*/
-		void AllocateAndCopy(u32 count, const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcCpu, D3D12_CPU_DESCRIPTOR_HANDLE* pOutCpu, D3D12_GPU_DESCRIPTOR_HANDLE* pOutGpu);
+		Result::Type AllocateAndCopy(u32 count, const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcCpu, D3D12_CPU_DESCRIPTOR_HANDLE* pOutCpu, D3D12_GPU_DESCRIPTOR_HANDLE* pOutGpu);
 
 		/**
-		 * @brief mark heap dirty.
+		 * @brief copy all staged tables at once.
 		*/
-		void MarkHeapDirty()
+		void Flush();
+
+		// getter
+		ID3D12DescriptorHeap* GetNativeHeap()
 		{
-			heapDirty_ = true;
+			return pRing_->GetNativeHeap();
 		}
 
-		/**
-		 * @brief unmark heap dirty.
-		*/
-		void UnmarkHeapDirty()
+	private:
+		struct Table
 		{
-			heapDirty_ = false;
+			u64		hash;
+			u32		srcOffset;			// first source handle in srcHandles_.
+			u32		count;
+			u32		heapIndex;
+		};	// struct Table
+
+		u32 FindSlot(u64 hash, u32 count, const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcCpu) const;
+		void Rehash(u32 slotCount);
+
+	private:
+		Device*					pParentDevice_ = nullptr;
+		DescriptorRing*			pRing_ = nullptr;
+		std::vector<u64>		blocks_;				// in acquired order.
+		bool					isHeld_ = true;			// false after submission returned blocks.
+		u32						blockIndex_ = 0;		// descriptor index of current block in heap.
+		u32						blockPosition_ = 0;
+		u32						blockSize_ = 0;
+
+		// tables copied until Release.
+		std::vector<Table>							tables_;
+		std::vector<u32>							slots_;				// table + 1, 0 is empty.
+		std::vector<D3D12_CPU_DESCRIPTOR_HANDLE>	srcHandles_;
+
+		// staged copies, sources are srcHandles_ after flushedSrcCount_.
+		std::vector<D3D12_CPU_DESCRIPTOR_HANDLE>	stagedDst_;
+		std::vector<UINT>							stagedSizes_;
+		u32											flushedSrcCount_ = 0;
+	};	// class ResourceDescriptorStack
+
+	//-----------------------------------------------------------
+	//! @brief device wide shader visible sampler descriptor cache.
+	//!
+	//! Sampler tables live in one 2048 entry heap shared by all command lists, so heaps never switch.
+	//! Tables are found in open addressing hash table keyed by the full sampler description set,
+	//! and samplers are created in heap from descriptions, so no CPU descriptor can go stale.
+	//! When heap is lack, least recently used tables are evicted. Tables held by command lists
+	//! or not completed by GPU are not evicted, CPU waits GPU if only such tables remain.
+	//-----------------------------------------------------------
+	class SamplerDescriptorCache
+	{
+		MLL_DECLARE_CLASS_ALLOCATOR(AllocCategory::Descriptor);
+
+	public:
+		static const u32	kHeapSize = 2048;
+		static const u32	kInvalidEntry = 0xffffffff;
+
+		SamplerDescriptorCache()
+		{}
+		~SamplerDescriptorCache()
+		{
+			Destroy();
 		}
 
+		Result::Type Initialize(Device* pDevice);
+		void Destroy();
+
+		/**
+		 * @brief find or create sampler table and hold it.
+		 *
+		 * @param[in]		count			sampler count of table.
+		 * @param[in]		pDescs			sampler descriptions.
+		 * @param[out]		outHeapIndex	descriptor index of table in heap.
+		 * @return			entry to release. kInvalidEntry if held tables fill the heap.
+		*/
+		u32 Acquire(u32 count, const D3D12_SAMPLER_DESC* pDescs, u32& outHeapIndex);
+
+		/**
+		 * @brief release held table.
+		 *
+		 * @param[in]		entry			entry from Acquire.
+		 * @param[in]		type			command queue type of command list.
+		 * @param[in]		fenceValue		fence value of last submission. 0 if not submitted.
+		*/
+		void Release(u32 entry, CommandQueueType::Type type, u64 fenceValue);
+
 		// getter
-		DescriptorStackHeap* GetCurrentHeap()
+		ID3D12DescriptorHeap* GetNativeHeap()
 		{
-			return pCurrentHeap_;
+			return pHeap_;
 		}
-		bool IsHeapDirty() const
+		D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(u32 index) const
 		{
-			return heapDirty_;
+			D3D12_CPU_DESCRIPTOR_HANDLE ret = cpuHandleStart_;
+			ret.ptr += (SIZE_T)index * (SIZE_T)descSize_;
+			return ret;
+		}
+		D3D12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(u32 index) const
+		{
+			D3D12_GPU_DESCRIPTOR_HANDLE ret = gpuHandleStart_;
+			ret.ptr += (u64)index * (u64)descSize_;
+			return ret;
+		}
+		SamplerCacheStats GetStats()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return stats_;
 		}
 
 	private:
-		std::vector<std::unique_ptr<DescriptorStackHeap>>	heaps_;
+		struct Entry
+		{
+			u64		hash;
+			u32		heapIndex;
+			u32		count;
+			u32		holdCount;
+			u32		lruPrev;
+			u32		lruNext;
+			u64		fenceValues[CommandQueueType::MAX];		// last submission per queue type.
+		};	// struct Entry
+
+		u32 FindSlot(u64 hash, u32 count, const D3D12_SAMPLER_DESC* pDescs) const;
+		void RemoveFromTable(u32 entry);
+		bool AllocateRange(u32 count, u32& outIndex);
+		void FreeRange(u32 index, u32 count);
+		void LinkFront(u32 entry);
+		void Unlink(u32 entry);
+		bool IsCompleted(const Entry& entry, const u64* pCompletedValues) const;
 
-		Device*					pParentDevice_ = nullptr;
-		DescriptorStackHeap*	pCurrentHeap_ = nullptr;
-		bool					heapDirty_ = false;
-	};	// class ResourceDescriptorStack
+	private:
+		Device*						pDevice_ = nullptr;
+		ID3D12DescriptorHeap*		pHeap_ = nullptr;
+		D3D12_CPU_DESCRIPTOR_HANDLE	cpuHandleStart_{};
+		D3D12_GPU_DESCRIPTOR_HANDLE	gpuHandleStart_{};
+		u32							descSize_ = 0;
+
+		std::mutex					mutex_;
+		std::vector<Entry>			entries_;
+		std::vector<u32>			freeEntries_;
+		std::vector<u32>			table_;						// entry + 1, 0 is empty.
+		u64							usedBits_[kHeapSize / 64] = {};
+		D3D12_SAMPLER_DESC			keys_[kHeapSize] = {};		// description of each heap descriptor.
+		u32							lruHead_ = kInvalidEntry;	// most recently used.
+		u32							lruTail_ = kInvalidEntry;
+		SamplerCacheStats			stats_;
+	};	// class SamplerDescriptorCache
 
 	//-----------------------------------------------------------
-	//! @brief descriptor stack for samplers.
+	//! @brief sampler tables of a command list.
+	//!
+	//! Tables are held in device sampler cache from End until next End, like command allocator.
 	//-----------------------------------------------------------
 	class SamplerDescriptorStack
 	{
-		struct MapItem
-		{
-			DescriptorStackHeap*		pHeap = nullptr;
-			D3D12_CPU_DESCRIPTOR_HANDLE	cpuHandle;
-			D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle;
-		};	// struct MapItem
-
 	public:
 		SamplerDescriptorStack()
 		{}
@@ -160,64 +387,204 @@ namespace mll
 		/**
 		 * @brief initialize class.
 		 *
-		 * @param[in]		pDevice				parent device.
+		 * @param[in]		pCache				device sampler cache.
+		 * @param[in]		type				command queue type of command list.
 		 * @return			initialize result.
 		*/
-		Result::Type Initialize(Device* pDevice);
+		Result::Type Initialize(SamplerDescriptorCache* pCache, CommandQueueType::Type type);
 
 		/**
-		 * @brief reset stack.
+		 * @brief release held tables.
+		 *
+		 * @param[in]		fenceValue			fence value of last submission. 0 if not submitted.
 		*/
-		void Reset();
+		void Release(u64 fenceValue);
 
 		/**
-		 * @brief allocate handle from stack and copy cpu handles.
+		 * @brief find or create sampler table.
 		 *
-		 * @param[in]		count				alloc descriptor count.
-		 * @param[in]		pSrcCpu				copy source cpu handle.
-		 * @param[out]		pOutCpu				alloc cpu handle. (nullptr ok)
-		 * @param[out]		pOutGpu				alloc gpu handle. (nullptr ok)
+		 * @param[in]		count				sampler count.
+		 * @param[in]		pDescs				sampler descriptions.
+		 * @param[out]		pOutCpu				table cpu handle. (nullptr ok)
+		 * @param[out]		pOutGpu				table gpu handle. (nullptr ok)
+		 * @return			OutOfMemory if tables held by command lists fill the heap, outputs are not changed.
 		*/
-		void AllocateAndCopy(u32 count, const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcCpu, D3D12_CPU_DESCRIPTOR_HANDLE* pOutCpu, D3D12_GPU_DESCRIPTOR_HANDLE* pOutGpu);
+		Result::Type Allocate(u32 count, const D3D12_SAMPLER_DESC* pDescs, D3D12_CPU_DESCRIPTOR_HANDLE* pOutCpu, D3D12_GPU_DESCRIPTOR_HANDLE* pOutGpu);
 
-		/**
-		 * @brief mark heap dirty.
-		*/
-		void MarkHeapDirty()
+		// getter
+		ID3D12DescriptorHeap* GetNativeHeap()
 		{
-			heapDirty_ = true;
+			return pCache_->GetNativeHeap();
 		}
 
-		/**
-		 * @brief unmark heap dirty.
-		*/
-		void UnmarkHeapDirty()
+	private:
+		SamplerDescriptorCache*		pCache_ = nullptr;
+		CommandQueueType::Type		type_ = CommandQueueType::Graphics;
+		std::vector<u32>			heldEntries_;
+	};	// class SamplerDescriptorStack
+
+	//-----------------------------------------------------------
+	//! @brief persistent non shader visible descriptor.
+	//-----------------------------------------------------------
+	struct CpuDescriptor
+	{
+		static const u32	kInvalidIndex = 0xffffffff;
+
+		D3D12_CPU_DESCRIPTOR_HANDLE		cpuHandle{};
+		u32								index = kInvalidIndex;		// index in allocator.
+
+		bool IsValid() const
+		{
+			return index != kInvalidIndex;
+		}
+	};	// struct CpuDescriptor
+
+	//-----------------------------------------------------------
+	//! @brief persistent CPU descriptor allocator of a descriptor heap type.
+	//!
+	//! Descriptors live in non shader visible heap pages which are kept until destruction,
+	//! so views are created once per resource and only copied to shader visible heaps per draw.
+	//! Free indices are kept in a stack, and each thread caches a batch of them per heap type,
+	//! so Allocate and Free take no lock until the thread cache is empty or full.
+	//-----------------------------------------------------------
+	class CpuDescriptorAllocator
+	{
+		MLL_DECLARE_CLASS_ALLOCATOR(AllocCategory::Descriptor);
+
+	public:
+		static const u32	kPageSize = 256;
+		static const u32	kMaxPageCount = 1024;
+		static const u32	kThreadCacheSize = 32;
+
+		CpuDescriptorAllocator()
+		{}
+		~CpuDescriptorAllocator()
 		{
-			heapDirty_ = false;
+			Destroy();
 		}
 
+		Result::Type Initialize(Device* pDevice, D3D12_DESCRIPTOR_HEAP_TYPE type);
+		void Destroy();
+
+		/**
+		 * @brief allocate descriptor.
+		 *
+		 * @return			invalid descriptor if all pages are used.
+		*/
+		CpuDescriptor Allocate();
+
+		/**
+		 * @brief free descriptor immediately.
+		 *
+		 * @note Descriptor must not be copied by any thread after this call.
+		*/
+		void Free(const CpuDescriptor& descriptor);
+
+		/**
+		 * @brief free descriptor after all command queues complete currently signaled fence values.
+		*/
+		void FreeDeferred(const CpuDescriptor& descriptor);
+
 		// getter
-		DescriptorStackHeap* GetCurrentHeap()
+		D3D12_DESCRIPTOR_HEAP_TYPE GetType() const
 		{
-			return pCurrentHeap_;
+			return type_;
 		}
-		bool IsHeapDirty() const
+		D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(u32 index) const
 		{
-			return heapDirty_;
+			D3D12_CPU_DESCRIPTOR_HANDLE ret;
+			ret.ptr = pageStarts_[index / kPageSize] + (SIZE_T)(index % kPageSize) * (SIZE_T)descSize_;
+			return ret;
 		}
 
 	private:
-		void AddHeap();
+		struct ThreadCache
+		{
+			u64		ownerId = 0;
+			u32		count = 0;
+			u32		indices[kThreadCacheSize];
+
+			~ThreadCache();
+		};	// struct ThreadCache
+
+		ThreadCache& GetThreadCache();
+		bool Refill(ThreadCache& cache);
+		void Drain(ThreadCache& cache, u32 count);
+		bool AddPage();
+
+		static void ReturnToOwner(u64 ownerId, const u32* pIndices, u32 count);
+
+	private:
+		Device*						pDevice_ = nullptr;
+		D3D12_DESCRIPTOR_HEAP_TYPE	type_ = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+		u32							descSize_ = 0;
+		u64							id_ = 0;			// unique id, owner of thread caches.
+
+		std::mutex					mutex_;
+		ID3D12DescriptorHeap*		pPages_[kMaxPageCount] = {};
+		SIZE_T						pageStarts_[kMaxPageCount] = {};		// written before indices of page are published.
+		u32							pageCount_ = 0;
+		std::vector<u32>			freeIndices_;
+		DeferredIndexQueue			pendingFrees_;
+	};	// class CpuDescriptorAllocator
+
+	//-----------------------------------------------------------
+	//! @brief device wide bindless views with stable indices.
+	//!
+	//! First descriptors of every descriptor ring heap are reserved for bindless views, and a view
+	//! is written at the same index of all ring heaps. Shaders index heap directly, so no table
+	//! is copied per draw. Freed indices are reused after in flight submissions complete.
+	//-----------------------------------------------------------
+	class BindlessDescriptorHeap
+	{
+		MLL_DECLARE_CLASS_ALLOCATOR(AllocCategory::Descriptor);
+
+	public:
+		static const u32	kInvalidIndex = 0xffffffff;
+
+		BindlessDescriptorHeap()
+		{}
+		~BindlessDescriptorHeap()
+		{
+			Destroy();
+		}
+
+		/**
+		 * @brief initialize class.
+		 *
+		 * @param[in]		pDevice			parent device, descriptor rings must reserve size descriptors.
+		 * @param[in]		size			bindless descriptor count.
+		*/
+		Result::Type Initialize(Device* pDevice, u32 size);
+		void Destroy();
+
+		/**
+		 * @brief allocate index and copy view to all ring heaps.
+		 *
+		 * @param[in]		srcCpu			persistent CPU view.
+		 * @return			heap index. kInvalidIndex if all indices are used.
+		*/
+		u32 Allocate(D3D12_CPU_DESCRIPTOR_HANDLE srcCpu);
+
+		/**
+		 * @brief free index after all command queues complete currently signaled fence values.
+		*/
+		void FreeDeferred(u32 index);
+
+		// getter
+		u32 GetSize() const
+		{
+			return size_;
+		}
 
 	private:
-		std::vector<std::unique_ptr<DescriptorStackHeap>>	heaps_;
-
-		Device*						pParentDevice_ = nullptr;
-		DescriptorStackHeap*		pLastAllocateHeap_ = nullptr;
-		DescriptorStackHeap*		pCurrentHeap_ = nullptr;
-		bool						heapDirty_ = false;
-		std::map<u32, MapItem>		caches_;
-	};	// class SamplerDesctriptorStack
+		Device*						pDevice_ = nullptr;
+		u32							size_ = 0;
+
+		std::mutex					mutex_;
+		std::vector<u32>			freeIndices_;
+		DeferredIndexQueue			pendingFrees_;
+	};	// class BindlessDescriptorHeap
 
 }
 //	EOF
@@ -1,12 +1,20 @@
 ﻿#include "device.h"
 
 #include <cassert>
+#include <vector>
 
 #include "command_list.h"
+#include "swapchain.h"
+#include "texture.h"
 
 
 namespace mll
 {
+	namespace
+	{
+		static const u32	kDefaultDescriptorRingSize = 64 * 1024;
+	}
+
 	//-----------------------------------------------------------
 	// Initialize each command queue.
 	//-----------------------------------------------------------
@@ -45,6 +53,22 @@ namespace mll
 			timestampFrequency_ = 0;
 		}
 
+		// create fence for each created queue.
+		for (u32 i = 0; i < CommandQueueType::MAX; i++)
+		{
+			signaledValues_[i].store(0);
+			if (GetNativeQueue(i) == nullptr)
+			{
+				continue;
+			}
+
+			hr = pDevice->GetNativeDevice()->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&pFences_[i]));
+			if (FAILED(hr))
+			{
+				return false;
+			}
+		}
+
 		return true;
 	}
 
@@ -53,11 +77,46 @@ namespace mll
 	//-----------------------------------------------------------
 	void CommandQueue::Destroy()
 	{
+		for (auto&& fence : pFences_)
+		{
+			SafeRelease(fence);
+		}
 		SafeRelease(pGraphicsQueue_);
 		SafeRelease(pComputeQueue_);
 		SafeRelease(pCopyQueue_);
 	}
 
+	//-----------------------------------------------------------
+	// Wait all command queues idle.
+	//-----------------------------------------------------------
+	void CommandQueue::WaitIdle()
+	{
+		for (u32 i = 0; i < CommandQueueType::MAX; i++)
+		{
+			if (pFences_[i] == nullptr)
+			{
+				continue;
+			}
+
+			auto type = static_cast<CommandQueueType::Type>(i);
+			WaitFence(type, Signal(type));
+		}
+	}
+
+	//-----------------------------------------------------------
+	// Wait fence value on CPU.
+	//-----------------------------------------------------------
+	void CommandQueue::WaitFence(CommandQueueType::Type type, u64 value)
+	{
+		auto p_fence = GetFence(type);
+		if (p_fence->GetCompletedValue() < value)
+		{
+			// nullptr event blocks until the fence reaches the value.
+			auto hr = p_fence->SetEventOnCompletion(value, nullptr);
+			assert(SUCCEEDED(hr));
+		}
+	}
+
 
 	//-----------------------------------------------------------
 	// Release device.
@@ -67,6 +126,22 @@ namespace mll
 		MLL_DELETE(this);
 	}
 
+	//-----------------------------------------------------------
+	// Get last fence value signaled on command queue.
+	//-----------------------------------------------------------
+	u64 IDevice::GetSignaledFenceValue(CommandQueueType::Type type)
+	{
+		return static_cast<Device*>(this)->GetCommandQueue()->GetSignaledFenceValue(type);
+	}
+
+	//-----------------------------------------------------------
+	// Get fence value completed on command queue.
+	//-----------------------------------------------------------
+	u64 IDevice::GetCompletedFenceValue(CommandQueueType::Type type)
+	{
+		return static_cast<Device*>(this)->GetCommandQueue()->GetCompletedFenceValue(type);
+	}
+
 	//-----------------------------------------------------------
 	// Graphics device create function.
 	//-----------------------------------------------------------
@@ -80,7 +155,7 @@ namespace mll
 			return ObjPtr<IDevice>();
 		}
 
-		return ObjPtr<IDevice>(ret, objectId_.fetch_add(1));
+		return ObjPtr<IDevice>(ret);
 	}
 
 	//-----------------------------------------------------------
@@ -88,6 +163,8 @@ namespace mll
 	//-----------------------------------------------------------
 	bool Device::Initialize(const DeviceDesc& desc)
 	{
+		enableNativeObjectName_ = desc.enableNativeObjectName;
+
 #ifdef _DEBUG
 		// デバッグレイヤーの有効化
 		if (desc.enableDebugLayer)
@@ -206,6 +283,55 @@ namespace mll
 			return false;
 		}
 
+		for (u32 i = 0; i < CommandQueueType::MAX; i++)
+		{
+			pAllocatorPools_[i] = MLL_NEW(CommandAllocatorPool);
+			assert(pAllocatorPools_[i] != nullptr);
+			pAllocatorPools_[i]->Initialize(this, static_cast<CommandQueueType::Type>(i));
+		}
+
+		// shader visible descriptors of all command lists are allocated from one ring per queue.
+		// bindless views are placed before ring in each heap.
+		u32 ring_size = (desc.descriptorRingSize != 0) ? desc.descriptorRingSize : kDefaultDescriptorRingSize;
+		for (auto type : { CommandQueueType::Graphics, CommandQueueType::Compute })
+		{
+			pDescriptorRings_[type] = MLL_NEW(DescriptorRing);
+			assert(pDescriptorRings_[type] != nullptr);
+			if (IsFailed(pDescriptorRings_[type]->Initialize(this, type, ring_size, desc.bindlessDescriptorCount)))
+			{
+				return false;
+			}
+		}
+		if (desc.bindlessDescriptorCount > 0)
+		{
+			pBindlessHeap_ = MLL_NEW(BindlessDescriptorHeap);
+			assert(pBindlessHeap_ != nullptr);
+			if (IsFailed(pBindlessHeap_->Initialize(this, desc.bindlessDescriptorCount)))
+			{
+				return false;
+			}
+		}
+
+		pSamplerCache_ = MLL_NEW(SamplerDescriptorCache);
+		assert(pSamplerCache_ != nullptr);
+		if (IsFailed(pSamplerCache_->Initialize(this)))
+		{
+			return false;
+		}
+
+		// persistent views of resources.
+		for (auto type : { D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, D3D12_DESCRIPTOR_HEAP_TYPE_DSV })
+		{
+			pCpuDescriptorAllocators_[type] = MLL_NEW(CpuDescriptorAllocator);
+			assert(pCpuDescriptorAllocators_[type] != nullptr);
+			if (IsFailed(pCpuDescriptorAllocators_[type]->Initialize(this, type)))
+			{
+				return false;
+			}
+		}
+
+		InitializeDeathList(desc);
+
 		return true;
 	}
 
@@ -214,11 +340,36 @@ namespace mll
 	//-----------------------------------------------------------
 	void Device::Destroy()
 	{
+		if (pCommandQueue_ != nullptr)
+		{
+			pCommandQueue_->WaitIdle();
+		}
+		FinalizeDeathList();
+
+		// killed objects are removed from live objects in death list processing.
 		u32 live_obj_cnt = IterateLiveObjects([](IDeviceChild* p) {});
 		assert(live_obj_cnt == 0);
 
-		ProcDeathList(true);
-
+		// command lists return allocators and descriptors on destruction, so pools are deleted after death list.
+		for (auto&& pool : pAllocatorPools_)
+		{
+			MLL_DELETE(pool);
+			pool = nullptr;
+		}
+		for (auto&& ring : pDescriptorRings_)
+		{
+			MLL_DELETE(ring);
+			ring = nullptr;
+		}
+		MLL_DELETE(pSamplerCache_);
+		pSamplerCache_ = nullptr;
+		MLL_DELETE(pBindlessHeap_);
+		pBindlessHeap_ = nullptr;
+		for (auto&& allocator : pCpuDescriptorAllocators_)
+		{
+			MLL_DELETE(allocator);
+			allocator = nullptr;
+		}
 		MLL_DELETE(pCommandQueue_);
 
 		SafeRelease(pDevice_);
@@ -228,6 +379,90 @@ namespace mll
 	}
 
 
+	//-----------------------------------------------------------
+	// Submit command lists at once.
+	//-----------------------------------------------------------
+	SubmitTicket IDevice::Submit(CommandQueueType::Type type, ICommandList* const* ppCmdLists, u32 count, const SubmitTicket* pWaitTickets, u32 waitTicketCount)
+	{
+		CaptureSubmit(type, ppCmdLists, count);
+
+		auto p_queue = static_cast<Device*>(this)->GetCommandQueue();
+
+		// native list array is reused per thread.
+		static thread_local std::vector<ID3D12CommandList*> s_nativeLists;
+		s_nativeLists.resize(count);
+		for (u32 i = 0; i < count; i++)
+		{
+			auto p_list = static_cast<CommandList*>(ppCmdLists[i]);
+			assert(!p_list->IsRecording() && !p_list->IsBundle());
+			assert(p_list->GetDesc().typeCommandQueue == type);
+			assert(!p_list->IsExecutedBundleChanged());
+			p_list->PrepareSubmit();
+			s_nativeLists[i] = p_list->GetNativeCmdList();
+		}
+
+		SubmitTicket ticket;
+		ticket.queueType = type;
+		ticket.fenceValue = p_queue->ExecuteAndSignal(type, [&](ID3D12CommandQueue* pQueue)
+		{
+			// same queue is ordered already.
+			auto p_own_fence = p_queue->GetFence(type);
+			for (u32 i = 0; i < waitTicketCount; i++)
+			{
+				auto p_fence = p_queue->GetFence(pWaitTickets[i].queueType);
+				if (p_fence != p_own_fence && pWaitTickets[i].IsValid())
+				{
+					auto hr = pQueue->Wait(p_fence, pWaitTickets[i].fenceValue);
+					assert(SUCCEEDED(hr));
+				}
+			}
+
+			if (count > 0)
+			{
+				pQueue->ExecuteCommandLists(count, s_nativeLists.data());
+			}
+		});
+
+		for (u32 i = 0; i < count; i++)
+		{
+			static_cast<CommandList*>(ppCmdLists[i])->OnSubmitted(ticket.fenceValue);
+		}
+		return ticket;
+	}
+
+	//-----------------------------------------------------------
+	// Wait submission on CPU.
+	//-----------------------------------------------------------
+	void IDevice::WaitTicket(const SubmitTicket& ticket)
+	{
+		static_cast<Device*>(this)->GetCommandQueue()->WaitFence(ticket.queueType, ticket.fenceValue);
+	}
+
+	//-----------------------------------------------------------
+	// Get command allocator pool statistics.
+	//-----------------------------------------------------------
+	void IDevice::GetCommandAllocatorStats(CommandQueueType::Type type, CommandAllocatorStats& outStats)
+	{
+		outStats = static_cast<Device*>(this)->GetCommandAllocatorPool(type)->GetStats();
+	}
+
+	//-----------------------------------------------------------
+	// Get descriptor ring statistics.
+	//-----------------------------------------------------------
+	void IDevice::GetDescriptorRingStats(CommandQueueType::Type type, DescriptorRingStats& outStats)
+	{
+		auto p_ring = static_cast<Device*>(this)->GetDescriptorRing(type);
+		outStats = (p_ring != nullptr) ? p_ring->GetStats() : DescriptorRingStats();
+	}
+
+	//-----------------------------------------------------------
+	// Get sampler cache statistics.
+	//-----------------------------------------------------------
+	void IDevice::GetSamplerCacheStats(SamplerCacheStats& outStats)
+	{
+		outStats = static_cast<Device*>(this)->GetSamplerDescriptorCache()->GetStats();
+	}
+
 	//-----------------------------------------------------------
 	// Create command list.
 	//-----------------------------------------------------------
@@ -242,8 +477,78 @@ namespace mll
 			return result;
 		}
 
-		outObj = AppendDeviceChild<ICommandList>(p);
-		return Result::Ok;
+		result = AppendDeviceChild<ICommandList>(p, outObj);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+		}
+		return result;
+	}
+
+	//-----------------------------------------------------------
+	// Create swapchain.
+	//-----------------------------------------------------------
+	Result::Type IDevice::CreateSwapchain(const SwapchainDesc& desc, ObjPtr<ISwapchain>& outObj)
+	{
+		auto p = MLL_NEW(Swapchain);
+
+		auto result = p->Initialize(static_cast<Device*>(this), desc);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+			return result;
+		}
+
+		result = AppendDeviceChild<ISwapchain>(p, outObj);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+		}
+		return result;
+	}
+
+	//-----------------------------------------------------------
+	// Create texture.
+	//-----------------------------------------------------------
+	Result::Type IDevice::CreateTexture(const TextureDesc& desc, ObjPtr<ITexture>& outObj)
+	{
+		auto p = MLL_NEW(Texture);
+
+		auto result = p->Initialize(static_cast<Device*>(this), desc);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+			return result;
+		}
+
+		result = AppendDeviceChild<ITexture>(p, outObj);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+		}
+		return result;
+	}
+
+	//-----------------------------------------------------------
+	// Create texture with existing native resource.
+	//-----------------------------------------------------------
+	Result::Type Device::CreateTextureFromNative(const TextureDesc& desc, ID3D12Resource* pResource, ObjPtr<ITexture>& outObj)
+	{
+		auto p = MLL_NEW(Texture);
+
+		auto result = p->InitializeFromNative(this, desc, pResource);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+			return result;
+		}
+
+		result = AppendDeviceChild<ITexture>(p, outObj);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+		}
+		return result;
 	}
 
 }
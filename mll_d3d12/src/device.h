@@ -1,6 +1,10 @@
 ﻿#pragma once
 
 #include "native.h"
+#include "command_allocator_pool.h"
+#include "descriptor_util.h"
+
+#include <cassert>
 
 
 namespace mll
@@ -12,6 +16,8 @@ namespace mll
 	//-----------------------------------------------------------
 	class CommandQueue
 	{
+		MLL_DECLARE_CLASS_ALLOCATOR(AllocCategory::Device);
+
 	public:
 		CommandQueue()
 		{}
@@ -40,11 +46,91 @@ namespace mll
 			return timestampFrequency_;
 		}
 
+		/**
+		 * @brief execute commands and signal fence on command queue.
+		 *
+		 * @param[in]	type		command queue type.
+		 * @param[in]	func		function to execute commands on native queue.
+		 * @return					signaled fence value.
+		*/
+		template <typename TFunc>
+		u64 ExecuteAndSignal(CommandQueueType::Type type, TFunc func)
+		{
+			auto index = GetFenceIndex(type);
+			std::lock_guard<std::mutex> lock(queueMutexes_[index]);
+
+			// publish fence value before execution.
+			// objects killed after this point wait for this value.
+			u64 value = signaledValues_[index].load() + 1;
+			signaledValues_[index].store(value);
+
+			auto p_queue = GetNativeQueue(index);
+			func(p_queue);
+			auto hr = p_queue->Signal(pFences_[index], value);
+			assert(SUCCEEDED(hr));
+			return value;
+		}
+
+		/**
+		 * @brief signal fence on command queue.
+		*/
+		u64 Signal(CommandQueueType::Type type)
+		{
+			return ExecuteAndSignal(type, [](ID3D12CommandQueue*) {});
+		}
+
+		/**
+		 * @brief wait fence value on CPU.
+		*/
+		void WaitFence(CommandQueueType::Type type, u64 value);
+
+		/**
+		 * @brief wait all command queues idle.
+		*/
+		void WaitIdle();
+
+		ID3D12Fence* GetFence(CommandQueueType::Type type)
+		{
+			return pFences_[GetFenceIndex(type)];
+		}
+		u64 GetSignaledFenceValue(CommandQueueType::Type type) const
+		{
+			return signaledValues_[GetFenceIndex(type)].load();
+		}
+		u64 GetCompletedFenceValue(CommandQueueType::Type type)
+		{
+			return pFences_[GetFenceIndex(type)]->GetCompletedValue();
+		}
+
+	private:
+		// if compute or copy queue is not created, these use graphics queue and fence.
+		u32 GetFenceIndex(CommandQueueType::Type type) const
+		{
+			switch (type)
+			{
+			case CommandQueueType::Compute:
+				return (pComputeQueue_ != nullptr) ? CommandQueueType::Compute : CommandQueueType::Graphics;
+			case CommandQueueType::Copy:
+				return (pCopyQueue_ != nullptr) ? CommandQueueType::Copy : CommandQueueType::Graphics;
+			default:
+				return CommandQueueType::Graphics;
+			}
+		}
+		ID3D12CommandQueue* GetNativeQueue(u32 index)
+		{
+			ID3D12CommandQueue* p_queues[] = { pGraphicsQueue_, pComputeQueue_, pCopyQueue_ };
+			return p_queues[index];
+		}
+
 	private:
 		ID3D12CommandQueue* pGraphicsQueue_ = nullptr;
 		ID3D12CommandQueue* pComputeQueue_ = nullptr;
 		ID3D12CommandQueue* pCopyQueue_ = nullptr;
 		u64					timestampFrequency_ = 0;
+
+		ID3D12Fence*		pFences_[CommandQueueType::MAX] = {};
+		std::atomic<u64>	signaledValues_[CommandQueueType::MAX];
+		std::mutex			queueMutexes_[CommandQueueType::MAX];
 	};	// class CommandQueue
 
 	//-----------------------------------------------------------
@@ -83,6 +169,37 @@ namespace mll
 		{
 			return pCommandQueue_;
 		}
+		CommandAllocatorPool* GetCommandAllocatorPool(CommandQueueType::Type type)
+		{
+			return pAllocatorPools_[type];
+		}
+		DescriptorRing* GetDescriptorRing(CommandQueueType::Type type)
+		{
+			return pDescriptorRings_[type];
+		}
+		SamplerDescriptorCache* GetSamplerDescriptorCache()
+		{
+			return pSamplerCache_;
+		}
+		CpuDescriptorAllocator* GetCpuDescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE type)
+		{
+			return pCpuDescriptorAllocators_[type];
+		}
+		BindlessDescriptorHeap* GetBindlessHeap()
+		{
+			return pBindlessHeap_;
+		}
+		bool IsNativeObjectNameEnabled() const
+		{
+			return enableNativeObjectName_;
+		}
+
+		/**
+		 * @brief create texture with existing native resource.
+		 *
+		 * @note Texture takes reference of resource, also on failure.
+		*/
+		Result::Type CreateTextureFromNative(const TextureDesc& desc, ID3D12Resource* pResource, ObjPtr<ITexture>& outObj);
 
 	private:
 		bool Initialize(const DeviceDesc& desc);
@@ -94,7 +211,14 @@ namespace mll
 		NativeOutput*		pOutput_ = nullptr;
 		NativeDevice*		pDevice_ = nullptr;
 
-		CommandQueue*		pCommandQueue_ = nullptr;
+		CommandQueue*			pCommandQueue_ = nullptr;
+		CommandAllocatorPool*	pAllocatorPools_[CommandQueueType::MAX] = {};
+		DescriptorRing*			pDescriptorRings_[CommandQueueType::MAX] = {};		// copy queue has no ring.
+		SamplerDescriptorCache*	pSamplerCache_ = nullptr;
+		CpuDescriptorAllocator*	pCpuDescriptorAllocators_[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES] = {};	// sampler type is not used.
+		BindlessDescriptorHeap*	pBindlessHeap_ = nullptr;		// nullptr if bindless is disabled.
+
+		bool				enableNativeObjectName_ = false;
 	};	// class Device
 
 }
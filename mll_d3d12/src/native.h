@@ -28,6 +28,27 @@ namespace mll
 		return kNodeMaskDefault;
 	}
 
+	/**
+	 * @brief set name to d3d12 object.
+	*/
+	inline void SetNativeObjectName(ID3D12Object* pObject, const char* name)
+	{
+		if (pObject == nullptr)
+		{
+			return;
+		}
+
+		wchar_t wname[256];
+		int len = MultiByteToWideChar(CP_UTF8, 0, name, -1, wname, _countof(wname));
+		if (len == 0)
+		{
+			// too long name is truncated.
+			len = MultiByteToWideChar(CP_UTF8, 0, name, static_cast<int>(_countof(wname)) - 1, wname, _countof(wname) - 1);
+			wname[len] = L'\0';
+		}
+		pObject->SetName(wname);
+	}
+
 	/**
 	 * @brief get d3d12 command queue type.
 	*/
@@ -7,18 +7,57 @@
 
 namespace mll
 {
+	MLL_IMPLEMENT_POOL_ALLOCATOR(Swapchain, AllocCategory::Swapchain);
+
 	void Swapchain::Release()
 	{
 		KillSelf();
 	}
 
 	//-----------------------------------------------------------
-	// initialize native command list.
+	// initialize native swapchain.
 	//-----------------------------------------------------------
 	Result::Type Swapchain::Initialize(Device* pDevice, const SwapchainDesc& desc)
 	{
 		desc_ = desc;
 
+		if (desc.backBufferCount == 0)
+		{
+			return Result::InvalidArgs;
+		}
+		// frame ring is presented by headless backend only.
+		if (desc.frameRingName != nullptr)
+		{
+			return Result::InvalidOperation;
+		}
+
+		TextureDesc tex_desc;
+		tex_desc.SetDimension(ResourceDimension::Texture2D)
+			.SetWidth(desc.width)
+			.SetHeight(desc.height)
+			.SetDepth(1)
+			.SetArraySize(1)
+			.SetMipLevels(1)
+			.SetFormat(desc.format)
+			.SetUsageFlags(ResourceUsageFlag::RenderTarget)
+			.SetInitialState(ResourceState::Present);
+		backBuffers_.resize(desc.backBufferCount);
+
+		// offscreen swapchain.
+		if (desc.windowHandle == nullptr)
+		{
+			for (auto&& buffer : backBuffers_)
+			{
+				auto result = pDevice->CreateTexture(tex_desc, buffer);
+				if (IsFailed(result))
+				{
+					return result;
+				}
+			}
+			frameIndex_ = 0;
+			return Result::Ok;
+		}
+
 		// create dxgi swapchain.
 		{
 			DXGI_SWAP_CHAIN_DESC1 sd = {};
@@ -50,16 +89,38 @@ namespace mll
 			pSwap->Release();
 		}
 
-		// create texture and view.
+		// create back buffer textures.
+		for (u32 i = 0; i < desc.backBufferCount; i++)
+		{
+			ID3D12Resource* p_resource = nullptr;
+			auto hr = pSwapchain_->GetBuffer(i, IID_PPV_ARGS(&p_resource));
+			if (FAILED(hr))
+			{
+				return Result::InvalidOperation;
+			}
+
+			auto result = pDevice->CreateTextureFromNative(tex_desc, p_resource, backBuffers_[i]);
+			if (IsFailed(result))
+			{
+				p_resource->Release();
+				return result;
+			}
+		}
 
 		return Result::Ok;
 	}
 
 	//-----------------------------------------------------------
-	// destroy native command list.
+	// destroy native swapchain.
 	//-----------------------------------------------------------
 	void Swapchain::Destroy()
 	{
+		backBuffers_.clear();
+		if (event_ != nullptr)
+		{
+			CloseHandle(event_);
+			event_ = nullptr;
+		}
 		SafeRelease(pSwapchain_);
 	}
 
@@ -72,9 +133,39 @@ namespace mll
 	void ISwapchain::Present(u32 syncInterval)
 	{
 		auto p_native = Self()->GetNativeSwapchain();
+		auto p_device = static_cast<Device*>(pParentDevice_);
+
+		// signal graphics fence after present to advance frame timeline.
+		p_device->GetCommandQueue()->ExecuteAndSignal(CommandQueueType::Graphics, [&](ID3D12CommandQueue*)
+		{
+			if (p_native == nullptr)
+			{
+				// offscreen swapchain only rotates back buffers.
+				Self()->frameIndex_ = (Self()->frameIndex_ + 1) % desc_.backBufferCount;
+				return;
+			}
+			auto hr = p_native->Present(syncInterval, 0);
+			assert(SUCCEEDED(hr));
+			Self()->frameIndex_ = p_native->GetCurrentBackBufferIndex();
+		});
+	}
 
-		auto hr = p_native->Present(syncInterval, 0);
-		assert(SUCCEEDED(hr));
+	//-----------------------------------------------------------
+	// get current backbuffer index.
+	//-----------------------------------------------------------
+	u32 ISwapchain::GetBackBufferIndex() const
+	{
+		return static_cast<const Swapchain*>(this)->frameIndex_;
+	}
+
+	//-----------------------------------------------------------
+	// get backbuffer texture.
+	//-----------------------------------------------------------
+	ITexture* ISwapchain::GetBackBuffer(u32 index)
+	{
+		auto&& buffers = Self()->backBuffers_;
+		assert(index < buffers.size());
+		return buffers[index];
 	}
 
 #undef Self
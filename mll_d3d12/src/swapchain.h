@@ -2,6 +2,8 @@
 
 #include "native.h"
 
+#include <vector>
+
 
 namespace mll
 {
@@ -9,11 +11,16 @@ namespace mll
 
 	//-----------------------------------------------------------
 	//! @brief swapchain.
+	//!
+	//! Without window handle, swapchain is offscreen and back buffers are render target textures.
 	//-----------------------------------------------------------
 	class Swapchain
 		: public ISwapchain
 	{
+		MLL_DECLARE_POOL_ALLOCATOR();
+
 		friend class IDevice;
+		friend class ISwapchain;
 
 	public:
 		// getter
@@ -44,6 +51,8 @@ namespace mll
 
 		HANDLE		event_ = nullptr;
 		u32			frameIndex_ = 0;
+
+		std::vector<ObjPtr<ITexture>>	backBuffers_;
 	};	// class Swapchain
 
 }
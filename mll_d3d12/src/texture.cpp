@@ -7,11 +7,22 @@
 
 namespace mll
 {
+	MLL_IMPLEMENT_POOL_ALLOCATOR(Texture, AllocCategory::Texture);
+
 	void Texture::Release()
 	{
 		KillSelf();
 	}
 
+	void Texture::OnObjectNameChanged()
+	{
+		auto device = static_cast<Device*>(pParentDevice_);
+		if (device->IsNativeObjectNameEnabled())
+		{
+			SetNativeObjectName(pResource_, GetObjectName());
+		}
+	}
+
 	//-----------------------------------------------------------
 	// initialize native command list.
 	//-----------------------------------------------------------
@@ -74,22 +85,258 @@ namespace mll
 			{
 				return Result::InvalidOperation;
 			}
+
+			auto info = pDevice->GetNativeDevice()->GetResourceAllocationInfo(GetNodeMask(), 1, &rd);
+			SetMemoryFootprint(desc.heap, info.SizeInBytes);
+
+			return CreateViews(pDevice);
+		}
+
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// initialize with existing native resource, take its reference.
+	//-----------------------------------------------------------
+	Result::Type Texture::InitializeFromNative(Device* pDevice, const TextureDesc& desc, ID3D12Resource* pResource)
+	{
+		desc_ = desc;
+
+		if (pResource == nullptr)
+		{
+			return Result::InvalidArgs;
+		}
+		pResource_ = pResource;
+
+		auto rd = pResource_->GetDesc();
+		auto info = pDevice->GetNativeDevice()->GetResourceAllocationInfo(GetNodeMask(), 1, &rd);
+		SetMemoryFootprint(desc.heap, info.SizeInBytes);
+
+		return CreateViews(pDevice);
+	}
+
+	//-----------------------------------------------------------
+	// create views once, command lists copy them per draw.
+	//-----------------------------------------------------------
+	Result::Type Texture::CreateViews(Device* pDevice)
+	{
+		pDevice_ = pDevice;
+		auto p_native = pDevice->GetNativeDevice();
+		bool is_depth = desc_.usageFlags & ResourceUsageFlag::DepthStencil;
+
+		if (desc_.usageFlags & ResourceUsageFlag::ShaderResource)
+		{
+			srv_ = pDevice->GetCpuDescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)->Allocate();
+			if (!srv_.IsValid())
+			{
+				return Result::OutOfMemory;
+			}
+
+			if (is_depth)
+			{
+				// depth resource is typeless, view needs readable format.
+				D3D12_SHADER_RESOURCE_VIEW_DESC vd{};
+				switch (GetNativeResourceFormat(desc_.format))
+				{
+				case DXGI_FORMAT_D32_FLOAT:
+					vd.Format = DXGI_FORMAT_R32_FLOAT; break;
+				case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+					vd.Format = DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS; break;
+				case DXGI_FORMAT_D24_UNORM_S8_UINT:
+					vd.Format = DXGI_FORMAT_R24_UNORM_X8_TYPELESS; break;
+				default:
+					vd.Format = DXGI_FORMAT_R16_UNORM; break;
+				}
+				vd.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+				if (desc_.sampleCount > 1)
+				{
+					vd.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DMSARRAY;
+					vd.Texture2DMSArray.ArraySize = desc_.arraySize;
+				}
+				else
+				{
+					vd.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+					vd.Texture2DArray.MipLevels = static_cast<UINT>(-1);
+					vd.Texture2DArray.ArraySize = desc_.arraySize;
+				}
+				p_native->CreateShaderResourceView(pResource_, &vd, srv_.cpuHandle);
+			}
+			else
+			{
+				p_native->CreateShaderResourceView(pResource_, nullptr, srv_.cpuHandle);
+			}
+		}
+
+		if (desc_.usageFlags & ResourceUsageFlag::UnorderedAccess)
+		{
+			uav_ = pDevice->GetCpuDescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)->Allocate();
+			if (!uav_.IsValid())
+			{
+				return Result::OutOfMemory;
+			}
+			p_native->CreateUnorderedAccessView(pResource_, nullptr, nullptr, uav_.cpuHandle);
+		}
+
+		// bindless indices are stable while texture lives.
+		auto p_bindless = pDevice->GetBindlessHeap();
+		if (p_bindless != nullptr)
+		{
+			if (srv_.IsValid())
+			{
+				bindlessSrvIndex_ = p_bindless->Allocate(srv_.cpuHandle);
+				if (bindlessSrvIndex_ == kInvalidBindlessIndex)
+				{
+					return Result::OutOfMemory;
+				}
+			}
+			if (uav_.IsValid())
+			{
+				bindlessUavIndex_ = p_bindless->Allocate(uav_.cpuHandle);
+				if (bindlessUavIndex_ == kInvalidBindlessIndex)
+				{
+					return Result::OutOfMemory;
+				}
+			}
+		}
+
+		if (desc_.usageFlags & ResourceUsageFlag::RenderTarget)
+		{
+			rtv_ = pDevice->GetCpuDescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_RTV)->Allocate();
+			if (!rtv_.IsValid())
+			{
+				return Result::OutOfMemory;
+			}
+			D3D12_RENDER_TARGET_VIEW_DESC vd;
+			GetRenderTargetViewDesc(0, vd);
+			p_native->CreateRenderTargetView(pResource_, &vd, rtv_.cpuHandle);
+		}
+
+		if (is_depth)
+		{
+			dsv_ = pDevice->GetCpuDescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_DSV)->Allocate();
+			if (!dsv_.IsValid())
+			{
+				return Result::OutOfMemory;
+			}
+			D3D12_DEPTH_STENCIL_VIEW_DESC vd;
+			GetDepthStencilViewDesc(0, vd);
+			p_native->CreateDepthStencilView(pResource_, &vd, dsv_.cpuHandle);
 		}
 
 		return Result::Ok;
 	}
 
+	//-----------------------------------------------------------
+	// make render target view description of a subresource.
+	//-----------------------------------------------------------
+	void Texture::GetRenderTargetViewDesc(u32 subresource, D3D12_RENDER_TARGET_VIEW_DESC& outDesc) const
+	{
+		u32 mip_levels = (desc_.mipLevels > 0) ? desc_.mipLevels : 1;
+		u32 mip = subresource % mip_levels;
+		u32 slice = subresource / mip_levels;
+
+		outDesc = D3D12_RENDER_TARGET_VIEW_DESC{};
+		outDesc.Format = GetNativeResourceFormat(desc_.format);
+		switch (desc_.dimension)
+		{
+		case ResourceDimension::Texture1D:
+			outDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE1DARRAY;
+			outDesc.Texture1DArray.MipSlice = mip;
+			outDesc.Texture1DArray.FirstArraySlice = slice;
+			outDesc.Texture1DArray.ArraySize = 1;
+			break;
+		case ResourceDimension::Texture3D:
+			outDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE3D;
+			outDesc.Texture3D.MipSlice = mip;
+			outDesc.Texture3D.FirstWSlice = 0;
+			outDesc.Texture3D.WSize = static_cast<UINT>(-1);
+			break;
+		default:
+			if (desc_.sampleCount > 1)
+			{
+				outDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DMSARRAY;
+				outDesc.Texture2DMSArray.FirstArraySlice = slice;
+				outDesc.Texture2DMSArray.ArraySize = 1;
+			}
+			else
+			{
+				outDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DARRAY;
+				outDesc.Texture2DArray.MipSlice = mip;
+				outDesc.Texture2DArray.FirstArraySlice = slice;
+				outDesc.Texture2DArray.ArraySize = 1;
+			}
+			break;
+		}
+	}
+
+	//-----------------------------------------------------------
+	// make depth stencil view description of a subresource.
+	//-----------------------------------------------------------
+	void Texture::GetDepthStencilViewDesc(u32 subresource, D3D12_DEPTH_STENCIL_VIEW_DESC& outDesc) const
+	{
+		u32 mip_levels = (desc_.mipLevels > 0) ? desc_.mipLevels : 1;
+		u32 mip = subresource % mip_levels;
+		u32 slice = subresource / mip_levels;
+
+		outDesc = D3D12_DEPTH_STENCIL_VIEW_DESC{};
+		outDesc.Format = GetNativeResourceFormat(desc_.format);
+		if (desc_.sampleCount > 1)
+		{
+			outDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2DMSARRAY;
+			outDesc.Texture2DMSArray.FirstArraySlice = slice;
+			outDesc.Texture2DMSArray.ArraySize = 1;
+		}
+		else
+		{
+			outDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2DARRAY;
+			outDesc.Texture2DArray.MipSlice = mip;
+			outDesc.Texture2DArray.FirstArraySlice = slice;
+			outDesc.Texture2DArray.ArraySize = 1;
+		}
+	}
+
 	//-----------------------------------------------------------
 	// destroy native command list.
 	//-----------------------------------------------------------
 	void Texture::Destroy()
 	{
+		if (pDevice_ != nullptr)
+		{
+			// views may be copied by command lists until in flight submissions complete.
+			pDevice_->GetCpuDescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)->FreeDeferred(srv_);
+			pDevice_->GetCpuDescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)->FreeDeferred(uav_);
+			pDevice_->GetCpuDescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_RTV)->FreeDeferred(rtv_);
+			pDevice_->GetCpuDescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_DSV)->FreeDeferred(dsv_);
+			srv_ = uav_ = rtv_ = dsv_ = CpuDescriptor();
+			if (pDevice_->GetBindlessHeap() != nullptr)
+			{
+				pDevice_->GetBindlessHeap()->FreeDeferred(bindlessSrvIndex_);
+				pDevice_->GetBindlessHeap()->FreeDeferred(bindlessUavIndex_);
+			}
+			bindlessSrvIndex_ = bindlessUavIndex_ = kInvalidBindlessIndex;
+			pDevice_ = nullptr;
+		}
 		SafeRelease(pResource_);
 	}
 
 
 #define Self()	static_cast<Texture*>(this)
 
+	//-----------------------------------------------------------
+	// get bindless index of shader resource view.
+	//-----------------------------------------------------------
+	u32 ITexture::GetBindlessSrvIndex() const
+	{
+		return static_cast<const Texture*>(this)->bindlessSrvIndex_;
+	}
+
+	//-----------------------------------------------------------
+	// get bindless index of unordered access view.
+	//-----------------------------------------------------------
+	u32 ITexture::GetBindlessUavIndex() const
+	{
+		return static_cast<const Texture*>(this)->bindlessUavIndex_;
+	}
 
 #undef Self
 }
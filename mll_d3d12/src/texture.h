@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include "native.h"
+#include "descriptor_util.h"
 
 
 namespace mll
@@ -13,7 +14,11 @@ namespace mll
 	class Texture
 		: public ITexture
 	{
+		MLL_DECLARE_POOL_ALLOCATOR();
+
 		friend class IDevice;
+		friend class ITexture;
+		friend class Device;
 
 	public:
 		// getter
@@ -22,6 +27,34 @@ namespace mll
 			return pResource_;
 		}
 
+		// persistent views created with texture, invalid if usage does not allow.
+		const CpuDescriptor& GetShaderResourceView() const
+		{
+			return srv_;
+		}
+		const CpuDescriptor& GetUnorderedAccessView() const
+		{
+			return uav_;
+		}
+		const CpuDescriptor& GetRenderTargetView() const		// subresource 0.
+		{
+			return rtv_;
+		}
+		const CpuDescriptor& GetDepthStencilView() const		// subresource 0.
+		{
+			return dsv_;
+		}
+
+		/**
+		 * @brief make render target view description of a subresource.
+		*/
+		void GetRenderTargetViewDesc(u32 subresource, D3D12_RENDER_TARGET_VIEW_DESC& outDesc) const;
+
+		/**
+		 * @brief make depth stencil view description of a subresource.
+		*/
+		void GetDepthStencilViewDesc(u32 subresource, D3D12_DEPTH_STENCIL_VIEW_DESC& outDesc) const;
+
 	private:
 		Texture()
 			: ITexture()
@@ -32,15 +65,33 @@ namespace mll
 		}
 
 		Result::Type Initialize(Device* pDevice, const TextureDesc& desc);
+		Result::Type InitializeFromNative(Device* pDevice, const TextureDesc& desc, ID3D12Resource* pResource);
 		void Destroy();
 
+		/**
+		 * @brief create persistent views allowed by usage flags.
+		*/
+		Result::Type CreateViews(Device* pDevice);
+
 		/**
 		 * @brief Release self.
 		*/
 		void Release() override;
 
+		/**
+		 * @brief Propagate object name to native object.
+		*/
+		void OnObjectNameChanged() override;
+
 	private:
+		Device*				pDevice_ = nullptr;
 		ID3D12Resource*		pResource_ = nullptr;
+		CpuDescriptor		srv_;
+		CpuDescriptor		uav_;
+		CpuDescriptor		rtv_;
+		CpuDescriptor		dsv_;
+		u32					bindlessSrvIndex_ = kInvalidBindlessIndex;
+		u32					bindlessUavIndex_ = kInvalidBindlessIndex;
 	};	// class Texture
 
 }
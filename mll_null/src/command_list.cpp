@@ -0,0 +1,62 @@
+﻿#include "command_list.h"
+
+#include <cassert>
+
+#include "device.h"
+#include "texture.h"
+
+
+namespace mll
+{
+	MLL_IMPLEMENT_POOL_ALLOCATOR(CommandList, AllocCategory::CommandList);
+
+	void CommandList::Release()
+	{
+		KillSelf();
+	}
+
+	//-----------------------------------------------------------
+	// initialize command list.
+	//-----------------------------------------------------------
+	Result::Type CommandList::Initialize(Device* pDevice, const CommandListDesc& desc)
+	{
+		desc_ = desc;
+
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// destroy command list.
+	//-----------------------------------------------------------
+	void CommandList::Destroy()
+	{
+		stream_.Reset();
+	}
+
+
+#define Self()	static_cast<CommandList*>(this)
+
+	//-----------------------------------------------------------
+	// begin command load.
+	//-----------------------------------------------------------
+	void ICommandList::Begin()
+	{
+		auto p_this = Self();
+		assert(!p_this->isRecording_);
+		p_this->isRecording_ = true;
+		p_this->ResetStream();
+	}
+
+	//-----------------------------------------------------------
+	// end command load.
+	//-----------------------------------------------------------
+	void ICommandList::End()
+	{
+		auto p_this = Self();
+		assert(p_this->isRecording_);
+		p_this->isRecording_ = false;
+	}
+
+#undef Self
+}
+//	EOF
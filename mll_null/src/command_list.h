@@ -0,0 +1,40 @@
+﻿#pragma once
+
+#include "native.h"
+
+
+namespace mll
+{
+	class Device;
+
+	//-----------------------------------------------------------
+	//! @brief command list.
+	//-----------------------------------------------------------
+	class CommandList
+		: public ICommandList
+	{
+		MLL_DECLARE_POOL_ALLOCATOR();
+
+		friend class IDevice;
+		friend class ICommandList;
+
+	private:
+		CommandList()
+			: ICommandList()
+		{}
+		~CommandList()
+		{
+			Destroy();
+		}
+
+		Result::Type Initialize(Device* pDevice, const CommandListDesc& desc);
+		void Destroy();
+
+		/**
+		 * @brief Release self.
+		*/
+		void Release() override;
+	};	// class CommandList
+
+}
+//	EOF
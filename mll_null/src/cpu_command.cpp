@@ -0,0 +1,225 @@
+﻿#include "cpu_command.h"
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#include "texture.h"
+#include "texel_format.h"
+#include "mll/mll_thread_pool.h"
+
+
+namespace mll
+{
+	namespace
+	{
+		static const u32	kBandBytes = 64 * 1024;		// bytes processed by one task.
+		static const u32	kMaxTexelBytes = 16;
+
+		//-----------------------------------------------------------
+		// split rows of all depth slices into bands and run func(row) on thread pool.
+		//-----------------------------------------------------------
+		template <typename TFunc>
+		void ForEachRow(ThreadPool* pThreadPool, u32 rowCount, u32 rowBytes, TFunc func)
+		{
+			u32 rows_per_band = std::max<u32>(kBandBytes / std::max<u32>(rowBytes, 1), 1);
+			u32 band_count = (rowCount + rows_per_band - 1) / rows_per_band;
+			pThreadPool->ParallelFor(band_count, [&](u32 band)
+			{
+				u32 start = band * rows_per_band;
+				u32 end = std::min(start + rows_per_band, rowCount);
+				for (u32 row = start; row < end; row++)
+				{
+					func(row);
+				}
+			});
+		}
+
+		u8* GetRowPointer(Texture* pTex, const SubresourceLayout& layout, u32 row)
+		{
+			u32 z = row / layout.rowCount;
+			u32 y = row % layout.rowCount;
+			return pTex->GetMemory() + layout.offset + layout.slicePitch * z + static_cast<u64>(layout.rowPitch) * y;
+		}
+
+		u32 GetSampleCount(Texture* pTex)
+		{
+			return std::max<u32>(pTex->GetDesc().sampleCount, 1);
+		}
+
+		//! RGBA float buffer for one row, kept per thread.
+		f32* GetRowScratch(u32 texelCount)
+		{
+			static thread_local std::vector<f32> s_scratch;
+			if (s_scratch.size() < texelCount * 4)
+			{
+				s_scratch.resize(texelCount * 4);
+			}
+			return s_scratch.data();
+		}
+
+		//-----------------------------------------------------------
+		// fill subresource with encoded clear value.
+		//-----------------------------------------------------------
+		void ExecuteClear(ThreadPool* pThreadPool, const ClearTexturePacket& cmd)
+		{
+			auto p_tex = static_cast<Texture*>(cmd.pTexture);
+			auto format = p_tex->GetDesc().format;
+			assert(IsTexelConvertible(format));
+			assert(cmd.subresource < p_tex->GetSubresourceCount());
+			auto&& layout = p_tex->GetSubresourceLayout(cmd.subresource);
+
+			u8 texel[kMaxTexelBytes];
+			u32 texel_bytes = GetFormatInfo(format).bytesPerBlock;
+			EncodeTexels(format, cmd.color, 1, texel);
+
+			// build one row and copy it to every row.
+			std::vector<u8> row_data(layout.rowPitch);
+			for (u32 offset = 0; offset < layout.rowPitch; offset += texel_bytes)
+			{
+				memcpy(row_data.data() + offset, texel, texel_bytes);
+			}
+
+			ForEachRow(pThreadPool, layout.rowCount * layout.depth, layout.rowPitch, [&](u32 row)
+			{
+				memcpy(GetRowPointer(p_tex, layout, row), row_data.data(), layout.rowPitch);
+			});
+		}
+
+		//-----------------------------------------------------------
+		// copy subresource, convert format if needed.
+		//-----------------------------------------------------------
+		void ExecuteCopy(ThreadPool* pThreadPool, const CopyTexturePacket& cmd)
+		{
+			auto p_src = static_cast<Texture*>(cmd.pSrc);
+			auto p_dst = static_cast<Texture*>(cmd.pDst);
+			assert(cmd.srcSubresource < p_src->GetSubresourceCount());
+			assert(cmd.dstSubresource < p_dst->GetSubresourceCount());
+
+			auto src_format = p_src->GetDesc().format;
+			auto dst_format = p_dst->GetDesc().format;
+			auto&& src_layout = p_src->GetSubresourceLayout(cmd.srcSubresource);
+			auto&& dst_layout = p_dst->GetSubresourceLayout(cmd.dstSubresource);
+			assert(GetSampleCount(p_src) == GetSampleCount(p_dst));
+
+			u32 row_count = std::min(src_layout.rowCount, dst_layout.rowCount);
+			u32 depth = std::min(src_layout.depth, dst_layout.depth);
+
+			if (src_format == dst_format)
+			{
+				u32 row_bytes = std::min(src_layout.rowPitch, dst_layout.rowPitch);
+				ForEachRow(pThreadPool, row_count * depth, row_bytes, [&](u32 row)
+				{
+					u32 z = row / row_count;
+					u32 y = row % row_count;
+					memcpy(GetRowPointer(p_dst, dst_layout, z * dst_layout.rowCount + y),
+						GetRowPointer(p_src, src_layout, z * src_layout.rowCount + y),
+						row_bytes);
+				});
+				return;
+			}
+
+			assert(IsTexelConvertible(src_format) && IsTexelConvertible(dst_format));
+			u32 src_bytes = GetFormatInfo(src_format).bytesPerBlock;
+			u32 dst_bytes = GetFormatInfo(dst_format).bytesPerBlock;
+			u32 texel_count = std::min(src_layout.width, dst_layout.width) * GetSampleCount(p_src);
+			ForEachRow(pThreadPool, row_count * depth, texel_count * std::max(src_bytes, dst_bytes), [&](u32 row)
+			{
+				u32 z = row / row_count;
+				u32 y = row % row_count;
+				auto p_src_row = GetRowPointer(p_src, src_layout, z * src_layout.rowCount + y);
+				auto p_dst_row = GetRowPointer(p_dst, dst_layout, z * dst_layout.rowCount + y);
+				auto p_colors = GetRowScratch(texel_count);
+				DecodeTexels(src_format, p_src_row, texel_count, p_colors);
+				EncodeTexels(dst_format, p_colors, texel_count, p_dst_row);
+			});
+		}
+
+		//-----------------------------------------------------------
+		// resolve multisampled subresource, convert format if needed.
+		//-----------------------------------------------------------
+		void ExecuteResolve(ThreadPool* pThreadPool, const ResolveTexturePacket& cmd)
+		{
+			auto p_src = static_cast<Texture*>(cmd.pSrc);
+			auto p_dst = static_cast<Texture*>(cmd.pDst);
+			assert(cmd.srcSubresource < p_src->GetSubresourceCount());
+			assert(cmd.dstSubresource < p_dst->GetSubresourceCount());
+
+			auto src_format = p_src->GetDesc().format;
+			auto dst_format = p_dst->GetDesc().format;
+			assert(IsTexelConvertible(src_format) && IsTexelConvertible(dst_format));
+			assert(GetSampleCount(p_dst) == 1);
+
+			auto&& src_layout = p_src->GetSubresourceLayout(cmd.srcSubresource);
+			auto&& dst_layout = p_dst->GetSubresourceLayout(cmd.dstSubresource);
+			u32 sample_count = GetSampleCount(p_src);
+			u32 src_bytes = GetFormatInfo(src_format).bytesPerBlock;
+
+			// integer samples can not be averaged, take the first sample.
+			u32 average_count = IsIntegerFormat(src_format) ? 1 : sample_count;
+			f32 inv_count = 1.0f / static_cast<f32>(average_count);
+
+			u32 row_count = std::min(src_layout.rowCount, dst_layout.rowCount);
+			u32 depth = std::min(src_layout.depth, dst_layout.depth);
+			u32 width = std::min(src_layout.width, dst_layout.width);
+			ForEachRow(pThreadPool, row_count * depth, width * src_bytes * sample_count, [&](u32 row)
+			{
+				u32 z = row / row_count;
+				u32 y = row % row_count;
+				auto p_src_row = GetRowPointer(p_src, src_layout, z * src_layout.rowCount + y);
+				auto p_dst_row = GetRowPointer(p_dst, dst_layout, z * dst_layout.rowCount + y);
+
+				// decode all samples, then average in place to the first width texels.
+				auto p_colors = GetRowScratch(width * sample_count);
+				DecodeTexels(src_format, p_src_row, width * sample_count, p_colors);
+				for (u32 x = 0; x < width; x++)
+				{
+					const f32* p_samples = p_colors + x * sample_count * 4;
+					f32 sum[4] = {};
+					for (u32 s = 0; s < average_count; s++)
+					{
+						for (u32 c = 0; c < 4; c++)
+						{
+							sum[c] += p_samples[s * 4 + c];
+						}
+					}
+					for (u32 c = 0; c < 4; c++)
+					{
+						p_colors[x * 4 + c] = sum[c] * inv_count;
+					}
+				}
+				EncodeTexels(dst_format, p_colors, width, p_dst_row);
+			});
+		}
+	}
+
+	//-----------------------------------------------------------
+	// execute recorded commands in order.
+	//-----------------------------------------------------------
+	void ExecuteCpuCommands(ThreadPool* pThreadPool, const CommandStream& stream)
+	{
+		stream.ForEach([&](const CommandPacketHeader& header)
+		{
+			switch (header.type)
+			{
+			case CommandPacketType::ClearTexture:
+				ExecuteClear(pThreadPool, CommandStream::Cast<ClearTexturePacket>(header));
+				break;
+			case CommandPacketType::CopyTexture:
+				ExecuteCopy(pThreadPool, CommandStream::Cast<CopyTexturePacket>(header));
+				break;
+			case CommandPacketType::ResolveTexture:
+				ExecuteResolve(pThreadPool, CommandStream::Cast<ResolveTexturePacket>(header));
+				break;
+			case CommandPacketType::ExecuteBundle:
+				ExecuteCpuCommands(pThreadPool, CommandStream::Cast<ExecuteBundlePacket>(header).pBundle->GetCommandStream());
+				break;
+			default:
+				assert(false);
+				break;
+			}
+		});
+	}
+
+}
+//	EOF
@@ -0,0 +1,18 @@
+﻿#pragma once
+
+#include "native.h"
+
+
+namespace mll
+{
+	class ThreadPool;
+
+	/**
+	 * @brief execute recorded commands in order.
+	 *
+	 * @note Each command is split into row bands and processed on thread pool.
+	*/
+	void ExecuteCpuCommands(ThreadPool* pThreadPool, const CommandStream& stream);
+
+}
+//	EOF
@@ -0,0 +1,290 @@
+﻿#include "device.h"
+
+#include <cassert>
+
+#include "command_list.h"
+#include "cpu_command.h"
+#include "swapchain.h"
+#include "texture.h"
+
+
+namespace mll
+{
+	//-----------------------------------------------------------
+	// Initialize command queues.
+	//-----------------------------------------------------------
+	bool CommandQueue::Initialize(Device* pDevice)
+	{
+		for (u32 i = 0; i < CommandQueueType::MAX; i++)
+		{
+			signaledValues_[i].store(0);
+			completedValues_[i].store(0);
+		}
+		return true;
+	}
+
+	//-----------------------------------------------------------
+	// Destroy each command queue.
+	//-----------------------------------------------------------
+	void CommandQueue::Destroy()
+	{}
+
+	//-----------------------------------------------------------
+	// Wait all command queues idle.
+	//-----------------------------------------------------------
+	void CommandQueue::WaitIdle()
+	{
+		// take each queue lock to wait for executing commands.
+		for (u32 i = 0; i < CommandQueueType::MAX; i++)
+		{
+			Signal(static_cast<CommandQueueType::Type>(i));
+		}
+	}
+
+
+	//-----------------------------------------------------------
+	// Release device.
+	//-----------------------------------------------------------
+	void IDevice::Release()
+	{
+		MLL_DELETE(this);
+	}
+
+	//-----------------------------------------------------------
+	// Get last fence value signaled on command queue.
+	//-----------------------------------------------------------
+	u64 IDevice::GetSignaledFenceValue(CommandQueueType::Type type)
+	{
+		return static_cast<Device*>(this)->GetCommandQueue()->GetSignaledFenceValue(type);
+	}
+
+	//-----------------------------------------------------------
+	// Get fence value completed on command queue.
+	//-----------------------------------------------------------
+	u64 IDevice::GetCompletedFenceValue(CommandQueueType::Type type)
+	{
+		return static_cast<Device*>(this)->GetCommandQueue()->GetCompletedFenceValue(type);
+	}
+
+	//-----------------------------------------------------------
+	// Graphics device create function.
+	//-----------------------------------------------------------
+	ObjPtr<IDevice> IDevice::CreateGraphicsDevice(const DeviceDesc& desc)
+	{
+		auto ret = MLL_NEW(Device);
+
+		auto init_result = ret->Initialize(desc);
+		if (!init_result)
+		{
+			MLL_DELETE(ret);
+			return ObjPtr<IDevice>();
+		}
+
+		return ObjPtr<IDevice>(ret);
+	}
+
+	//-----------------------------------------------------------
+	// Initialize device.
+	//-----------------------------------------------------------
+	bool Device::Initialize(const DeviceDesc& desc)
+	{
+		// CommandQueue生成
+		pCommandQueue_ = MLL_NEW(CommandQueue);
+		assert(pCommandQueue_ != nullptr);
+		if (!pCommandQueue_->Initialize(this))
+		{
+			return false;
+		}
+
+		pThreadPool_ = MLL_NEW(ThreadPool);
+		assert(pThreadPool_ != nullptr);
+		pThreadPool_->Initialize(desc.workerThreadCount);
+
+		InitializeDeathList(desc);
+
+		return true;
+	}
+
+	//-----------------------------------------------------------
+	// Destroy device.
+	//-----------------------------------------------------------
+	void Device::Destroy()
+	{
+		if (pCommandQueue_ != nullptr)
+		{
+			pCommandQueue_->WaitIdle();
+		}
+		FinalizeDeathList();
+
+		// killed objects are removed from live objects in death list processing.
+		u32 live_obj_cnt = IterateLiveObjects([](IDeviceChild* p) {});
+		assert(live_obj_cnt == 0);
+		(void)live_obj_cnt;
+
+		MLL_DELETE(pThreadPool_);
+		pThreadPool_ = nullptr;
+		MLL_DELETE(pCommandQueue_);
+		pCommandQueue_ = nullptr;
+	}
+
+
+	//-----------------------------------------------------------
+	// Submit command lists at once.
+	//-----------------------------------------------------------
+	SubmitTicket IDevice::Submit(CommandQueueType::Type type, ICommandList* const* ppCmdLists, u32 count, const SubmitTicket* pWaitTickets, u32 waitTicketCount)
+	{
+		CaptureSubmit(type, ppCmdLists, count);
+
+		auto p_device = static_cast<Device*>(this);
+		auto p_queue = p_device->GetCommandQueue();
+
+		SubmitTicket ticket;
+		ticket.queueType = type;
+		ticket.fenceValue = p_queue->ExecuteAndSignal(type, [&]
+		{
+			// wait other queues on CPU, execution is synchronous so these are nearly always completed.
+			for (u32 i = 0; i < waitTicketCount; i++)
+			{
+				if (pWaitTickets[i].queueType != type)
+				{
+					p_queue->WaitFence(pWaitTickets[i].queueType, pWaitTickets[i].fenceValue);
+				}
+			}
+
+			for (u32 i = 0; i < count; i++)
+			{
+				auto p_list = static_cast<CommandList*>(ppCmdLists[i]);
+				assert(!p_list->IsRecording() && !p_list->IsBundle());
+				assert(p_list->GetDesc().typeCommandQueue == type);
+				assert(!p_list->IsExecutedBundleChanged());
+				ExecuteCpuCommands(p_device->GetThreadPool(), p_list->GetCommandStream());
+			}
+		});
+		return ticket;
+	}
+
+	//-----------------------------------------------------------
+	// Wait submission on CPU.
+	//-----------------------------------------------------------
+	void IDevice::WaitTicket(const SubmitTicket& ticket)
+	{
+		static_cast<Device*>(this)->GetCommandQueue()->WaitFence(ticket.queueType, ticket.fenceValue);
+	}
+
+	//-----------------------------------------------------------
+	// Get command allocator pool statistics.
+	//-----------------------------------------------------------
+	void IDevice::GetCommandAllocatorStats(CommandQueueType::Type type, CommandAllocatorStats& outStats)
+	{
+		// command stream is executed directly, no native allocator.
+		outStats = CommandAllocatorStats();
+	}
+
+	//-----------------------------------------------------------
+	// Get descriptor ring statistics.
+	//-----------------------------------------------------------
+	void IDevice::GetDescriptorRingStats(CommandQueueType::Type type, DescriptorRingStats& outStats)
+	{
+		// command stream is executed directly, no descriptor heap.
+		outStats = DescriptorRingStats();
+	}
+
+	//-----------------------------------------------------------
+	// Get sampler cache statistics.
+	//-----------------------------------------------------------
+	void IDevice::GetSamplerCacheStats(SamplerCacheStats& outStats)
+	{
+		// command stream is executed directly, no descriptor heap.
+		outStats = SamplerCacheStats();
+	}
+
+	//-----------------------------------------------------------
+	// Create command list.
+	//-----------------------------------------------------------
+	Result::Type IDevice::CreateCommandList(const CommandListDesc& desc, ObjPtr<ICommandList>& outObj)
+	{
+		auto p = MLL_NEW(CommandList);
+
+		auto result = p->Initialize(static_cast<Device*>(this), desc);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+			return result;
+		}
+
+		result = AppendDeviceChild<ICommandList>(p, outObj);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+		}
+		return result;
+	}
+
+	//-----------------------------------------------------------
+	// Create swapchain.
+	//-----------------------------------------------------------
+	Result::Type IDevice::CreateSwapchain(const SwapchainDesc& desc, ObjPtr<ISwapchain>& outObj)
+	{
+		auto p = MLL_NEW(Swapchain);
+
+		auto result = p->Initialize(static_cast<Device*>(this), desc);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+			return result;
+		}
+
+		result = AppendDeviceChild<ISwapchain>(p, outObj);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+		}
+		return result;
+	}
+
+	//-----------------------------------------------------------
+	// Create texture.
+	//-----------------------------------------------------------
+	Result::Type IDevice::CreateTexture(const TextureDesc& desc, ObjPtr<ITexture>& outObj)
+	{
+		auto p = MLL_NEW(Texture);
+
+		auto result = p->Initialize(static_cast<Device*>(this), desc);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+			return result;
+		}
+
+		result = AppendDeviceChild<ITexture>(p, outObj);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+		}
+		return result;
+	}
+
+	//-----------------------------------------------------------
+	// Create texture on external memory.
+	//-----------------------------------------------------------
+	Result::Type Device::CreateExternalTexture(const TextureDesc& desc, u8* pMemory, u64 memorySize, ObjPtr<ITexture>& outObj)
+	{
+		auto p = MLL_NEW(Texture);
+
+		auto result = p->InitializeExternal(this, desc, pMemory, memorySize);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+			return result;
+		}
+
+		result = AppendDeviceChild<ITexture>(p, outObj);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+		}
+		return result;
+	}
+
+}
+//	EOF
@@ -0,0 +1,141 @@
+﻿#pragma once
+
+#include "native.h"
+#include "mll/mll_thread_pool.h"
+
+#include <cassert>
+#include <thread>
+
+
+namespace mll
+{
+	class Device;
+
+	//-----------------------------------------------------------
+	//! @brief Command queues.
+	//!
+	//! Null queues have no GPU timeline, submitted commands are executed on CPU
+	//! before the fence is signaled.
+	//-----------------------------------------------------------
+	class CommandQueue
+	{
+		MLL_DECLARE_CLASS_ALLOCATOR(AllocCategory::Device);
+
+	public:
+		CommandQueue()
+		{}
+		~CommandQueue()
+		{
+			Destroy();
+		}
+
+		bool Initialize(Device* pDevice);
+		void Destroy();
+
+		/**
+		 * @brief execute commands and signal fence on command queue.
+		 *
+		 * @param[in]	type		command queue type.
+		 * @param[in]	func		function to execute commands.
+		 * @return					signaled fence value.
+		*/
+		template <typename TFunc>
+		u64 ExecuteAndSignal(CommandQueueType::Type type, TFunc func)
+		{
+			std::lock_guard<std::mutex> lock(queueMutexes_[type]);
+
+			// publish fence value before execution.
+			// objects killed after this point wait for this value.
+			u64 value = signaledValues_[type].load() + 1;
+			signaledValues_[type].store(value);
+
+			func();
+			completedValues_[type].store(value);
+			return value;
+		}
+
+		/**
+		 * @brief signal fence on command queue.
+		*/
+		u64 Signal(CommandQueueType::Type type)
+		{
+			return ExecuteAndSignal(type, [] {});
+		}
+
+		/**
+		 * @brief wait until fence value is completed.
+		 *
+		 * @note Submissions on other threads may be executing.
+		*/
+		void WaitFence(CommandQueueType::Type type, u64 value)
+		{
+			assert(value <= signaledValues_[type].load());
+			while (completedValues_[type].load() < value)
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		/**
+		 * @brief wait all command queues idle.
+		*/
+		void WaitIdle();
+
+		u64 GetSignaledFenceValue(CommandQueueType::Type type) const
+		{
+			return signaledValues_[type].load();
+		}
+		u64 GetCompletedFenceValue(CommandQueueType::Type type) const
+		{
+			return completedValues_[type].load();
+		}
+
+	private:
+		std::atomic<u64>	signaledValues_[CommandQueueType::MAX];
+		std::atomic<u64>	completedValues_[CommandQueueType::MAX];
+		std::mutex			queueMutexes_[CommandQueueType::MAX];
+	};	// class CommandQueue
+
+	//-----------------------------------------------------------
+	//! @brief Graphics device object.
+	//-----------------------------------------------------------
+	class Device
+		: public IDevice
+	{
+		friend class IDevice;
+
+	public:
+		Device()
+		{}
+		~Device()
+		{
+			Destroy();
+		}
+
+		CommandQueue* GetCommandQueue()
+		{
+			return pCommandQueue_;
+		}
+		ThreadPool* GetThreadPool()
+		{
+			return pThreadPool_;
+		}
+
+		/**
+		 * @brief create texture on external memory.
+		 *
+		 * @note Memory must outlive texture.
+		*/
+		Result::Type CreateExternalTexture(const TextureDesc& desc, u8* pMemory, u64 memorySize, ObjPtr<ITexture>& outObj);
+
+	private:
+		bool Initialize(const DeviceDesc& desc);
+		void Destroy();
+
+	private:
+		CommandQueue*		pCommandQueue_ = nullptr;
+		ThreadPool*			pThreadPool_ = nullptr;
+	};	// class Device
+
+}
+//	EOF
@@ -0,0 +1,96 @@
+﻿#pragma once
+
+#include "mll/mll_defines.h"
+#include "mll/mll_interfaces.h"
+
+
+namespace mll
+{
+	//-----------------------------------------------------------
+	//! @brief resource format layout.
+	//-----------------------------------------------------------
+	struct FormatInfo
+	{
+		u32		blockWidth;			//!< 1 for uncompressed format.
+		u32		blockHeight;		//!< 1 for uncompressed format.
+		u32		bytesPerBlock;
+	};	// struct FormatInfo
+
+	/**
+	 * @brief get format layout.
+	*/
+	inline const FormatInfo& GetFormatInfo(ResourceFormat::Type v)
+	{
+		static const FormatInfo k[] = {
+			{ 1, 1,  0 },		// Unknown
+			{ 1, 1, 16 },		// R32G32B32A32_Float
+			{ 1, 1, 16 },		// R32G32B32A32_Uint
+			{ 1, 1, 16 },		// R32G32B32A32_Sint
+			{ 1, 1, 12 },		// R32G32B32_Float
+			{ 1, 1, 12 },		// R32G32B32_Uint
+			{ 1, 1, 12 },		// R32G32B32_Sint
+			{ 1, 1,  8 },		// R32G32_Float
+			{ 1, 1,  8 },		// R32G32_Uint
+			{ 1, 1,  8 },		// R32G32_Sint
+			{ 1, 1,  4 },		// R32_Float
+			{ 1, 1,  4 },		// R32_Uint
+			{ 1, 1,  4 },		// R32_Sint
+			{ 1, 1,  8 },		// R16G16B16A16_Float
+			{ 1, 1,  8 },		// R16G16B16A16_Unorm
+			{ 1, 1,  8 },		// R16G16B16A16_Uint
+			{ 1, 1,  8 },		// R16G16B16A16_Snorm
+			{ 1, 1,  8 },		// R16G16B16A16_Sint
+			{ 1, 1,  4 },		// R16G16_Float
+			{ 1, 1,  4 },		// R16G16_Unorm
+			{ 1, 1,  4 },		// R16G16_Uint
+			{ 1, 1,  4 },		// R16G16_Snorm
+			{ 1, 1,  4 },		// R16G16_Sint
+			{ 1, 1,  2 },		// R16_Float
+			{ 1, 1,  2 },		// R16_Unorm
+			{ 1, 1,  2 },		// R16_Uint
+			{ 1, 1,  2 },		// R16_Snorm
+			{ 1, 1,  2 },		// R16_Sint
+			{ 1, 1,  4 },		// R8G8B8A8_Unorm
+			{ 1, 1,  4 },		// R8G8B8A8_Unorm_Srgb
+			{ 1, 1,  4 },		// R8G8B8A8_Uint
+			{ 1, 1,  4 },		// R8G8B8A8_Snorm
+			{ 1, 1,  4 },		// R8G8B8A8_Sint
+			{ 1, 1,  2 },		// R8G8_Unorm
+			{ 1, 1,  2 },		// R8G8_Uint
+			{ 1, 1,  2 },		// R8G8_Snorm
+			{ 1, 1,  2 },		// R8G8_Sint
+			{ 1, 1,  1 },		// R8_Unorm
+			{ 1, 1,  1 },		// R8_Uint
+			{ 1, 1,  1 },		// R8_Snorm
+			{ 1, 1,  1 },		// R8_Sint
+			{ 1, 1,  4 },		// B8G8R8A8_Unorm
+			{ 1, 1,  4 },		// B8G8R8A8_Unorm_Srgb
+			{ 1, 1,  4 },		// B8G8R8X8_Unorm
+			{ 1, 1,  4 },		// B8G8R8X8_Unorm_Srgb
+			{ 1, 1,  4 },		// R10G10B10A2_Unorm
+			{ 1, 1,  4 },		// R10G10B10A2_Uint
+			{ 1, 1,  4 },		// R11G11B10_Float
+			{ 1, 1,  4 },		// D32_Float
+			{ 1, 1,  4 },		// D24_Unorm_S8_Uint
+			{ 1, 1,  2 },		// D16_Unorm
+			{ 4, 4,  8 },		// BC1_Unorm
+			{ 4, 4,  8 },		// BC1_Unorm_Srgb
+			{ 4, 4, 16 },		// BC2_Unorm
+			{ 4, 4, 16 },		// BC2_Unorm_Srgb
+			{ 4, 4, 16 },		// BC3_Unorm
+			{ 4, 4, 16 },		// BC3_Unorm_Srgb
+			{ 4, 4,  8 },		// BC4_Unorm
+			{ 4, 4,  8 },		// BC4_Snorm
+			{ 4, 4, 16 },		// BC5_Unorm
+			{ 4, 4, 16 },		// BC5_Snorm
+			{ 4, 4, 16 },		// BC6H_UFloat
+			{ 4, 4, 16 },		// BC6H_SFloat
+			{ 4, 4, 16 },		// BC7_Unorm
+			{ 4, 4, 16 },		// BC7_Unorm_Srgb
+		};
+		static_assert(sizeof(k) / sizeof(k[0]) == ResourceFormat::MAX, "format table size mismatch.");
+		return k[v];
+	}
+
+}
+//	EOF
@@ -0,0 +1,150 @@
+﻿#include "swapchain.h"
+
+#include <cassert>
+
+#include "device.h"
+
+
+namespace mll
+{
+	MLL_IMPLEMENT_POOL_ALLOCATOR(Swapchain, AllocCategory::Swapchain);
+
+	void Swapchain::Release()
+	{
+		KillSelf();
+	}
+
+	//-----------------------------------------------------------
+	// initialize swapchain.
+	//-----------------------------------------------------------
+	Result::Type Swapchain::Initialize(Device* pDevice, const SwapchainDesc& desc)
+	{
+		desc_ = desc;
+
+		if (desc.backBufferCount == 0 || desc.width == 0 || desc.height == 0 || desc.format == ResourceFormat::Unknown)
+		{
+			return Result::InvalidArgs;
+		}
+		frameIndex_.store(0);
+
+		TextureDesc tex_desc;
+		tex_desc.SetDimension(ResourceDimension::Texture2D)
+			.SetWidth(desc.width)
+			.SetHeight(desc.height)
+			.SetFormat(desc.format)
+			.SetUsageFlags(ResourceUsageFlag::RenderTarget)
+			.SetInitialState(ResourceState::Present);
+
+		backBuffers_.resize(desc.backBufferCount);
+		useFrameRing_ = desc.frameRingName != nullptr;
+		if (!useFrameRing_)
+		{
+			for (auto&& buffer : backBuffers_)
+			{
+				auto result = pDevice->CreateTexture(tex_desc, buffer);
+				if (IsFailed(result))
+				{
+					return result;
+				}
+			}
+			return Result::Ok;
+		}
+
+		// frame ring is offscreen only.
+		auto&& info = GetFormatInfo(desc.format);
+		if (desc.windowHandle != nullptr || info.blockWidth != 1 || desc.backBufferCount < 2)
+		{
+			return Result::InvalidArgs;
+		}
+
+		FrameRingDesc ring_desc;
+		ring_desc.name = desc.frameRingName;
+		ring_desc.width = desc.width;
+		ring_desc.height = desc.height;
+		ring_desc.rowPitch = desc.width * info.bytesPerBlock;
+		ring_desc.format = desc.format;
+		ring_desc.depth = desc.backBufferCount;
+		ring_desc.policy = desc.frameRingPolicy;
+		auto result = frameRing_.Create(ring_desc);
+		if (IsFailed(result))
+		{
+			return result;
+		}
+
+		// back buffers are rendered in place, present copies nothing.
+		u64 frame_bytes = static_cast<u64>(ring_desc.rowPitch) * ring_desc.height;
+		for (u32 i = 0; i < desc.backBufferCount; i++)
+		{
+			result = pDevice->CreateExternalTexture(tex_desc, frameRing_.GetSlotMemory(i), frame_bytes, backBuffers_[i]);
+			if (IsFailed(result))
+			{
+				return result;
+			}
+		}
+		frameIndex_.store(frameRing_.GetCurrentSlot());
+
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// destroy swapchain.
+	//-----------------------------------------------------------
+	void Swapchain::Destroy()
+	{
+		// back buffers on ring memory are only released after this, never accessed.
+		backBuffers_.clear();
+		frameRing_.Destroy();
+		useFrameRing_ = false;
+	}
+
+
+#define Self()	static_cast<Swapchain*>(this)
+
+	//-----------------------------------------------------------
+	// present swapchain.
+	//-----------------------------------------------------------
+	void ISwapchain::Present(u32 syncInterval)
+	{
+		auto p_this = Self();
+		auto p_device = static_cast<Device*>(pParentDevice_);
+
+		// graphics commands are done on CPU here, so current back buffer is complete.
+		// frame ring may wait consumer with Backpressure policy, so it is published outside queue lock.
+		u32 next_index;
+		if (p_this->useFrameRing_)
+		{
+			next_index = p_this->frameRing_.Publish();
+		}
+		else
+		{
+			next_index = (p_this->frameIndex_.load() + 1) % desc_.backBufferCount;
+		}
+
+		// signal graphics fence after present to advance frame timeline.
+		p_device->GetCommandQueue()->ExecuteAndSignal(CommandQueueType::Graphics, [&]
+		{
+			p_this->frameIndex_.store(next_index);
+		});
+	}
+
+	//-----------------------------------------------------------
+	// get current backbuffer index.
+	//-----------------------------------------------------------
+	u32 ISwapchain::GetBackBufferIndex() const
+	{
+		return static_cast<const Swapchain*>(this)->frameIndex_.load();
+	}
+
+	//-----------------------------------------------------------
+	// get backbuffer texture.
+	//-----------------------------------------------------------
+	ITexture* ISwapchain::GetBackBuffer(u32 index)
+	{
+		auto&& buffers = Self()->backBuffers_;
+		assert(index < buffers.size());
+		return buffers[index];
+	}
+
+#undef Self
+}
+//	EOF
@@ -0,0 +1,53 @@
+﻿#pragma once
+
+#include "native.h"
+#include "mll/mll_frame_ring.h"
+
+#include <vector>
+
+
+namespace mll
+{
+	class Device;
+
+	//-----------------------------------------------------------
+	//! @brief swapchain.
+	//!
+	//! Null swapchain has no window, present only advances back buffer index.
+	//! With frame ring name, back buffers are slots of shared memory frame ring
+	//! and present publishes current back buffer to consumer process.
+	//-----------------------------------------------------------
+	class Swapchain
+		: public ISwapchain
+	{
+		MLL_DECLARE_POOL_ALLOCATOR();
+
+		friend class IDevice;
+		friend class ISwapchain;
+
+	private:
+		Swapchain()
+			: ISwapchain()
+		{}
+		~Swapchain()
+		{
+			Destroy();
+		}
+
+		Result::Type Initialize(Device* pDevice, const SwapchainDesc& desc);
+		void Destroy();
+
+		/**
+		 * @brief Release self.
+		*/
+		void Release() override;
+
+	private:
+		std::atomic<u32>				frameIndex_{ 0 };
+		FrameRingWriter					frameRing_;
+		bool							useFrameRing_ = false;
+		std::vector<ObjPtr<ITexture>>	backBuffers_;
+	};	// class Swapchain
+
+}
+//	EOF
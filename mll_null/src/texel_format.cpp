@@ -0,0 +1,491 @@
+﻿#include "texel_format.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+
+namespace mll
+{
+	namespace
+	{
+		enum ChannelKind
+		{
+			kFloat,
+			kUnorm,
+			kSnorm,
+			kUint,
+			kSint,
+			kSrgb,			// RGB is sRGB, A is unorm.
+			kPacked,		// special layout.
+			kCompressed,
+		};
+
+		struct TexelLayout
+		{
+			u8		channels;
+			u8		bytesPerChannel;
+			u8		kind;
+			bool	isBgr;
+		};	// struct TexelLayout
+
+		const TexelLayout& GetTexelLayout(ResourceFormat::Type v)
+		{
+			static const TexelLayout k[] = {
+				{ 0, 0, kCompressed, false },	// Unknown
+				{ 4, 4, kFloat, false },		// R32G32B32A32_Float
+				{ 4, 4, kUint, false },			// R32G32B32A32_Uint
+				{ 4, 4, kSint, false },			// R32G32B32A32_Sint
+				{ 3, 4, kFloat, false },		// R32G32B32_Float
+				{ 3, 4, kUint, false },			// R32G32B32_Uint
+				{ 3, 4, kSint, false },			// R32G32B32_Sint
+				{ 2, 4, kFloat, false },		// R32G32_Float
+				{ 2, 4, kUint, false },			// R32G32_Uint
+				{ 2, 4, kSint, false },			// R32G32_Sint
+				{ 1, 4, kFloat, false },		// R32_Float
+				{ 1, 4, kUint, false },			// R32_Uint
+				{ 1, 4, kSint, false },			// R32_Sint
+				{ 4, 2, kFloat, false },		// R16G16B16A16_Float
+				{ 4, 2, kUnorm, false },		// R16G16B16A16_Unorm
+				{ 4, 2, kUint, false },			// R16G16B16A16_Uint
+				{ 4, 2, kSnorm, false },		// R16G16B16A16_Snorm
+				{ 4, 2, kSint, false },			// R16G16B16A16_Sint
+				{ 2, 2, kFloat, false },		// R16G16_Float
+				{ 2, 2, kUnorm, false },		// R16G16_Unorm
+				{ 2, 2, kUint, false },			// R16G16_Uint
+				{ 2, 2, kSnorm, false },		// R16G16_Snorm
+				{ 2, 2, kSint, false },			// R16G16_Sint
+				{ 1, 2, kFloat, false },		// R16_Float
+				{ 1, 2, kUnorm, false },		// R16_Unorm
+				{ 1, 2, kUint, false },			// R16_Uint
+				{ 1, 2, kSnorm, false },		// R16_Snorm
+				{ 1, 2, kSint, false },			// R16_Sint
+				{ 4, 1, kUnorm, false },		// R8G8B8A8_Unorm
+				{ 4, 1, kSrgb, false },			// R8G8B8A8_Unorm_Srgb
+				{ 4, 1, kUint, false },			// R8G8B8A8_Uint
+				{ 4, 1, kSnorm, false },		// R8G8B8A8_Snorm
+				{ 4, 1, kSint, false },			// R8G8B8A8_Sint
+				{ 2, 1, kUnorm, false },		// R8G8_Unorm
+				{ 2, 1, kUint, false },			// R8G8_Uint
+				{ 2, 1, kSnorm, false },		// R8G8_Snorm
+				{ 2, 1, kSint, false },			// R8G8_Sint
+				{ 1, 1, kUnorm, false },		// R8_Unorm
+				{ 1, 1, kUint, false },			// R8_Uint
+				{ 1, 1, kSnorm, false },		// R8_Snorm
+				{ 1, 1, kSint, false },			// R8_Sint
+				{ 4, 1, kUnorm, true },			// B8G8R8A8_Unorm
+				{ 4, 1, kSrgb, true },			// B8G8R8A8_Unorm_Srgb
+				{ 4, 1, kUnorm, true },			// B8G8R8X8_Unorm
+				{ 4, 1, kSrgb, true },			// B8G8R8X8_Unorm_Srgb
+				{ 4, 0, kPacked, false },		// R10G10B10A2_Unorm
+				{ 4, 0, kPacked, false },		// R10G10B10A2_Uint
+				{ 3, 0, kPacked, false },		// R11G11B10_Float
+				{ 1, 4, kFloat, false },		// D32_Float
+				{ 2, 0, kPacked, false },		// D24_Unorm_S8_Uint
+				{ 1, 2, kUnorm, false },		// D16_Unorm
+				{ 0, 0, kCompressed, false },	// BC1_Unorm
+				{ 0, 0, kCompressed, false },	// BC1_Unorm_Srgb
+				{ 0, 0, kCompressed, false },	// BC2_Unorm
+				{ 0, 0, kCompressed, false },	// BC2_Unorm_Srgb
+				{ 0, 0, kCompressed, false },	// BC3_Unorm
+				{ 0, 0, kCompressed, false },	// BC3_Unorm_Srgb
+				{ 0, 0, kCompressed, false },	// BC4_Unorm
+				{ 0, 0, kCompressed, false },	// BC4_Snorm
+				{ 0, 0, kCompressed, false },	// BC5_Unorm
+				{ 0, 0, kCompressed, false },	// BC5_Snorm
+				{ 0, 0, kCompressed, false },	// BC6H_UFloat
+				{ 0, 0, kCompressed, false },	// BC6H_SFloat
+				{ 0, 0, kCompressed, false },	// BC7_Unorm
+				{ 0, 0, kCompressed, false },	// BC7_Unorm_Srgb
+			};
+			static_assert(sizeof(k) / sizeof(k[0]) == ResourceFormat::MAX, "format table size mismatch.");
+			return k[v];
+		}
+
+		//-----------------------------------------------------------
+		// half float conversion.
+		//-----------------------------------------------------------
+		f32 HalfToFloat(u16 h)
+		{
+			u32 sign = static_cast<u32>(h & 0x8000) << 16;
+			u32 exp = (h >> 10) & 0x1f;
+			u32 mant = h & 0x3ff;
+			u32 bits;
+			if (exp == 0)
+			{
+				if (mant == 0)
+				{
+					bits = sign;
+				}
+				else
+				{
+					// denormal, normalize it.
+					exp = 127 - 15 + 1;
+					while ((mant & 0x400) == 0)
+					{
+						mant <<= 1;
+						exp--;
+					}
+					bits = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+				}
+			}
+			else if (exp == 0x1f)
+			{
+				bits = sign | 0x7f800000 | (mant << 13);
+			}
+			else
+			{
+				bits = sign | ((exp + 127 - 15) << 23) | (mant << 13);
+			}
+			f32 ret;
+			memcpy(&ret, &bits, sizeof(ret));
+			return ret;
+		}
+		u16 FloatToHalf(f32 f)
+		{
+			u32 bits;
+			memcpy(&bits, &f, sizeof(bits));
+			u16 sign = static_cast<u16>((bits >> 16) & 0x8000);
+			s32 exp = static_cast<s32>((bits >> 23) & 0xff) - 127 + 15;
+			u32 mant = bits & 0x7fffff;
+
+			if (((bits >> 23) & 0xff) == 0xff)
+			{
+				// inf or nan.
+				return sign | 0x7c00 | (mant ? 0x200 : 0);
+			}
+			if (exp >= 0x1f)
+			{
+				return sign | 0x7c00;
+			}
+			if (exp <= 0)
+			{
+				if (exp < -10)
+				{
+					return sign;
+				}
+				// denormal, round to nearest.
+				mant |= 0x800000;
+				u32 shift = static_cast<u32>(14 - exp);
+				u32 half_mant = mant >> shift;
+				if ((mant >> (shift - 1)) & 1)
+				{
+					half_mant++;
+				}
+				return sign | static_cast<u16>(half_mant);
+			}
+			// round to nearest, carry may advance exponent.
+			u32 ret = (static_cast<u32>(exp) << 10) | (mant >> 13);
+			if (mant & 0x1000)
+			{
+				ret++;
+			}
+			return sign | static_cast<u16>(std::min<u32>(ret, 0x7c00));
+		}
+
+		//-----------------------------------------------------------
+		// sRGB conversion.
+		//-----------------------------------------------------------
+		f32 SrgbToLinear(f32 v)
+		{
+			return (v <= 0.04045f) ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+		}
+
+		//! all sRGB formats are 8 bits per channel, so decode with table.
+		struct SrgbDecodeTable
+		{
+			f32		values[256];
+
+			SrgbDecodeTable()
+			{
+				for (u32 i = 0; i < 256; i++)
+				{
+					values[i] = SrgbToLinear(static_cast<f32>(i) / 255.0f);
+				}
+			}
+		};	// struct SrgbDecodeTable
+
+		const SrgbDecodeTable& GetSrgbDecodeTable()
+		{
+			static const SrgbDecodeTable s_table;
+			return s_table;
+		}
+		f32 LinearToSrgb(f32 v)
+		{
+			v = std::min(std::max(v, 0.0f), 1.0f);
+			return (v <= 0.0031308f) ? v * 12.92f : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+		}
+
+		//-----------------------------------------------------------
+		// normalized integer conversion.
+		//-----------------------------------------------------------
+		u32 FloatToUnorm(f32 v, u32 bits)
+		{
+			f32 max = static_cast<f32>((1ull << bits) - 1);
+			v = std::min(std::max(v, 0.0f), 1.0f);
+			return static_cast<u32>(v * max + 0.5f);
+		}
+		s32 FloatToSnorm(f32 v, u32 bits)
+		{
+			f32 max = static_cast<f32>((1ull << (bits - 1)) - 1);
+			v = std::min(std::max(v, -1.0f), 1.0f);
+			return static_cast<s32>(std::floor(v * max + 0.5f));
+		}
+		u32 FloatToUint(f32 v, u32 bits)
+		{
+			f64 max = static_cast<f64>((1ull << bits) - 1);
+			return static_cast<u32>(std::min(std::max(static_cast<f64>(v), 0.0), max) + 0.5);
+		}
+		s32 FloatToSint(f32 v, u32 bits)
+		{
+			f64 max = static_cast<f64>((1ull << (bits - 1)) - 1);
+			return static_cast<s32>(std::floor(std::min(std::max(static_cast<f64>(v), -max - 1.0), max) + 0.5));
+		}
+
+		u32 ReadChannel(const u8* p, u32 bytes)
+		{
+			switch (bytes)
+			{
+			case 1: return *p;
+			case 2: { u16 v; memcpy(&v, p, 2); return v; }
+			default: { u32 v; memcpy(&v, p, 4); return v; }
+			}
+		}
+		void WriteChannel(u8* p, u32 bytes, u32 v)
+		{
+			switch (bytes)
+			{
+			case 1: *p = static_cast<u8>(v); break;
+			case 2: { u16 t = static_cast<u16>(v); memcpy(p, &t, 2); } break;
+			default: memcpy(p, &v, 4); break;
+			}
+		}
+		s32 SignExtend(u32 v, u32 bits)
+		{
+			u32 shift = 32 - bits;
+			return static_cast<s32>(v << shift) >> shift;
+		}
+	}
+
+	//-----------------------------------------------------------
+	// check format is readable and writable as texels.
+	//-----------------------------------------------------------
+	bool IsTexelConvertible(ResourceFormat::Type format)
+	{
+		return GetTexelLayout(format).kind != kCompressed;
+	}
+
+	//-----------------------------------------------------------
+	// check format stores integer values.
+	//-----------------------------------------------------------
+	bool IsIntegerFormat(ResourceFormat::Type format)
+	{
+		auto kind = GetTexelLayout(format).kind;
+		return kind == kUint || kind == kSint || format == ResourceFormat::R10G10B10A2_Uint;
+	}
+
+	//-----------------------------------------------------------
+	// decode texels to RGBA.
+	//-----------------------------------------------------------
+	void DecodeTexels(ResourceFormat::Type format, const void* pSrc, u32 count, f32* outColors)
+	{
+		auto&& layout = GetTexelLayout(format);
+		assert(layout.kind != kCompressed);
+		auto p = static_cast<const u8*>(pSrc);
+		u32 texel_bytes = GetFormatInfo(format).bytesPerBlock;
+		u32 bits = layout.bytesPerChannel * 8;
+
+		if (layout.kind == kPacked)
+		{
+			for (u32 i = 0; i < count; i++, p += texel_bytes)
+			{
+				u32 v;
+				memcpy(&v, p, 4);
+				f32* out = outColors + i * 4;
+				out[0] = out[1] = out[2] = 0.0f;
+				out[3] = 1.0f;
+				switch (format)
+				{
+				case ResourceFormat::R10G10B10A2_Unorm:
+					out[0] = (v & 0x3ff) * (1.0f / 1023.0f);
+					out[1] = ((v >> 10) & 0x3ff) * (1.0f / 1023.0f);
+					out[2] = ((v >> 20) & 0x3ff) * (1.0f / 1023.0f);
+					out[3] = (v >> 30) * (1.0f / 3.0f);
+					break;
+				case ResourceFormat::R10G10B10A2_Uint:
+					out[0] = static_cast<f32>(v & 0x3ff);
+					out[1] = static_cast<f32>((v >> 10) & 0x3ff);
+					out[2] = static_cast<f32>((v >> 20) & 0x3ff);
+					out[3] = static_cast<f32>(v >> 30);
+					break;
+				case ResourceFormat::R11G11B10_Float:
+					// small floats have same exponent bias as half.
+					out[0] = HalfToFloat(static_cast<u16>((v & 0x7ff) << 4));
+					out[1] = HalfToFloat(static_cast<u16>(((v >> 11) & 0x7ff) << 4));
+					out[2] = HalfToFloat(static_cast<u16>(((v >> 22) & 0x3ff) << 5));
+					break;
+				case ResourceFormat::D24_Unorm_S8_Uint:
+					out[0] = (v & 0xffffff) * (1.0f / 16777215.0f);
+					out[1] = static_cast<f32>(v >> 24);
+					break;
+				default:
+					assert(false);
+					break;
+				}
+			}
+			return;
+		}
+
+		// channel kind is fixed for whole row, dispatch once.
+		auto&& srgb_table = GetSrgbDecodeTable();
+		f32 unorm_scale = 1.0f / static_cast<f32>((1ull << bits) - 1);
+		f32 snorm_scale = 1.0f / static_cast<f32>((1ull << (bits - 1)) - 1);
+		for (u32 i = 0; i < count; i++, p += texel_bytes)
+		{
+			f32* out = outColors + i * 4;
+			out[0] = out[1] = out[2] = 0.0f;
+			out[3] = 1.0f;
+			for (u32 c = 0; c < layout.channels; c++)
+			{
+				u32 v = ReadChannel(p + c * layout.bytesPerChannel, layout.bytesPerChannel);
+				switch (layout.kind)
+				{
+				case kFloat:
+					if (layout.bytesPerChannel == 2)
+					{
+						out[c] = HalfToFloat(static_cast<u16>(v));
+					}
+					else
+					{
+						memcpy(&out[c], &v, 4);
+					}
+					break;
+				case kUnorm:
+					out[c] = static_cast<f32>(v) * unorm_scale;
+					break;
+				case kSrgb:
+					out[c] = (c < 3) ? srgb_table.values[v & 0xff] : static_cast<f32>(v) * unorm_scale;
+					break;
+				case kSnorm:
+					out[c] = std::max(static_cast<f32>(SignExtend(v, bits)) * snorm_scale, -1.0f);
+					break;
+				case kUint:
+					out[c] = static_cast<f32>(v);
+					break;
+				case kSint:
+					out[c] = static_cast<f32>(SignExtend(v, bits));
+					break;
+				}
+			}
+			if (layout.isBgr)
+			{
+				std::swap(out[0], out[2]);
+			}
+		}
+
+		if (format == ResourceFormat::B8G8R8X8_Unorm || format == ResourceFormat::B8G8R8X8_Unorm_Srgb)
+		{
+			for (u32 i = 0; i < count; i++)
+			{
+				outColors[i * 4 + 3] = 1.0f;
+			}
+		}
+	}
+
+	//-----------------------------------------------------------
+	// encode RGBA to texels.
+	//-----------------------------------------------------------
+	void EncodeTexels(ResourceFormat::Type format, const f32* colors, u32 count, void* pDst)
+	{
+		auto&& layout = GetTexelLayout(format);
+		assert(layout.kind != kCompressed);
+		auto p = static_cast<u8*>(pDst);
+		u32 texel_bytes = GetFormatInfo(format).bytesPerBlock;
+		u32 bits = layout.bytesPerChannel * 8;
+
+		if (layout.kind == kPacked)
+		{
+			for (u32 i = 0; i < count; i++, p += texel_bytes)
+			{
+				const f32* color = colors + i * 4;
+				u32 v = 0;
+				switch (format)
+				{
+				case ResourceFormat::R10G10B10A2_Unorm:
+					v = FloatToUnorm(color[0], 10) | (FloatToUnorm(color[1], 10) << 10) | (FloatToUnorm(color[2], 10) << 20) | (FloatToUnorm(color[3], 2) << 30);
+					break;
+				case ResourceFormat::R10G10B10A2_Uint:
+					v = FloatToUint(color[0], 10) | (FloatToUint(color[1], 10) << 10) | (FloatToUint(color[2], 10) << 20) | (FloatToUint(color[3], 2) << 30);
+					break;
+				case ResourceFormat::R11G11B10_Float:
+				{
+					// unsigned small floats, negative values are clamped to 0.
+					u32 r = FloatToHalf(std::max(color[0], 0.0f)) >> 4;
+					u32 g = FloatToHalf(std::max(color[1], 0.0f)) >> 4;
+					u32 b = FloatToHalf(std::max(color[2], 0.0f)) >> 5;
+					v = (r & 0x7ff) | ((g & 0x7ff) << 11) | ((b & 0x3ff) << 22);
+				}
+				break;
+				case ResourceFormat::D24_Unorm_S8_Uint:
+					v = FloatToUnorm(color[0], 24) | (FloatToUint(color[1], 8) << 24);
+					break;
+				default:
+					assert(false);
+					break;
+				}
+				memcpy(p, &v, 4);
+			}
+			return;
+		}
+
+		bool is_x8 = (format == ResourceFormat::B8G8R8X8_Unorm || format == ResourceFormat::B8G8R8X8_Unorm_Srgb);
+		f32 unorm_max = static_cast<f32>((1ull << bits) - 1);
+		for (u32 i = 0; i < count; i++, p += texel_bytes)
+		{
+			const f32* color = colors + i * 4;
+			f32 rgba[4] = { color[0], color[1], color[2], is_x8 ? 1.0f : color[3] };
+			if (layout.isBgr)
+			{
+				std::swap(rgba[0], rgba[2]);
+			}
+
+			for (u32 c = 0; c < layout.channels; c++)
+			{
+				f32 f = rgba[c];
+				u32 v = 0;
+				switch (layout.kind)
+				{
+				case kFloat:
+					if (layout.bytesPerChannel == 2)
+					{
+						v = FloatToHalf(f);
+					}
+					else
+					{
+						memcpy(&v, &f, 4);
+					}
+					break;
+				case kUnorm:
+					v = static_cast<u32>(std::min(std::max(f, 0.0f), 1.0f) * unorm_max + 0.5f);
+					break;
+				case kSrgb:
+					v = static_cast<u32>(((c < 3) ? LinearToSrgb(f) : std::min(std::max(f, 0.0f), 1.0f)) * unorm_max + 0.5f);
+					break;
+				case kSnorm:
+					v = static_cast<u32>(FloatToSnorm(f, bits));
+					break;
+				case kUint:
+					v = FloatToUint(f, bits);
+					break;
+				case kSint:
+					v = static_cast<u32>(FloatToSint(f, bits));
+					break;
+				}
+				WriteChannel(p + c * layout.bytesPerChannel, layout.bytesPerChannel, v);
+			}
+		}
+	}
+
+}
+//	EOF
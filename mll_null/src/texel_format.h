@@ -0,0 +1,36 @@
+﻿#pragma once
+
+#include "native.h"
+
+
+namespace mll
+{
+	/**
+	 * @brief check format is readable and writable as texels.
+	 *
+	 * @note Block compressed formats can only be copied as is.
+	*/
+	bool IsTexelConvertible(ResourceFormat::Type format);
+
+	/**
+	 * @brief check format stores integer values.
+	*/
+	bool IsIntegerFormat(ResourceFormat::Type format);
+
+	/**
+	 * @brief decode texels to RGBA.
+	 *
+	 * @param[out]	outColors	count * 4 floats.
+	 * @note Missing channels are (0, 0, 0, 1). Depth is in R, stencil is in G.
+	*/
+	void DecodeTexels(ResourceFormat::Type format, const void* pSrc, u32 count, f32* outColors);
+
+	/**
+	 * @brief encode RGBA to texels.
+	 *
+	 * @param[in]	colors		count * 4 floats.
+	*/
+	void EncodeTexels(ResourceFormat::Type format, const f32* colors, u32 count, void* pDst);
+
+}
+//	EOF
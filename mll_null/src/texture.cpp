@@ -0,0 +1,146 @@
+﻿#include "texture.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "device.h"
+
+
+namespace mll
+{
+	MLL_IMPLEMENT_POOL_ALLOCATOR(Texture, AllocCategory::Texture);
+
+	void Texture::Release()
+	{
+		KillSelf();
+	}
+
+	//-----------------------------------------------------------
+	// initialize texture memory.
+	//-----------------------------------------------------------
+	Result::Type Texture::Initialize(Device* pDevice, const TextureDesc& desc)
+	{
+		auto result = InitializeLayout(desc);
+		if (IsFailed(result))
+		{
+			return result;
+		}
+
+		pMemory_ = static_cast<u8*>(MemoryAllocate(static_cast<size_t>(memorySize_), kDefaultAllocAlignment, AllocCategory::Texture));
+		if (pMemory_ == nullptr)
+		{
+			return Result::OutOfMemory;
+		}
+		memset(pMemory_, 0, static_cast<size_t>(memorySize_));
+
+		SetMemoryFootprint(desc.heap, memorySize_);
+
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// initialize texture on external memory.
+	//-----------------------------------------------------------
+	Result::Type Texture::InitializeExternal(Device* pDevice, const TextureDesc& desc, u8* pMemory, u64 memorySize)
+	{
+		auto result = InitializeLayout(desc);
+		if (IsFailed(result))
+		{
+			return result;
+		}
+		if (pMemory == nullptr || memorySize_ > memorySize)
+		{
+			return Result::InvalidArgs;
+		}
+
+		pMemory_ = pMemory;
+		isExternalMemory_ = true;
+
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// calculate subresource layout.
+	//-----------------------------------------------------------
+	Result::Type Texture::InitializeLayout(const TextureDesc& desc)
+	{
+		desc_ = desc;
+
+		if (desc.usageFlags & (ResourceUsageFlag::ConstantBuffer | ResourceUsageFlag::IndexBuffer | ResourceUsageFlag::VertexBuffer | ResourceUsageFlag::IndirectArg))
+		{
+			return Result::InvalidArgs;
+		}
+		if (desc.dimension == ResourceDimension::Buffer || desc.format == ResourceFormat::Unknown || desc.width == 0)
+		{
+			return Result::InvalidArgs;
+		}
+
+		auto&& info = GetFormatInfo(desc.format);
+		u32 height = (desc.dimension == ResourceDimension::Texture1D || desc.height == 0) ? 1 : desc.height;
+		u32 depth = (desc.dimension == ResourceDimension::Texture3D && desc.depth > 0) ? desc.depth : 1;
+		u32 array_size = (desc.dimension != ResourceDimension::Texture3D && desc.arraySize > 0) ? desc.arraySize : 1;
+		u32 mip_levels = (desc.mipLevels > 0) ? desc.mipLevels : 1;
+		u32 sample_count = (desc.sampleCount > 0) ? desc.sampleCount : 1;
+
+		// tightly packed layout, each subresource is aligned to 16 bytes.
+		subresources_.resize(array_size * mip_levels);
+		u64 offset = 0;
+		for (u32 slice = 0; slice < array_size; slice++)
+		{
+			for (u32 mip = 0; mip < mip_levels; mip++)
+			{
+				auto&& sub = subresources_[mip + slice * mip_levels];
+				sub.width = (desc.width >> mip) > 0 ? (desc.width >> mip) : 1;
+				sub.height = (height >> mip) > 0 ? (height >> mip) : 1;
+				sub.depth = (depth >> mip) > 0 ? (depth >> mip) : 1;
+				sub.rowPitch = ((sub.width + info.blockWidth - 1) / info.blockWidth) * info.bytesPerBlock * sample_count;
+				sub.rowCount = (sub.height + info.blockHeight - 1) / info.blockHeight;
+				sub.slicePitch = static_cast<u64>(sub.rowPitch) * sub.rowCount;
+				sub.offset = offset;
+				offset += (sub.slicePitch * sub.depth + 15) & ~15ull;
+			}
+		}
+		memorySize_ = offset;
+
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// destroy texture memory.
+	//-----------------------------------------------------------
+	void Texture::Destroy()
+	{
+		if (pMemory_ != nullptr && !isExternalMemory_)
+		{
+			MemoryFree(pMemory_, static_cast<size_t>(memorySize_), AllocCategory::Texture);
+		}
+		pMemory_ = nullptr;
+		isExternalMemory_ = false;
+		subresources_.clear();
+	}
+
+
+#define Self()	static_cast<Texture*>(this)
+
+	//-----------------------------------------------------------
+	// get bindless index of shader resource view.
+	//-----------------------------------------------------------
+	u32 ITexture::GetBindlessSrvIndex() const
+	{
+		// command stream is executed directly, no descriptor heap.
+		return kInvalidBindlessIndex;
+	}
+
+	//-----------------------------------------------------------
+	// get bindless index of unordered access view.
+	//-----------------------------------------------------------
+	u32 ITexture::GetBindlessUavIndex() const
+	{
+		// command stream is executed directly, no descriptor heap.
+		return kInvalidBindlessIndex;
+	}
+
+#undef Self
+
+}
+//	EOF
@@ -0,0 +1,88 @@
+﻿#pragma once
+
+#include "native.h"
+
+#include <vector>
+
+
+namespace mll
+{
+	class Device;
+
+	//-----------------------------------------------------------
+	//! @brief texture subresource layout in CPU memory.
+	//-----------------------------------------------------------
+	struct SubresourceLayout
+	{
+		u64		offset = 0;
+		u32		width = 0;
+		u32		height = 0;
+		u32		depth = 0;
+		u32		rowPitch = 0;		//!< bytes per block row.
+		u32		rowCount = 0;		//!< block rows per depth slice.
+		u64		slicePitch = 0;		//!< bytes per depth slice.
+	};	// struct SubresourceLayout
+
+	//-----------------------------------------------------------
+	//! @brief texture resource.
+	//!
+	//! Null texture is tightly packed CPU memory.
+	//! External memory such as frame ring slot is not freed by texture.
+	//! Subresource index is (mip + arraySlice * mipLevels) as D3D12.
+	//-----------------------------------------------------------
+	class Texture
+		: public ITexture
+	{
+		MLL_DECLARE_POOL_ALLOCATOR();
+
+		friend class IDevice;
+		friend class Device;
+
+	public:
+		// getter
+		u8* GetMemory()
+		{
+			return pMemory_;
+		}
+		u64 GetMemorySize() const
+		{
+			return memorySize_;
+		}
+		u32 GetSubresourceCount() const
+		{
+			return static_cast<u32>(subresources_.size());
+		}
+		const SubresourceLayout& GetSubresourceLayout(u32 index) const
+		{
+			return subresources_[index];
+		}
+
+	private:
+		Texture()
+			: ITexture()
+		{}
+		~Texture()
+		{
+			Destroy();
+		}
+
+		Result::Type Initialize(Device* pDevice, const TextureDesc& desc);
+		Result::Type InitializeExternal(Device* pDevice, const TextureDesc& desc, u8* pMemory, u64 memorySize);
+		void Destroy();
+
+		Result::Type InitializeLayout(const TextureDesc& desc);
+
+		/**
+		 * @brief Release self.
+		*/
+		void Release() override;
+
+	private:
+		u8*									pMemory_ = nullptr;
+		u64									memorySize_ = 0;
+		bool								isExternalMemory_ = false;
+		std::vector<SubresourceLayout>		subresources_;
+	};	// class Texture
+
+}
+//	EOF
@@ -0,0 +1,108 @@
+﻿#include "command_allocator_pool.h"
+
+#include <cassert>
+#include <algorithm>
+
+#include "device.h"
+
+
+namespace mll
+{
+	//-----------------------------------------------------------
+	// initialize pool.
+	//-----------------------------------------------------------
+	Result::Type CommandAllocatorPool::Initialize(Device* pDevice, CommandQueueType::Type type)
+	{
+		pDevice_ = pDevice;
+		device_ = pDevice->GetNativeDevice();
+		type_ = type;
+		queueFamily_ = pDevice->GetCommandQueue()->GetQueueFamilyIndex(type);
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// destroy pool.
+	//-----------------------------------------------------------
+	void CommandAllocatorPool::Destroy()
+	{
+		// all command lists are destroyed and queues are idle here.
+		assert(stats_.heldCount == 0);
+		for (auto&& entry : pending_)
+		{
+			// command buffer is freed with pool.
+			vkDestroyCommandPool(device_, entry.allocator.pool, nullptr);
+		}
+		pending_.clear();
+		stats_ = CommandAllocatorStats();
+	}
+
+	//-----------------------------------------------------------
+	// acquire reset allocator.
+	//-----------------------------------------------------------
+	bool CommandAllocatorPool::Acquire(CommandAllocator& outAllocator)
+	{
+		auto completed = pDevice_->GetCommandQueue()->GetCompletedFenceValue(type_);
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		stats_.acquireCount++;
+
+		// allocators are returned nearly in submission order, so front is the oldest.
+		for (size_t i = 0; i < pending_.size(); i++)
+		{
+			if (pending_[i].fenceValue <= completed)
+			{
+				outAllocator = pending_[i].allocator;
+				pending_.erase(pending_.begin() + i);
+
+				auto result = vkResetCommandPool(device_, outAllocator.pool, 0);
+				assert(result == VK_SUCCESS);
+				(void)result;
+				stats_.heldCount++;
+				stats_.recycleCount++;
+				return true;
+			}
+		}
+
+		// no completed allocator, add new one.
+		CommandAllocator allocator;
+		VkCommandPoolCreateInfo pool_info{};
+		pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		pool_info.queueFamilyIndex = queueFamily_;
+		if (vkCreateCommandPool(device_, &pool_info, nullptr, &allocator.pool) != VK_SUCCESS)
+		{
+			return false;
+		}
+
+		VkCommandBufferAllocateInfo alloc_info{};
+		alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		alloc_info.commandPool = allocator.pool;
+		alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		alloc_info.commandBufferCount = 1;
+		if (vkAllocateCommandBuffers(device_, &alloc_info, &allocator.buffer) != VK_SUCCESS)
+		{
+			vkDestroyCommandPool(device_, allocator.pool, nullptr);
+			return false;
+		}
+
+		stats_.allocatorCount++;
+		stats_.heldCount++;
+		outAllocator = allocator;
+		return true;
+	}
+
+	//-----------------------------------------------------------
+	// return allocator to pool.
+	//-----------------------------------------------------------
+	void CommandAllocatorPool::Release(const CommandAllocator& allocator, u64 fenceValue, u64 recordBytes)
+	{
+		assert(allocator.pool != VK_NULL_HANDLE);
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		pending_.push_back(Entry{ allocator, fenceValue });
+		stats_.heldCount--;
+		stats_.peakRecordBytes = std::max(stats_.peakRecordBytes, recordBytes);
+	}
+
+}
+//	EOF
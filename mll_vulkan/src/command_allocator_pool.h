@@ -0,0 +1,85 @@
+﻿#pragma once
+
+#include "native.h"
+
+#include <vector>
+#include <mutex>
+
+
+namespace mll
+{
+	class Device;
+
+	//-----------------------------------------------------------
+	//! @brief command pool and its primary command buffer.
+	//-----------------------------------------------------------
+	struct CommandAllocator
+	{
+		VkCommandPool		pool = VK_NULL_HANDLE;
+		VkCommandBuffer		buffer = VK_NULL_HANDLE;
+	};	// struct CommandAllocator
+
+	//-----------------------------------------------------------
+	//! @brief command allocator pool of a command queue type.
+	//!
+	//! Allocators are returned with fence value of their last submission,
+	//! and handed out again after the fence is completed.
+	//! If no allocator is completed, new one is created instead of waiting.
+	//-----------------------------------------------------------
+	class CommandAllocatorPool
+	{
+		MLL_DECLARE_CLASS_ALLOCATOR(AllocCategory::CommandList);
+
+	public:
+		CommandAllocatorPool()
+		{}
+		~CommandAllocatorPool()
+		{
+			Destroy();
+		}
+
+		Result::Type Initialize(Device* pDevice, CommandQueueType::Type type);
+		void Destroy();
+
+		/**
+		 * @brief acquire reset allocator.
+		 *
+		 * @param[out]	outAllocator	acquired allocator.
+		 * @return		false if creation failed.
+		*/
+		bool Acquire(CommandAllocator& outAllocator);
+
+		/**
+		 * @brief return allocator to pool.
+		 *
+		 * @param[in]	allocator		allocator acquired from this pool.
+		 * @param[in]	fenceValue		fence value of last submission. 0 if not submitted.
+		 * @param[in]	recordBytes		command stream bytes recorded into allocator.
+		*/
+		void Release(const CommandAllocator& allocator, u64 fenceValue, u64 recordBytes);
+
+		// getter
+		CommandAllocatorStats GetStats()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return stats_;
+		}
+
+	private:
+		struct Entry
+		{
+			CommandAllocator	allocator;
+			u64					fenceValue;
+		};	// struct Entry
+
+		Device*					pDevice_ = nullptr;
+		VkDevice				device_ = VK_NULL_HANDLE;
+		CommandQueueType::Type	type_ = CommandQueueType::Graphics;
+		u32						queueFamily_ = 0;
+		std::mutex				mutex_;
+		std::vector<Entry>		pending_;			// returned allocators in release order.
+		CommandAllocatorStats	stats_;
+	};	// class CommandAllocatorPool
+
+}
+//	EOF
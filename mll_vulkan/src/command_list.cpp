@@ -0,0 +1,452 @@
+﻿#include "command_list.h"
+
+#include <cassert>
+
+#include "device.h"
+#include "texture.h"
+
+
+namespace mll
+{
+	MLL_IMPLEMENT_POOL_ALLOCATOR(CommandList, AllocCategory::CommandList);
+
+	namespace
+	{
+		static const size_t	kMaxTransferStates = 64;
+
+		//-----------------------------------------------------------
+		// drop access bits not supported by pipeline stages.
+		//-----------------------------------------------------------
+		VkAccessFlags FilterAccess(VkAccessFlags access, VkPipelineStageFlags stages)
+		{
+			VkAccessFlags allowed = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+			if (stages & (VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT))
+			{
+				allowed |= VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			}
+			if (stages & VK_PIPELINE_STAGE_TRANSFER_BIT)
+			{
+				allowed |= VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+			}
+			if (stages & VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT)
+			{
+				allowed |= VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+			}
+			if (stages & VK_PIPELINE_STAGE_VERTEX_INPUT_BIT)
+			{
+				allowed |= VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+			}
+			if (stages & VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT)
+			{
+				allowed |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			}
+			if (stages & (VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT))
+			{
+				allowed |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			}
+			return access & allowed;
+		}
+
+		//-----------------------------------------------------------
+		// make clear color for format class.
+		//-----------------------------------------------------------
+		VkClearColorValue GetNativeClearColor(ResourceFormat::Type format, const f32* color)
+		{
+			VkClearColorValue ret;
+			switch (format)
+			{
+			case ResourceFormat::R32G32B32A32_Uint:
+			case ResourceFormat::R32G32B32_Uint:
+			case ResourceFormat::R32G32_Uint:
+			case ResourceFormat::R32_Uint:
+			case ResourceFormat::R16G16B16A16_Uint:
+			case ResourceFormat::R16G16_Uint:
+			case ResourceFormat::R16_Uint:
+			case ResourceFormat::R8G8B8A8_Uint:
+			case ResourceFormat::R8G8_Uint:
+			case ResourceFormat::R8_Uint:
+			case ResourceFormat::R10G10B10A2_Uint:
+				for (u32 i = 0; i < 4; i++)
+				{
+					ret.uint32[i] = static_cast<u32>(color[i]);
+				}
+				break;
+			case ResourceFormat::R32G32B32A32_Sint:
+			case ResourceFormat::R32G32B32_Sint:
+			case ResourceFormat::R32G32_Sint:
+			case ResourceFormat::R32_Sint:
+			case ResourceFormat::R16G16B16A16_Sint:
+			case ResourceFormat::R16G16_Sint:
+			case ResourceFormat::R16_Sint:
+			case ResourceFormat::R8G8B8A8_Sint:
+			case ResourceFormat::R8G8_Sint:
+			case ResourceFormat::R8_Sint:
+				for (u32 i = 0; i < 4; i++)
+				{
+					ret.int32[i] = static_cast<s32>(color[i]);
+				}
+				break;
+			default:
+				for (u32 i = 0; i < 4; i++)
+				{
+					ret.float32[i] = color[i];
+				}
+				break;
+			}
+			return ret;
+		}
+	}
+
+	void CommandList::Release()
+	{
+		KillSelf();
+	}
+
+	void CommandList::OnObjectNameChanged()
+	{
+		// allocators are recycled between command lists, name is set again when acquired.
+		auto device = static_cast<Device*>(pParentDevice_);
+		if (device->IsNativeObjectNameEnabled() && allocator_.buffer != VK_NULL_HANDLE)
+		{
+			device->SetNativeObjectName(VK_OBJECT_TYPE_COMMAND_BUFFER, reinterpret_cast<u64>(allocator_.buffer), GetObjectName());
+		}
+	}
+
+	//-----------------------------------------------------------
+	// initialize command list, native command buffer is acquired from pool in End.
+	//-----------------------------------------------------------
+	Result::Type CommandList::Initialize(Device* pDevice, const CommandListDesc& desc)
+	{
+		desc_ = desc;
+		queueStages_ = GetNativeQueueStages(desc.typeCommandQueue);
+
+		if (IsBundle())
+		{
+			// secondary command buffer is kept over executions, so bundle has its own pool.
+			device_ = pDevice->GetNativeDevice();
+
+			VkCommandPoolCreateInfo pool_info{};
+			pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			pool_info.queueFamilyIndex = pDevice->GetCommandQueue()->GetQueueFamilyIndex(desc.typeCommandQueue);
+			if (vkCreateCommandPool(device_, &pool_info, nullptr, &allocator_.pool) != VK_SUCCESS)
+			{
+				return Result::InvalidOperation;
+			}
+
+			VkCommandBufferAllocateInfo alloc_info{};
+			alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			alloc_info.commandPool = allocator_.pool;
+			alloc_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			alloc_info.commandBufferCount = 1;
+			if (vkAllocateCommandBuffers(device_, &alloc_info, &allocator_.buffer) != VK_SUCCESS)
+			{
+				return Result::InvalidOperation;
+			}
+			return Result::Ok;
+		}
+
+		pAllocatorPool_ = pDevice->GetCommandAllocatorPool(desc.typeCommandQueue);
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// destroy command list.
+	//-----------------------------------------------------------
+	void CommandList::Destroy()
+	{
+		if (IsBundle())
+		{
+			// command buffer is freed with pool.
+			if (allocator_.pool != VK_NULL_HANDLE)
+			{
+				vkDestroyCommandPool(device_, allocator_.pool, nullptr);
+				allocator_ = CommandAllocator();
+			}
+			return;
+		}
+		ReleaseAllocator();
+	}
+
+	//-----------------------------------------------------------
+	// return allocator to pool with fence value of last submission.
+	//-----------------------------------------------------------
+	void CommandList::ReleaseAllocator()
+	{
+		if (allocator_.pool != VK_NULL_HANDLE)
+		{
+			pAllocatorPool_->Release(allocator_, submittedFenceValue_, recordBytes_);
+			allocator_ = CommandAllocator();
+		}
+		submittedFenceValue_ = 0;
+		recordBytes_ = 0;
+	}
+
+	//-----------------------------------------------------------
+	// issue layout transition of texture subresource.
+	//-----------------------------------------------------------
+	void CommandList::IssueBarrier(Texture* pTexture, u32 subresource, const NativeResourceState& from, const NativeResourceState& to)
+	{
+		// stages not supported on this queue are replaced with all commands.
+		VkPipelineStageFlags src_stage = from.stage & queueStages_;
+		VkPipelineStageFlags dst_stage = to.stage & queueStages_;
+		src_stage = (src_stage != 0) ? src_stage : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		dst_stage = (dst_stage != 0) ? dst_stage : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = FilterAccess(from.access, from.stage & queueStages_);
+		barrier.dstAccessMask = FilterAccess(to.access, to.stage & queueStages_);
+		barrier.oldLayout = from.layout;
+		barrier.newLayout = to.layout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = pTexture->GetNativeImage();
+		barrier.subresourceRange = pTexture->GetSubresourceRange(subresource);
+		vkCmdPipelineBarrier(allocator_.buffer, src_stage, dst_stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	//-----------------------------------------------------------
+	// transition texture subresource to transfer state if it is not yet.
+	//
+	// naive translation issues 2 barriers per command and subresource (to transfer and restore),
+	// counters are compared with it.
+	//-----------------------------------------------------------
+	void CommandList::RequireTransferState(Texture* pTexture, u32 subresource, ResourceState::Type state)
+	{
+		for (auto&& entry : transferStates_)
+		{
+			if (entry.pTexture != pTexture || entry.subresource != subresource)
+			{
+				continue;
+			}
+
+			if (entry.state == state && state == ResourceState::CopySrc)
+			{
+				// read after read needs no dependency.
+				CountState(CommandStateType::Barrier, 0, 2);
+			}
+			else
+			{
+				// write hazard or other transfer state, one barrier replaces restore and transition.
+				IssueBarrier(pTexture, subresource, GetNativeResourceState(entry.state), GetNativeResourceState(state));
+				CountState(CommandStateType::Barrier, 1, 1);
+				entry.state = state;
+			}
+			return;
+		}
+
+		// keep linear search short.
+		if (transferStates_.size() >= kMaxTransferStates)
+		{
+			RestoreRestingStates();
+		}
+
+		IssueBarrier(pTexture, subresource, pTexture->GetRestingState(), GetNativeResourceState(state));
+		CountState(CommandStateType::Barrier, 1, 0);
+		transferStates_.push_back(TransferState{ pTexture, subresource, state });
+	}
+
+	//-----------------------------------------------------------
+	// transition all subresources in transfer state back to resting layout.
+	//-----------------------------------------------------------
+	void CommandList::RestoreRestingStates()
+	{
+		for (auto&& entry : transferStates_)
+		{
+			IssueBarrier(entry.pTexture, entry.subresource, GetNativeResourceState(entry.state), entry.pTexture->GetRestingState());
+			CountState(CommandStateType::Barrier, 1, 0);
+		}
+		transferStates_.clear();
+	}
+
+	//-----------------------------------------------------------
+	// translate clear texture packet.
+	//-----------------------------------------------------------
+	void CommandList::TranslateClearTexture(const ClearTexturePacket& packet)
+	{
+		auto p_tex = static_cast<Texture*>(packet.pTexture);
+		auto subresource = packet.subresource;
+		auto range = p_tex->GetSubresourceRange(subresource);
+
+		RequireTransferState(p_tex, subresource, ResourceState::CopyDst);
+		if (p_tex->GetNativeAspect() & VK_IMAGE_ASPECT_DEPTH_BIT)
+		{
+			// depth clear is graphics queue only as D3D12.
+			assert(desc_.typeCommandQueue == CommandQueueType::Graphics);
+
+			VkClearDepthStencilValue value;
+			value.depth = packet.color[0];
+			value.stencil = static_cast<u32>(packet.color[1]);
+			vkCmdClearDepthStencilImage(allocator_.buffer, p_tex->GetNativeImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &value, 1, &range);
+		}
+		else
+		{
+			auto value = GetNativeClearColor(p_tex->GetDesc().format, packet.color);
+			vkCmdClearColorImage(allocator_.buffer, p_tex->GetNativeImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &value, 1, &range);
+		}
+	}
+
+	//-----------------------------------------------------------
+	// translate copy texture packet.
+	//-----------------------------------------------------------
+	void CommandList::TranslateCopyTexture(const CopyTexturePacket& packet)
+	{
+		auto p_dst = static_cast<Texture*>(packet.pDst);
+		auto p_src = static_cast<Texture*>(packet.pSrc);
+
+		VkImageCopy region{};
+		region.srcSubresource = p_src->GetSubresourceLayers(packet.srcSubresource);
+		region.dstSubresource = p_dst->GetSubresourceLayers(packet.dstSubresource);
+		region.extent = p_src->GetMipExtent(region.srcSubresource.mipLevel);
+
+		RequireTransferState(p_src, packet.srcSubresource, ResourceState::CopySrc);
+		RequireTransferState(p_dst, packet.dstSubresource, ResourceState::CopyDst);
+		vkCmdCopyImage(allocator_.buffer,
+			p_src->GetNativeImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			p_dst->GetNativeImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1, &region);
+	}
+
+	//-----------------------------------------------------------
+	// translate resolve texture packet.
+	//-----------------------------------------------------------
+	void CommandList::TranslateResolveTexture(const ResolveTexturePacket& packet)
+	{
+		auto p_dst = static_cast<Texture*>(packet.pDst);
+		auto p_src = static_cast<Texture*>(packet.pSrc);
+		assert(desc_.typeCommandQueue == CommandQueueType::Graphics);
+
+		VkImageResolve region{};
+		region.srcSubresource = p_src->GetSubresourceLayers(packet.srcSubresource);
+		region.dstSubresource = p_dst->GetSubresourceLayers(packet.dstSubresource);
+		region.extent = p_src->GetMipExtent(region.srcSubresource.mipLevel);
+
+		RequireTransferState(p_src, packet.srcSubresource, ResourceState::CopySrc);
+		RequireTransferState(p_dst, packet.dstSubresource, ResourceState::CopyDst);
+		vkCmdResolveImage(allocator_.buffer,
+			p_src->GetNativeImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			p_dst->GetNativeImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1, &region);
+	}
+
+	//-----------------------------------------------------------
+	// translate execute bundle packet.
+	//-----------------------------------------------------------
+	void CommandList::TranslateExecuteBundle(const ExecuteBundlePacket& packet)
+	{
+		// bundle expects resting layouts.
+		RestoreRestingStates();
+
+		auto p_bundle = static_cast<CommandList*>(packet.pBundle);
+		vkCmdExecuteCommands(allocator_.buffer, 1, &p_bundle->allocator_.buffer);
+	}
+
+	//-----------------------------------------------------------
+	// translate recorded command stream to native command buffer.
+	//-----------------------------------------------------------
+	void CommandList::TranslateCommandStream()
+	{
+		stream_.ForEach([&](const CommandPacketHeader& header)
+		{
+			switch (header.type)
+			{
+			case CommandPacketType::ClearTexture:
+				TranslateClearTexture(CommandStream::Cast<ClearTexturePacket>(header));
+				break;
+			case CommandPacketType::CopyTexture:
+				TranslateCopyTexture(CommandStream::Cast<CopyTexturePacket>(header));
+				break;
+			case CommandPacketType::ResolveTexture:
+				TranslateResolveTexture(CommandStream::Cast<ResolveTexturePacket>(header));
+				break;
+			case CommandPacketType::ExecuteBundle:
+				TranslateExecuteBundle(CommandStream::Cast<ExecuteBundlePacket>(header));
+				break;
+			default:
+				assert(false);
+				break;
+			}
+		});
+		RestoreRestingStates();
+	}
+
+	//-----------------------------------------------------------
+	// record command stream to secondary command buffer of bundle.
+	//-----------------------------------------------------------
+	void CommandList::RecordBundle()
+	{
+		// caller must not record bundle again while it is executing.
+		auto result = vkResetCommandPool(device_, allocator_.pool, 0);
+		assert(result == VK_SUCCESS);
+
+		// transfer commands only, no render pass is inherited.
+		VkCommandBufferInheritanceInfo inheritance{};
+		inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+
+		VkCommandBufferBeginInfo info{};
+		info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+		info.pInheritanceInfo = &inheritance;
+		result = vkBeginCommandBuffer(allocator_.buffer, &info);
+		assert(result == VK_SUCCESS);
+
+		TranslateCommandStream();
+		result = vkEndCommandBuffer(allocator_.buffer);
+		assert(result == VK_SUCCESS);
+		(void)result;
+	}
+
+
+#define Self()	static_cast<CommandList*>(this)
+
+	//-----------------------------------------------------------
+	// begin command load.
+	//-----------------------------------------------------------
+	void ICommandList::Begin()
+	{
+		auto p_this = Self();
+		assert(!p_this->isRecording_);
+		p_this->isRecording_ = true;
+		p_this->ResetStream();
+	}
+
+	//-----------------------------------------------------------
+	// end command load.
+	//-----------------------------------------------------------
+	void ICommandList::End()
+	{
+		auto p_this = Self();
+		assert(p_this->isRecording_);
+		p_this->isRecording_ = false;
+		p_this->stateStats_ = CommandStateStats();
+
+		if (IsBundle())
+		{
+			p_this->RecordBundle();
+			return;
+		}
+
+		// previous allocator may still be executing, exchange it for completed one.
+		p_this->ReleaseAllocator();
+		auto acquired = p_this->pAllocatorPool_->Acquire(p_this->allocator_);
+		assert(acquired);
+		(void)acquired;
+		p_this->recordBytes_ = stream_.GetUsedBytes();
+		p_this->OnObjectNameChanged();
+
+		VkCommandBufferBeginInfo info{};
+		info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		// ended command list may be submitted again while pending, like other backends.
+		info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+		auto result = vkBeginCommandBuffer(p_this->GetNativeCmdBuffer(), &info);
+		assert(result == VK_SUCCESS);
+
+		p_this->TranslateCommandStream();
+		result = vkEndCommandBuffer(p_this->GetNativeCmdBuffer());
+		assert(result == VK_SUCCESS);
+		(void)result;
+	}
+
+#undef Self
+}
+//	EOF
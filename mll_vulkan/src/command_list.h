@@ -0,0 +1,124 @@
+﻿#pragma once
+
+#include "native.h"
+#include "command_allocator_pool.h"
+
+
+namespace mll
+{
+	class Device;
+	class Texture;
+
+	//-----------------------------------------------------------
+	//! @brief command list.
+	//!
+	//! Textures rest in layout of their initial state between command lists.
+	//! Commands transition subresources they touch to transfer layout, and the layouts are
+	//! restored at the end of translation, so consecutive commands on a subresource skip round trips.
+	//! Bundle owns secondary command buffer which is executed by vkCmdExecuteCommands.
+	//-----------------------------------------------------------
+	class CommandList
+		: public ICommandList
+	{
+		MLL_DECLARE_POOL_ALLOCATOR();
+
+		friend class IDevice;
+		friend class ICommandList;
+
+	public:
+		/**
+		 * @brief set fence value of submission.
+		 *
+		 * @note Allocator is returned to pool with this value at next End.
+		*/
+		void SetSubmittedFenceValue(u64 v)
+		{
+			submittedFenceValue_ = v;
+		}
+
+		// getter
+		VkCommandPool GetNativeCmdPool()
+		{
+			return allocator_.pool;
+		}
+		VkCommandBuffer GetNativeCmdBuffer()
+		{
+			return allocator_.buffer;
+		}
+
+	private:
+		CommandList()
+			: ICommandList()
+		{}
+		~CommandList()
+		{
+			Destroy();
+		}
+
+		Result::Type Initialize(Device* pDevice, const CommandListDesc& desc);
+		void Destroy();
+
+		/**
+		 * @brief return allocator to pool.
+		*/
+		void ReleaseAllocator();
+
+		/**
+		 * @brief Release self.
+		*/
+		void Release() override;
+
+		/**
+		 * @brief Propagate object name to native object.
+		*/
+		void OnObjectNameChanged() override;
+
+		/**
+		 * @brief issue layout transition of texture subresource.
+		*/
+		void IssueBarrier(Texture* pTexture, u32 subresource, const NativeResourceState& from, const NativeResourceState& to);
+
+		/**
+		 * @brief transition texture subresource to transfer state if it is not yet.
+		*/
+		void RequireTransferState(Texture* pTexture, u32 subresource, ResourceState::Type state);
+
+		/**
+		 * @brief transition all subresources in transfer state back to resting layout.
+		*/
+		void RestoreRestingStates();
+
+		/**
+		 * @brief translate recorded command stream to native command buffer.
+		*/
+		void TranslateCommandStream();
+		void TranslateClearTexture(const ClearTexturePacket& packet);
+		void TranslateCopyTexture(const CopyTexturePacket& packet);
+		void TranslateResolveTexture(const ResolveTexturePacket& packet);
+		void TranslateExecuteBundle(const ExecuteBundlePacket& packet);
+
+		/**
+		 * @brief record command stream to secondary command buffer of bundle.
+		*/
+		void RecordBundle();
+
+	private:
+		VkDevice				device_ = VK_NULL_HANDLE;		// bundle only.
+		CommandAllocatorPool*	pAllocatorPool_ = nullptr;
+		CommandAllocator		allocator_;						// held from End until next End. owned by bundle.
+		u64						submittedFenceValue_ = 0;
+		u64						recordBytes_ = 0;
+		VkPipelineStageFlags	queueStages_ = 0;		// stages supported on queue.
+
+		struct TransferState
+		{
+			Texture*			pTexture;
+			u32					subresource;
+			ResourceState::Type	state;
+		};	// struct TransferState
+
+		std::vector<TransferState>	transferStates_;	// subresources not in resting layout.
+	};	// class CommandList
+
+}
+//	EOF
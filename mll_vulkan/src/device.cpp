@@ -0,0 +1,721 @@
+﻿#include "device.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "command_list.h"
+#include "swapchain.h"
+#include "texture.h"
+
+
+namespace mll
+{
+	namespace
+	{
+		static const u32	kInvalidIndex = ~0u;
+
+		//-----------------------------------------------------------
+		// check instance layer or extension is available.
+		//-----------------------------------------------------------
+		bool HasInstanceLayer(const char* name)
+		{
+			u32 count = 0;
+			vkEnumerateInstanceLayerProperties(&count, nullptr);
+			std::vector<VkLayerProperties> props(count);
+			vkEnumerateInstanceLayerProperties(&count, props.data());
+			return std::any_of(props.begin(), props.end(), [&](const VkLayerProperties& p) { return strcmp(p.layerName, name) == 0; });
+		}
+		bool HasInstanceExtension(const char* name)
+		{
+			u32 count = 0;
+			vkEnumerateInstanceExtensionProperties(nullptr, &count, nullptr);
+			std::vector<VkExtensionProperties> props(count);
+			vkEnumerateInstanceExtensionProperties(nullptr, &count, props.data());
+			return std::any_of(props.begin(), props.end(), [&](const VkExtensionProperties& p) { return strcmp(p.extensionName, name) == 0; });
+		}
+		bool HasDeviceExtension(VkPhysicalDevice device, const char* name)
+		{
+			u32 count = 0;
+			vkEnumerateDeviceExtensionProperties(device, nullptr, &count, nullptr);
+			std::vector<VkExtensionProperties> props(count);
+			vkEnumerateDeviceExtensionProperties(device, nullptr, &count, props.data());
+			return std::any_of(props.begin(), props.end(), [&](const VkExtensionProperties& p) { return strcmp(p.extensionName, name) == 0; });
+		}
+
+		//-----------------------------------------------------------
+		// score physical device, negative if unusable.
+		//-----------------------------------------------------------
+		int ScorePhysicalDevice(VkPhysicalDevice device)
+		{
+			VkPhysicalDeviceProperties props;
+			vkGetPhysicalDeviceProperties(device, &props);
+			if (props.apiVersion < VK_API_VERSION_1_2)
+			{
+				return -1;
+			}
+
+			// frame retirement depends on timeline semaphore.
+			VkPhysicalDeviceVulkan12Features features12{};
+			features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+			VkPhysicalDeviceFeatures2 features{};
+			features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features.pNext = &features12;
+			vkGetPhysicalDeviceFeatures2(device, &features);
+			if (!features12.timelineSemaphore)
+			{
+				return -1;
+			}
+
+			// software implementation such as lavapipe is used only if no GPU exists.
+			switch (props.deviceType)
+			{
+			case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:		return 4;
+			case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:	return 3;
+			case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:		return 2;
+			case VK_PHYSICAL_DEVICE_TYPE_CPU:				return 1;
+			default:										return 0;
+			}
+		}
+	}
+
+	//-----------------------------------------------------------
+	// Initialize each command queue.
+	//-----------------------------------------------------------
+	bool CommandQueue::Initialize(Device* pDevice)
+	{
+		device_ = pDevice->GetNativeDevice();
+
+		for (u32 i = 0; i < CommandQueueType::MAX; i++)
+		{
+			signaledValues_[i].store(0);
+
+			// if compute or copy family is not found, these use graphics queue.
+			u32 family = pDevice->GetQueueFamily(static_cast<CommandQueueType::Type>(i));
+			if (family == kInvalidIndex)
+			{
+				continue;
+			}
+
+			// create timeline semaphore as fence.
+			VkSemaphoreTypeCreateInfo type_info{};
+			type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+			type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+			type_info.initialValue = 0;
+			VkSemaphoreCreateInfo info{};
+			info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			info.pNext = &type_info;
+			if (vkCreateSemaphore(device_, &info, nullptr, &semaphores_[i]) != VK_SUCCESS)
+			{
+				return false;
+			}
+
+			vkGetDeviceQueue(device_, family, 0, &queues_[i]);
+			familyIndices_[i] = family;
+		}
+
+		return queues_[CommandQueueType::Graphics] != VK_NULL_HANDLE;
+	}
+
+	//-----------------------------------------------------------
+	// Destroy each command queue.
+	//-----------------------------------------------------------
+	void CommandQueue::Destroy()
+	{
+		for (auto&& semaphore : semaphores_)
+		{
+			if (semaphore != VK_NULL_HANDLE)
+			{
+				vkDestroySemaphore(device_, semaphore, nullptr);
+				semaphore = VK_NULL_HANDLE;
+			}
+		}
+		for (auto&& queue : queues_)
+		{
+			queue = VK_NULL_HANDLE;
+		}
+	}
+
+	//-----------------------------------------------------------
+	// submit command buffers with timeline signal.
+	//-----------------------------------------------------------
+	void CommandQueue::SubmitCommandBuffers(VkQueue queue, const VkCommandBuffer* pBuffers, u32 count, const TimelineSignal& signal, const TimelineSignal* pWaits, u32 waitCount)
+	{
+		// wait arrays are reused per thread.
+		static thread_local std::vector<VkSemaphore> s_waitSemaphores;
+		static thread_local std::vector<u64> s_waitValues;
+		static thread_local std::vector<VkPipelineStageFlags> s_waitStages;
+		s_waitSemaphores.resize(waitCount);
+		s_waitValues.resize(waitCount);
+		s_waitStages.resize(waitCount);
+		for (u32 i = 0; i < waitCount; i++)
+		{
+			s_waitSemaphores[i] = pWaits[i].semaphore;
+			s_waitValues[i] = pWaits[i].value;
+			s_waitStages[i] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		}
+
+		VkTimelineSemaphoreSubmitInfo timeline_info{};
+		timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timeline_info.waitSemaphoreValueCount = waitCount;
+		timeline_info.pWaitSemaphoreValues = s_waitValues.data();
+		timeline_info.signalSemaphoreValueCount = 1;
+		timeline_info.pSignalSemaphoreValues = &signal.value;
+
+		VkSubmitInfo info{};
+		info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		info.pNext = &timeline_info;
+		info.waitSemaphoreCount = waitCount;
+		info.pWaitSemaphores = s_waitSemaphores.data();
+		info.pWaitDstStageMask = s_waitStages.data();
+		info.commandBufferCount = count;
+		info.pCommandBuffers = pBuffers;
+		info.signalSemaphoreCount = 1;
+		info.pSignalSemaphores = &signal.semaphore;
+
+		auto result = vkQueueSubmit(queue, 1, &info, VK_NULL_HANDLE);
+		assert(result == VK_SUCCESS);
+		(void)result;
+	}
+
+	//-----------------------------------------------------------
+	// Get fence value completed on command queue.
+	//-----------------------------------------------------------
+	u64 CommandQueue::GetCompletedFenceValue(CommandQueueType::Type type) const
+	{
+		u64 value = 0;
+		auto result = vkGetSemaphoreCounterValue(device_, semaphores_[GetFenceIndex(type)], &value);
+		assert(result == VK_SUCCESS);
+		(void)result;
+		return value;
+	}
+
+	//-----------------------------------------------------------
+	// Wait all command queues idle.
+	//-----------------------------------------------------------
+	void CommandQueue::WaitIdle()
+	{
+		for (u32 i = 0; i < CommandQueueType::MAX; i++)
+		{
+			if (queues_[i] == VK_NULL_HANDLE)
+			{
+				continue;
+			}
+
+			auto type = static_cast<CommandQueueType::Type>(i);
+			WaitFence(type, Signal(type));
+		}
+	}
+
+	//-----------------------------------------------------------
+	// Wait fence value on CPU.
+	//-----------------------------------------------------------
+	void CommandQueue::WaitFence(CommandQueueType::Type type, u64 value)
+	{
+		VkSemaphoreWaitInfo info{};
+		info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		info.semaphoreCount = 1;
+		info.pSemaphores = &semaphores_[GetFenceIndex(type)];
+		info.pValues = &value;
+		auto result = vkWaitSemaphores(device_, &info, UINT64_MAX);
+		assert(result == VK_SUCCESS);
+		(void)result;
+	}
+
+
+	//-----------------------------------------------------------
+	// Release device.
+	//-----------------------------------------------------------
+	void IDevice::Release()
+	{
+		MLL_DELETE(this);
+	}
+
+	//-----------------------------------------------------------
+	// Get last fence value signaled on command queue.
+	//-----------------------------------------------------------
+	u64 IDevice::GetSignaledFenceValue(CommandQueueType::Type type)
+	{
+		return static_cast<Device*>(this)->GetCommandQueue()->GetSignaledFenceValue(type);
+	}
+
+	//-----------------------------------------------------------
+	// Get fence value completed on command queue.
+	//-----------------------------------------------------------
+	u64 IDevice::GetCompletedFenceValue(CommandQueueType::Type type)
+	{
+		return static_cast<Device*>(this)->GetCommandQueue()->GetCompletedFenceValue(type);
+	}
+
+	//-----------------------------------------------------------
+	// Graphics device create function.
+	//-----------------------------------------------------------
+	ObjPtr<IDevice> IDevice::CreateGraphicsDevice(const DeviceDesc& desc)
+	{
+		auto ret = MLL_NEW(Device);
+
+		auto init_result = ret->Initialize(desc);
+		if (!init_result)
+		{
+			MLL_DELETE(ret);
+			return ObjPtr<IDevice>();
+		}
+
+		return ObjPtr<IDevice>(ret);
+	}
+
+	//-----------------------------------------------------------
+	// Initialize device.
+	//-----------------------------------------------------------
+	bool Device::Initialize(const DeviceDesc& desc)
+	{
+		// create instance.
+		{
+			std::vector<const char*> layers;
+			std::vector<const char*> extensions;
+			if (desc.enableDebugLayer && HasInstanceLayer("VK_LAYER_KHRONOS_validation"))
+			{
+				layers.push_back("VK_LAYER_KHRONOS_validation");
+			}
+			bool use_debug_utils = (desc.enableDebugLayer || desc.enableNativeObjectName) && HasInstanceExtension(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+			if (use_debug_utils)
+			{
+				extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+			}
+
+			VkApplicationInfo app_info{};
+			app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+			app_info.pEngineName = "mll";
+			app_info.apiVersion = VK_API_VERSION_1_2;
+
+			VkInstanceCreateInfo info{};
+			info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+			info.pApplicationInfo = &app_info;
+			info.enabledLayerCount = static_cast<u32>(layers.size());
+			info.ppEnabledLayerNames = layers.data();
+			info.enabledExtensionCount = static_cast<u32>(extensions.size());
+			info.ppEnabledExtensionNames = extensions.data();
+			if (vkCreateInstance(&info, nullptr, &instance_) != VK_SUCCESS)
+			{
+				return false;
+			}
+
+			if (use_debug_utils && desc.enableNativeObjectName)
+			{
+				pfnSetObjectName_ = reinterpret_cast<PFN_vkSetDebugUtilsObjectNameEXT>(vkGetInstanceProcAddr(instance_, "vkSetDebugUtilsObjectNameEXT"));
+			}
+		}
+
+		// select physical device.
+		{
+			u32 count = 0;
+			vkEnumeratePhysicalDevices(instance_, &count, nullptr);
+			std::vector<VkPhysicalDevice> devices(count);
+			vkEnumeratePhysicalDevices(instance_, &count, devices.data());
+
+			int best_score = -1;
+			for (auto&& device : devices)
+			{
+				int score = ScorePhysicalDevice(device);
+				if (score > best_score)
+				{
+					best_score = score;
+					physicalDevice_ = device;
+				}
+			}
+			if (physicalDevice_ == VK_NULL_HANDLE)
+			{
+				return false;
+			}
+
+			vkGetPhysicalDeviceMemoryProperties(physicalDevice_, &memoryProperties_);
+			enableRaytracing_ = HasDeviceExtension(physicalDevice_, "VK_KHR_ray_tracing_pipeline");
+		}
+
+		// find queue families.
+		{
+			u32 count = 0;
+			vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &count, nullptr);
+			std::vector<VkQueueFamilyProperties> props(count);
+			vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &count, props.data());
+
+			// compute and copy use dedicated family only, shared family is graphics queue itself.
+			VkQueueFlags exclude_flags[] = { 0, VK_QUEUE_GRAPHICS_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT };
+			for (u32 type = 0; type < CommandQueueType::MAX; type++)
+			{
+				queueFamilies_[type] = kInvalidIndex;
+				auto required = GetNativeQueueFlags(static_cast<CommandQueueType::Type>(type));
+				for (u32 i = 0; i < count; i++)
+				{
+					if (props[i].queueCount > 0 && (props[i].queueFlags & required) == required && (props[i].queueFlags & exclude_flags[type]) == 0)
+					{
+						queueFamilies_[type] = i;
+						sharedQueueFamilies_.push_back(i);
+						break;
+					}
+				}
+			}
+			if (queueFamilies_[CommandQueueType::Graphics] == kInvalidIndex)
+			{
+				return false;
+			}
+		}
+
+		// create device.
+		{
+			f32 priority = 1.0f;
+			std::vector<VkDeviceQueueCreateInfo> queue_infos;
+			for (auto family : sharedQueueFamilies_)
+			{
+				VkDeviceQueueCreateInfo info{};
+				info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+				info.queueFamilyIndex = family;
+				info.queueCount = 1;
+				info.pQueuePriorities = &priority;
+				queue_infos.push_back(info);
+			}
+
+			VkPhysicalDeviceVulkan12Features features12{};
+			features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+			features12.timelineSemaphore = VK_TRUE;
+
+			VkDeviceCreateInfo info{};
+			info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+			info.pNext = &features12;
+			info.queueCreateInfoCount = static_cast<u32>(queue_infos.size());
+			info.pQueueCreateInfos = queue_infos.data();
+			if (vkCreateDevice(physicalDevice_, &info, nullptr, &device_) != VK_SUCCESS)
+			{
+				return false;
+			}
+		}
+
+		// CommandQueue生成
+		pCommandQueue_ = MLL_NEW(CommandQueue);
+		assert(pCommandQueue_ != nullptr);
+		if (!pCommandQueue_->Initialize(this))
+		{
+			return false;
+		}
+
+		// command pool for initial image layout.
+		{
+			VkCommandPoolCreateInfo info{};
+			info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			info.queueFamilyIndex = queueFamilies_[CommandQueueType::Graphics];
+			if (vkCreateCommandPool(device_, &info, nullptr, &initCmdPool_) != VK_SUCCESS)
+			{
+				return false;
+			}
+		}
+
+		for (u32 i = 0; i < CommandQueueType::MAX; i++)
+		{
+			pAllocatorPools_[i] = MLL_NEW(CommandAllocatorPool);
+			assert(pAllocatorPools_[i] != nullptr);
+			pAllocatorPools_[i]->Initialize(this, static_cast<CommandQueueType::Type>(i));
+		}
+
+		InitializeDeathList(desc);
+
+		return true;
+	}
+
+	//-----------------------------------------------------------
+	// Destroy device.
+	//-----------------------------------------------------------
+	void Device::Destroy()
+	{
+		if (pCommandQueue_ != nullptr)
+		{
+			pCommandQueue_->WaitIdle();
+		}
+		FinalizeDeathList();
+
+		// killed objects are removed from live objects in death list processing.
+		u32 live_obj_cnt = IterateLiveObjects([](IDeviceChild* p) {});
+		assert(live_obj_cnt == 0);
+		(void)live_obj_cnt;
+
+		// command lists return allocators on destruction, so pools are deleted after death list.
+		for (auto&& pool : pAllocatorPools_)
+		{
+			MLL_DELETE(pool);
+			pool = nullptr;
+		}
+
+		if (initCmdPool_ != VK_NULL_HANDLE)
+		{
+			RetireInitCommands(true);
+			vkDestroyCommandPool(device_, initCmdPool_, nullptr);
+			initCmdPool_ = VK_NULL_HANDLE;
+		}
+		MLL_DELETE(pCommandQueue_);
+		pCommandQueue_ = nullptr;
+
+		if (device_ != VK_NULL_HANDLE)
+		{
+			vkDestroyDevice(device_, nullptr);
+			device_ = VK_NULL_HANDLE;
+		}
+		if (instance_ != VK_NULL_HANDLE)
+		{
+			vkDestroyInstance(instance_, nullptr);
+			instance_ = VK_NULL_HANDLE;
+		}
+	}
+
+	//-----------------------------------------------------------
+	// find memory type index.
+	//-----------------------------------------------------------
+	u32 Device::FindMemoryType(u32 typeBits, VkMemoryPropertyFlags properties) const
+	{
+		for (u32 i = 0; i < memoryProperties_.memoryTypeCount; i++)
+		{
+			if ((typeBits & (1u << i)) && (memoryProperties_.memoryTypes[i].propertyFlags & properties) == properties)
+			{
+				return i;
+			}
+		}
+		return kInvalidIndex;
+	}
+
+	//-----------------------------------------------------------
+	// set name to vulkan object.
+	//-----------------------------------------------------------
+	void Device::SetNativeObjectName(VkObjectType type, u64 handle, const char* name)
+	{
+		if (pfnSetObjectName_ == nullptr || handle == 0)
+		{
+			return;
+		}
+
+		VkDebugUtilsObjectNameInfoEXT info{};
+		info.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+		info.objectType = type;
+		info.objectHandle = handle;
+		info.pObjectName = name;
+		pfnSetObjectName_(device_, &info);
+	}
+
+	//-----------------------------------------------------------
+	// transition new image to its resting layout.
+	//-----------------------------------------------------------
+	void Device::InitializeImageLayout(VkImage image, VkImageAspectFlags aspect, const NativeResourceState& state)
+	{
+		std::lock_guard<std::mutex> lock(initMutex_);
+		RetireInitCommands(false);
+
+		VkCommandBufferAllocateInfo alloc_info{};
+		alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		alloc_info.commandPool = initCmdPool_;
+		alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		alloc_info.commandBufferCount = 1;
+		VkCommandBuffer cmd = VK_NULL_HANDLE;
+		auto result = vkAllocateCommandBuffers(device_, &alloc_info, &cmd);
+		assert(result == VK_SUCCESS);
+
+		VkCommandBufferBeginInfo begin_info{};
+		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(cmd, &begin_info);
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = state.access;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = state.layout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = aspect;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, state.stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		result = vkEndCommandBuffer(cmd);
+		assert(result == VK_SUCCESS);
+		(void)result;
+
+		// later graphics submissions are ordered after this.
+		auto p_queue = pCommandQueue_;
+		u64 value = p_queue->ExecuteAndSignal(CommandQueueType::Graphics, [&](VkQueue queue, const TimelineSignal& signal)
+		{
+			p_queue->SubmitCommandBuffers(queue, &cmd, 1, signal);
+		});
+		initCmds_.push_back({ cmd, value });
+	}
+
+	//-----------------------------------------------------------
+	// free completed initial layout commands.
+	//-----------------------------------------------------------
+	void Device::RetireInitCommands(bool bForce)
+	{
+		u64 completed = pCommandQueue_->GetCompletedFenceValue(CommandQueueType::Graphics);
+		auto it = std::remove_if(initCmds_.begin(), initCmds_.end(), [&](const InitCommand& cmd)
+		{
+			if (!bForce && cmd.fenceValue > completed)
+			{
+				return false;
+			}
+			vkFreeCommandBuffers(device_, initCmdPool_, 1, &cmd.buffer);
+			return true;
+		});
+		initCmds_.erase(it, initCmds_.end());
+	}
+
+
+	//-----------------------------------------------------------
+	// Submit command lists at once.
+	//-----------------------------------------------------------
+	SubmitTicket IDevice::Submit(CommandQueueType::Type type, ICommandList* const* ppCmdLists, u32 count, const SubmitTicket* pWaitTickets, u32 waitTicketCount)
+	{
+		CaptureSubmit(type, ppCmdLists, count);
+
+		auto p_queue = static_cast<Device*>(this)->GetCommandQueue();
+
+		// native arrays are reused per thread.
+		static thread_local std::vector<VkCommandBuffer> s_buffers;
+		static thread_local std::vector<TimelineSignal> s_waits;
+		s_buffers.resize(count);
+		for (u32 i = 0; i < count; i++)
+		{
+			auto p_list = static_cast<CommandList*>(ppCmdLists[i]);
+			assert(!p_list->IsRecording() && !p_list->IsBundle());
+			assert(p_list->GetDesc().typeCommandQueue == type);
+			assert(!p_list->IsExecutedBundleChanged());
+			s_buffers[i] = p_list->GetNativeCmdBuffer();
+		}
+
+		// same queue is ordered already.
+		auto own_semaphore = p_queue->GetSemaphore(type);
+		s_waits.clear();
+		for (u32 i = 0; i < waitTicketCount; i++)
+		{
+			auto semaphore = p_queue->GetSemaphore(pWaitTickets[i].queueType);
+			if (semaphore != own_semaphore && pWaitTickets[i].IsValid())
+			{
+				s_waits.push_back(TimelineSignal{ semaphore, pWaitTickets[i].fenceValue });
+			}
+		}
+
+		SubmitTicket ticket;
+		ticket.queueType = type;
+		ticket.fenceValue = p_queue->ExecuteAndSignal(type, [&](VkQueue queue, const TimelineSignal& signal)
+		{
+			p_queue->SubmitCommandBuffers(queue, s_buffers.data(), count, signal, s_waits.data(), static_cast<u32>(s_waits.size()));
+		});
+
+		for (u32 i = 0; i < count; i++)
+		{
+			static_cast<CommandList*>(ppCmdLists[i])->SetSubmittedFenceValue(ticket.fenceValue);
+		}
+		return ticket;
+	}
+
+	//-----------------------------------------------------------
+	// Wait submission on CPU.
+	//-----------------------------------------------------------
+	void IDevice::WaitTicket(const SubmitTicket& ticket)
+	{
+		static_cast<Device*>(this)->GetCommandQueue()->WaitFence(ticket.queueType, ticket.fenceValue);
+	}
+
+	//-----------------------------------------------------------
+	// Get command allocator pool statistics.
+	//-----------------------------------------------------------
+	void IDevice::GetCommandAllocatorStats(CommandQueueType::Type type, CommandAllocatorStats& outStats)
+	{
+		outStats = static_cast<Device*>(this)->GetCommandAllocatorPool(type)->GetStats();
+	}
+
+	//-----------------------------------------------------------
+	// Get descriptor ring statistics.
+	//-----------------------------------------------------------
+	void IDevice::GetDescriptorRingStats(CommandQueueType::Type type, DescriptorRingStats& outStats)
+	{
+		// descriptor sets are not managed by ring.
+		outStats = DescriptorRingStats();
+	}
+
+	//-----------------------------------------------------------
+	// Get sampler cache statistics.
+	//-----------------------------------------------------------
+	void IDevice::GetSamplerCacheStats(SamplerCacheStats& outStats)
+	{
+		// samplers are not cached in descriptor heap.
+		outStats = SamplerCacheStats();
+	}
+
+	//-----------------------------------------------------------
+	// Create command list.
+	//-----------------------------------------------------------
+	Result::Type IDevice::CreateCommandList(const CommandListDesc& desc, ObjPtr<ICommandList>& outObj)
+	{
+		auto p = MLL_NEW(CommandList);
+
+		auto result = p->Initialize(static_cast<Device*>(this), desc);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+			return result;
+		}
+
+		result = AppendDeviceChild<ICommandList>(p, outObj);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+		}
+		return result;
+	}
+
+	//-----------------------------------------------------------
+	// Create swapchain.
+	//-----------------------------------------------------------
+	Result::Type IDevice::CreateSwapchain(const SwapchainDesc& desc, ObjPtr<ISwapchain>& outObj)
+	{
+		auto p = MLL_NEW(Swapchain);
+
+		auto result = p->Initialize(static_cast<Device*>(this), desc);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+			return result;
+		}
+
+		result = AppendDeviceChild<ISwapchain>(p, outObj);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+		}
+		return result;
+	}
+
+	//-----------------------------------------------------------
+	// Create texture.
+	//-----------------------------------------------------------
+	Result::Type IDevice::CreateTexture(const TextureDesc& desc, ObjPtr<ITexture>& outObj)
+	{
+		auto p = MLL_NEW(Texture);
+
+		auto result = p->Initialize(static_cast<Device*>(this), desc);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+			return result;
+		}
+
+		result = AppendDeviceChild<ITexture>(p, outObj);
+		if (IsFailed(result))
+		{
+			MLL_DELETE(p);
+		}
+		return result;
+	}
+
+}
+//	EOF
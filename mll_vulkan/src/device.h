@@ -0,0 +1,236 @@
+﻿#pragma once
+
+#include "native.h"
+#include "command_allocator_pool.h"
+
+#include <cassert>
+#include <vector>
+
+
+namespace mll
+{
+	class Device;
+
+	//-----------------------------------------------------------
+	//! @brief timeline semaphore value signaled by a submission.
+	//-----------------------------------------------------------
+	struct TimelineSignal
+	{
+		VkSemaphore		semaphore;
+		u64				value;
+	};	// struct TimelineSignal
+
+	//-----------------------------------------------------------
+	//! @brief Command queues.
+	//!
+	//! Each queue has a timeline semaphore as fence.
+	//! Compute and copy queues fall back to graphics queue if device has no dedicated family.
+	//-----------------------------------------------------------
+	class CommandQueue
+	{
+		MLL_DECLARE_CLASS_ALLOCATOR(AllocCategory::Device);
+
+	public:
+		CommandQueue()
+		{}
+		~CommandQueue()
+		{
+			Destroy();
+		}
+
+		bool Initialize(Device* pDevice);
+		void Destroy();
+
+		VkQueue GetNativeQueue(CommandQueueType::Type type) const
+		{
+			return queues_[GetFenceIndex(type)];
+		}
+		u32 GetQueueFamilyIndex(CommandQueueType::Type type) const
+		{
+			return familyIndices_[GetFenceIndex(type)];
+		}
+
+		/**
+		 * @brief execute commands and signal fence on command queue.
+		 *
+		 * @param[in]	type		command queue type.
+		 * @param[in]	func		function to submit commands, called with native queue and timeline signal to attach.
+		 * @return					signaled fence value.
+		*/
+		template <typename TFunc>
+		u64 ExecuteAndSignal(CommandQueueType::Type type, TFunc func)
+		{
+			auto index = GetFenceIndex(type);
+			std::lock_guard<std::mutex> lock(queueMutexes_[index]);
+
+			// publish fence value before execution.
+			// objects killed after this point wait for this value.
+			u64 value = signaledValues_[index].load() + 1;
+			signaledValues_[index].store(value);
+
+			TimelineSignal signal{ semaphores_[index], value };
+			func(queues_[index], signal);
+			return value;
+		}
+
+		/**
+		 * @brief submit command buffers with timeline signal.
+		 *
+		 * @param[in]	pWaits		timeline values waited before execution.
+		*/
+		void SubmitCommandBuffers(VkQueue queue, const VkCommandBuffer* pBuffers, u32 count, const TimelineSignal& signal, const TimelineSignal* pWaits = nullptr, u32 waitCount = 0);
+
+		/**
+		 * @brief signal fence on command queue.
+		*/
+		u64 Signal(CommandQueueType::Type type)
+		{
+			return ExecuteAndSignal(type, [&](VkQueue queue, const TimelineSignal& signal)
+			{
+				SubmitCommandBuffers(queue, nullptr, 0, signal);
+			});
+		}
+
+		/**
+		 * @brief wait fence value on CPU.
+		*/
+		void WaitFence(CommandQueueType::Type type, u64 value);
+
+		/**
+		 * @brief wait all command queues idle.
+		*/
+		void WaitIdle();
+
+		VkSemaphore GetSemaphore(CommandQueueType::Type type) const
+		{
+			return semaphores_[GetFenceIndex(type)];
+		}
+		u64 GetSignaledFenceValue(CommandQueueType::Type type) const
+		{
+			return signaledValues_[GetFenceIndex(type)].load();
+		}
+		u64 GetCompletedFenceValue(CommandQueueType::Type type) const;
+
+	private:
+		u32 GetFenceIndex(CommandQueueType::Type type) const
+		{
+			return (queues_[type] != VK_NULL_HANDLE) ? type : CommandQueueType::Graphics;
+		}
+
+	private:
+		VkDevice			device_ = VK_NULL_HANDLE;
+		VkQueue				queues_[CommandQueueType::MAX] = {};
+		u32					familyIndices_[CommandQueueType::MAX] = {};
+		VkSemaphore			semaphores_[CommandQueueType::MAX] = {};
+		std::atomic<u64>	signaledValues_[CommandQueueType::MAX];
+		std::mutex			queueMutexes_[CommandQueueType::MAX];
+	};	// class CommandQueue
+
+	//-----------------------------------------------------------
+	//! @brief Graphics device object.
+	//-----------------------------------------------------------
+	class Device
+		: public IDevice
+	{
+		friend class IDevice;
+
+	public:
+		Device()
+		{}
+		~Device()
+		{
+			Destroy();
+		}
+
+		VkInstance GetNativeInstance() const
+		{
+			return instance_;
+		}
+		VkPhysicalDevice GetNativePhysicalDevice() const
+		{
+			return physicalDevice_;
+		}
+		VkDevice GetNativeDevice() const
+		{
+			return device_;
+		}
+		CommandQueue* GetCommandQueue()
+		{
+			return pCommandQueue_;
+		}
+		CommandAllocatorPool* GetCommandAllocatorPool(CommandQueueType::Type type)
+		{
+			return pAllocatorPools_[type];
+		}
+		bool IsNativeObjectNameEnabled() const
+		{
+			return pfnSetObjectName_ != nullptr;
+		}
+
+		/**
+		 * @brief get queue family index created for command queue type.
+		 *
+		 * @return					UINT32_MAX if queue type falls back to graphics queue.
+		*/
+		u32 GetQueueFamily(CommandQueueType::Type type) const
+		{
+			return queueFamilies_[type];
+		}
+
+		/**
+		 * @brief get queue families shared by resources.
+		*/
+		const std::vector<u32>& GetSharedQueueFamilies() const
+		{
+			return sharedQueueFamilies_;
+		}
+
+		/**
+		 * @brief find memory type index.
+		 *
+		 * @return					UINT32_MAX if not found.
+		*/
+		u32 FindMemoryType(u32 typeBits, VkMemoryPropertyFlags properties) const;
+
+		/**
+		 * @brief set name to vulkan object.
+		*/
+		void SetNativeObjectName(VkObjectType type, u64 handle, const char* name);
+
+		/**
+		 * @brief transition new image to its resting layout on graphics queue.
+		*/
+		void InitializeImageLayout(VkImage image, VkImageAspectFlags aspect, const NativeResourceState& state);
+
+	private:
+		bool Initialize(const DeviceDesc& desc);
+		void Destroy();
+
+		void RetireInitCommands(bool bForce);
+
+	private:
+		struct InitCommand
+		{
+			VkCommandBuffer		buffer;
+			u64					fenceValue;
+		};	// struct InitCommand
+
+		VkInstance							instance_ = VK_NULL_HANDLE;
+		VkPhysicalDevice					physicalDevice_ = VK_NULL_HANDLE;
+		VkDevice							device_ = VK_NULL_HANDLE;
+		VkPhysicalDeviceMemoryProperties	memoryProperties_ = {};
+		u32									queueFamilies_[CommandQueueType::MAX] = {};
+		std::vector<u32>					sharedQueueFamilies_;
+
+		PFN_vkSetDebugUtilsObjectNameEXT	pfnSetObjectName_ = nullptr;
+
+		CommandQueue*				pCommandQueue_ = nullptr;
+		CommandAllocatorPool*		pAllocatorPools_[CommandQueueType::MAX] = {};
+
+		std::mutex					initMutex_;
+		VkCommandPool				initCmdPool_ = VK_NULL_HANDLE;
+		std::vector<InitCommand>	initCmds_;
+	};	// class Device
+
+}
+//	EOF
@@ -0,0 +1,184 @@
+﻿#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include "mll/mll_defines.h"
+#include "mll/mll_interfaces.h"
+
+
+namespace mll
+{
+	//-----------------------------------------------------------
+	//! @brief vulkan layout, access and stage of resource state.
+	//-----------------------------------------------------------
+	struct NativeResourceState
+	{
+		VkImageLayout			layout;
+		VkAccessFlags			access;
+		VkPipelineStageFlags	stage;
+	};	// struct NativeResourceState
+
+	/**
+	 * @brief get vulkan queue flags required for command queue type.
+	*/
+	inline VkQueueFlags GetNativeQueueFlags(CommandQueueType::Type v)
+	{
+		static const VkQueueFlags k[] = {
+			VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT,		// Graphics
+			VK_QUEUE_COMPUTE_BIT,								// Compute
+			VK_QUEUE_TRANSFER_BIT,								// Copy
+		};
+		return k[v];
+	}
+
+	/**
+	 * @brief get pipeline stages usable on command queue type.
+	*/
+	inline VkPipelineStageFlags GetNativeQueueStages(CommandQueueType::Type v)
+	{
+		static const VkPipelineStageFlags k[] = {
+			~0u,			// Graphics
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,	// Compute
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,		// Copy
+		};
+		return k[v];
+	}
+
+	/**
+	 * @brief get vulkan format.
+	*/
+	inline VkFormat GetNativeResourceFormat(ResourceFormat::Type v)
+	{
+		static const VkFormat k[] = {
+			VK_FORMAT_UNDEFINED,					// Unknown
+			VK_FORMAT_R32G32B32A32_SFLOAT,			// R32G32B32A32_Float
+			VK_FORMAT_R32G32B32A32_UINT,			// R32G32B32A32_Uint
+			VK_FORMAT_R32G32B32A32_SINT,			// R32G32B32A32_Sint
+			VK_FORMAT_R32G32B32_SFLOAT,				// R32G32B32_Float
+			VK_FORMAT_R32G32B32_UINT,				// R32G32B32_Uint
+			VK_FORMAT_R32G32B32_SINT,				// R32G32B32_Sint
+			VK_FORMAT_R32G32_SFLOAT,				// R32G32_Float
+			VK_FORMAT_R32G32_UINT,					// R32G32_Uint
+			VK_FORMAT_R32G32_SINT,					// R32G32_Sint
+			VK_FORMAT_R32_SFLOAT,					// R32_Float
+			VK_FORMAT_R32_UINT,						// R32_Uint
+			VK_FORMAT_R32_SINT,						// R32_Sint
+			VK_FORMAT_R16G16B16A16_SFLOAT,			// R16G16B16A16_Float
+			VK_FORMAT_R16G16B16A16_UNORM,			// R16G16B16A16_Unorm
+			VK_FORMAT_R16G16B16A16_UINT,			// R16G16B16A16_Uint
+			VK_FORMAT_R16G16B16A16_SNORM,			// R16G16B16A16_Snorm
+			VK_FORMAT_R16G16B16A16_SINT,			// R16G16B16A16_Sint
+			VK_FORMAT_R16G16_SFLOAT,				// R16G16_Float
+			VK_FORMAT_R16G16_UNORM,					// R16G16_Unorm
+			VK_FORMAT_R16G16_UINT,					// R16G16_Uint
+			VK_FORMAT_R16G16_SNORM,					// R16G16_Snorm
+			VK_FORMAT_R16G16_SINT,					// R16G16_Sint
+			VK_FORMAT_R16_SFLOAT,					// R16_Float
+			VK_FORMAT_R16_UNORM,					// R16_Unorm
+			VK_FORMAT_R16_UINT,						// R16_Uint
+			VK_FORMAT_R16_SNORM,					// R16_Snorm
+			VK_FORMAT_R16_SINT,						// R16_Sint
+			VK_FORMAT_R8G8B8A8_UNORM,				// R8G8B8A8_Unorm
+			VK_FORMAT_R8G8B8A8_SRGB,				// R8G8B8A8_Unorm_Srgb
+			VK_FORMAT_R8G8B8A8_UINT,				// R8G8B8A8_Uint
+			VK_FORMAT_R8G8B8A8_SNORM,				// R8G8B8A8_Snorm
+			VK_FORMAT_R8G8B8A8_SINT,				// R8G8B8A8_Sint
+			VK_FORMAT_R8G8_UNORM,					// R8G8_Unorm
+			VK_FORMAT_R8G8_UINT,					// R8G8_Uint
+			VK_FORMAT_R8G8_SNORM,					// R8G8_Snorm
+			VK_FORMAT_R8G8_SINT,					// R8G8_Sint
+			VK_FORMAT_R8_UNORM,						// R8_Unorm
+			VK_FORMAT_R8_UINT,						// R8_Uint
+			VK_FORMAT_R8_SNORM,						// R8_Snorm
+			VK_FORMAT_R8_SINT,						// R8_Sint
+			VK_FORMAT_B8G8R8A8_UNORM,				// B8G8R8A8_Unorm
+			VK_FORMAT_B8G8R8A8_SRGB,				// B8G8R8A8_Unorm_Srgb
+			VK_FORMAT_B8G8R8A8_UNORM,				// B8G8R8X8_Unorm, alpha is ignored.
+			VK_FORMAT_B8G8R8A8_SRGB,				// B8G8R8X8_Unorm_Srgb, alpha is ignored.
+			VK_FORMAT_A2B10G10R10_UNORM_PACK32,		// R10G10B10A2_Unorm
+			VK_FORMAT_A2B10G10R10_UINT_PACK32,		// R10G10B10A2_Uint
+			VK_FORMAT_B10G11R11_UFLOAT_PACK32,		// R11G11B10_Float
+			VK_FORMAT_D32_SFLOAT,					// D32_Float
+			VK_FORMAT_D24_UNORM_S8_UINT,			// D24_Unorm_S8_Uint
+			VK_FORMAT_D16_UNORM,					// D16_Unorm
+			VK_FORMAT_BC1_RGBA_UNORM_BLOCK,			// BC1_Unorm
+			VK_FORMAT_BC1_RGBA_SRGB_BLOCK,			// BC1_Unorm_Srgb
+			VK_FORMAT_BC2_UNORM_BLOCK,				// BC2_Unorm
+			VK_FORMAT_BC2_SRGB_BLOCK,				// BC2_Unorm_Srgb
+			VK_FORMAT_BC3_UNORM_BLOCK,				// BC3_Unorm
+			VK_FORMAT_BC3_SRGB_BLOCK,				// BC3_Unorm_Srgb
+			VK_FORMAT_BC4_UNORM_BLOCK,				// BC4_Unorm
+			VK_FORMAT_BC4_SNORM_BLOCK,				// BC4_Snorm
+			VK_FORMAT_BC5_UNORM_BLOCK,				// BC5_Unorm
+			VK_FORMAT_BC5_SNORM_BLOCK,				// BC5_Snorm
+			VK_FORMAT_BC6H_UFLOAT_BLOCK,			// BC6H_UFloat
+			VK_FORMAT_BC6H_SFLOAT_BLOCK,			// BC6H_SFloat
+			VK_FORMAT_BC7_UNORM_BLOCK,				// BC7_Unorm
+			VK_FORMAT_BC7_SRGB_BLOCK,				// BC7_Unorm_Srgb
+		};
+		static_assert(sizeof(k) / sizeof(k[0]) == ResourceFormat::MAX, "format table must cover all formats.");
+		return k[v];
+	}
+
+	/**
+	 * @brief get vulkan image aspect of format.
+	*/
+	inline VkImageAspectFlags GetNativeImageAspect(ResourceFormat::Type v)
+	{
+		switch (v)
+		{
+		case ResourceFormat::D32_Float:
+		case ResourceFormat::D16_Unorm:
+			return VK_IMAGE_ASPECT_DEPTH_BIT;
+		case ResourceFormat::D24_Unorm_S8_Uint:
+			return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+		default:
+			return VK_IMAGE_ASPECT_COLOR_BIT;
+		}
+	}
+
+	/**
+	 * @brief get vulkan image type.
+	*/
+	inline VkImageType GetNativeImageType(ResourceDimension::Type v)
+	{
+		static const VkImageType k[] = {
+			VK_IMAGE_TYPE_MAX_ENUM,		// Buffer
+			VK_IMAGE_TYPE_1D,			// Texture1D
+			VK_IMAGE_TYPE_2D,			// Texture2D
+			VK_IMAGE_TYPE_3D,			// Texture3D
+		};
+		return k[v];
+	}
+
+	/**
+	 * @brief get vulkan layout, access and stage of resource state.
+	*/
+	inline const NativeResourceState& GetNativeResourceState(ResourceState::Type v)
+	{
+		static const VkPipelineStageFlags kShaderStages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		static const NativeResourceState k[] = {
+			{ VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT },								// Unknown
+			{ VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_UNIFORM_READ_BIT, kShaderStages },																					// ConstantBuffer
+			{ VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT },													// VertexBuffer
+			{ VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_INDEX_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT },																// IndexBuffer
+			{ VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_SHADER_READ_BIT, kShaderStages },																	// ShaderResource
+			{ VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT },	// RenderTarget
+			{ VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+				VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT },															// DepthWrite
+			{ VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+				VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | kShaderStages },											// DepthRead
+			{ VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, kShaderStages },														// UnorderedAccess
+			{ VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT },													// IndirectArg
+			{ VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT },													// CopySrc
+			{ VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT },													// CopyDst
+			{ VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_MEMORY_READ_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT },															// Present, offscreen only.
+			{ VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT },								// AccelerationStructure
+			{ VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_MEMORY_READ_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT },																// ShadingRate
+		};
+		static_assert(sizeof(k) / sizeof(k[0]) == ResourceState::MAX, "state table must cover all states.");
+		return k[v];
+	}
+
+}
+//	EOF
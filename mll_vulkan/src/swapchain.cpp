@@ -0,0 +1,103 @@
+﻿#include "swapchain.h"
+
+#include <cassert>
+
+#include "device.h"
+
+
+namespace mll
+{
+	MLL_IMPLEMENT_POOL_ALLOCATOR(Swapchain, AllocCategory::Swapchain);
+
+	void Swapchain::Release()
+	{
+		KillSelf();
+	}
+
+	//-----------------------------------------------------------
+	// initialize swapchain.
+	//-----------------------------------------------------------
+	Result::Type Swapchain::Initialize(Device* pDevice, const SwapchainDesc& desc)
+	{
+		desc_ = desc;
+
+		// offscreen back buffers only, see SwapchainDesc.
+		if (desc.windowHandle != nullptr || desc.frameRingName != nullptr)
+		{
+			return Result::InvalidOperation;
+		}
+		if (desc.backBufferCount == 0)
+		{
+			return Result::InvalidArgs;
+		}
+		frameIndex_.store(0);
+
+		TextureDesc tex_desc;
+		tex_desc.SetDimension(ResourceDimension::Texture2D)
+			.SetWidth(desc.width)
+			.SetHeight(desc.height)
+			.SetFormat(desc.format)
+			.SetUsageFlags(ResourceUsageFlag::RenderTarget)
+			.SetInitialState(ResourceState::Present);
+
+		backBuffers_.resize(desc.backBufferCount);
+		for (auto&& buffer : backBuffers_)
+		{
+			auto result = pDevice->CreateTexture(tex_desc, buffer);
+			if (IsFailed(result))
+			{
+				return result;
+			}
+		}
+
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// destroy swapchain.
+	//-----------------------------------------------------------
+	void Swapchain::Destroy()
+	{
+		backBuffers_.clear();
+	}
+
+
+#define Self()	static_cast<Swapchain*>(this)
+
+	//-----------------------------------------------------------
+	// present swapchain.
+	//-----------------------------------------------------------
+	void ISwapchain::Present(u32 syncInterval)
+	{
+		auto p_this = Self();
+		auto p_queue = static_cast<Device*>(pParentDevice_)->GetCommandQueue();
+
+		// signal graphics fence after present to advance frame timeline.
+		p_queue->ExecuteAndSignal(CommandQueueType::Graphics, [&](VkQueue queue, const TimelineSignal& signal)
+		{
+			p_queue->SubmitCommandBuffers(queue, nullptr, 0, signal);
+			p_this->frameIndex_.store((p_this->frameIndex_.load() + 1) % desc_.backBufferCount);
+		});
+	}
+
+	//-----------------------------------------------------------
+	// get current backbuffer index.
+	//-----------------------------------------------------------
+	u32 ISwapchain::GetBackBufferIndex() const
+	{
+		return static_cast<const Swapchain*>(this)->frameIndex_.load();
+	}
+
+	//-----------------------------------------------------------
+	// get backbuffer texture.
+	//-----------------------------------------------------------
+	ITexture* ISwapchain::GetBackBuffer(u32 index)
+	{
+		auto&& buffers = Self()->backBuffers_;
+		assert(index < buffers.size());
+		return buffers[index];
+	}
+
+#undef Self
+}
+//	EOF
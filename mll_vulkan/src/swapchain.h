@@ -0,0 +1,49 @@
+﻿#pragma once
+
+#include "native.h"
+
+#include <vector>
+
+
+namespace mll
+{
+	class Device;
+
+	//-----------------------------------------------------------
+	//! @brief swapchain.
+	//!
+	//! Vulkan swapchain is offscreen, back buffers are render target textures
+	//! and present only advances back buffer index on graphics timeline.
+	//-----------------------------------------------------------
+	class Swapchain
+		: public ISwapchain
+	{
+		MLL_DECLARE_POOL_ALLOCATOR();
+
+		friend class IDevice;
+		friend class ISwapchain;
+
+	private:
+		Swapchain()
+			: ISwapchain()
+		{}
+		~Swapchain()
+		{
+			Destroy();
+		}
+
+		Result::Type Initialize(Device* pDevice, const SwapchainDesc& desc);
+		void Destroy();
+
+		/**
+		 * @brief Release self.
+		*/
+		void Release() override;
+
+	private:
+		std::atomic<u32>				frameIndex_{ 0 };
+		std::vector<ObjPtr<ITexture>>	backBuffers_;
+	};	// class Swapchain
+
+}
+//	EOF
@@ -0,0 +1,161 @@
+﻿#include "texture.h"
+
+#include <cassert>
+
+#include "device.h"
+
+
+namespace mll
+{
+	MLL_IMPLEMENT_POOL_ALLOCATOR(Texture, AllocCategory::Texture);
+
+	void Texture::Release()
+	{
+		KillSelf();
+	}
+
+	void Texture::OnObjectNameChanged()
+	{
+		auto device = static_cast<Device*>(pParentDevice_);
+		if (device->IsNativeObjectNameEnabled())
+		{
+			device->SetNativeObjectName(VK_OBJECT_TYPE_IMAGE, reinterpret_cast<u64>(image_), GetObjectName());
+		}
+	}
+
+	//-----------------------------------------------------------
+	// initialize native image.
+	//-----------------------------------------------------------
+	Result::Type Texture::Initialize(Device* pDevice, const TextureDesc& desc)
+	{
+		desc_ = desc;
+
+		if (desc.usageFlags & (ResourceUsageFlag::ConstantBuffer | ResourceUsageFlag::IndexBuffer | ResourceUsageFlag::VertexBuffer | ResourceUsageFlag::IndirectArg))
+		{
+			return Result::InvalidArgs;
+		}
+		if (desc.dimension == ResourceDimension::Buffer || desc.format == ResourceFormat::Unknown || desc.width == 0)
+		{
+			return Result::InvalidArgs;
+		}
+
+		device_ = pDevice->GetNativeDevice();
+		bool is_3d = desc.dimension == ResourceDimension::Texture3D;
+		aspect_ = GetNativeImageAspect(desc.format);
+		extent_.width = desc.width;
+		extent_.height = (desc.dimension == ResourceDimension::Texture1D || desc.height == 0) ? 1 : desc.height;
+		extent_.depth = (is_3d && desc.depth > 0) ? desc.depth : 1;
+		mipLevels_ = (desc.mipLevels > 0) ? desc.mipLevels : 1;
+
+		// every texture is a transfer target of clear, copy and resolve.
+		VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		usage |= (desc.usageFlags & ResourceUsageFlag::ShaderResource) ? VK_IMAGE_USAGE_SAMPLED_BIT : 0;
+		usage |= (desc.usageFlags & ResourceUsageFlag::RenderTarget) ? VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT : 0;
+		usage |= (desc.usageFlags & ResourceUsageFlag::DepthStencil) ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : 0;
+		usage |= (desc.usageFlags & ResourceUsageFlag::UnorderedAccess) ? VK_IMAGE_USAGE_STORAGE_BIT : 0;
+
+		// upload and readback heaps are linear images on host visible memory.
+		bool is_host = desc.heap != ResourceHeap::Default;
+
+		VkImageCreateInfo info{};
+		info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		info.imageType = GetNativeImageType(desc.dimension);
+		info.format = GetNativeResourceFormat(desc.format);
+		info.extent = extent_;
+		info.mipLevels = mipLevels_;
+		info.arrayLayers = (!is_3d && desc.arraySize > 0) ? desc.arraySize : 1;
+		info.samples = static_cast<VkSampleCountFlagBits>((desc.sampleCount > 0) ? desc.sampleCount : 1);
+		info.tiling = is_host ? VK_IMAGE_TILING_LINEAR : VK_IMAGE_TILING_OPTIMAL;
+		info.usage = usage;
+		info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		// resources are shared by all queue families, no ownership transfer is needed.
+		auto&& families = pDevice->GetSharedQueueFamilies();
+		if (families.size() > 1)
+		{
+			info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			info.queueFamilyIndexCount = static_cast<u32>(families.size());
+			info.pQueueFamilyIndices = families.data();
+		}
+		else
+		{
+			info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		}
+
+		if (vkCreateImage(device_, &info, nullptr, &image_) != VK_SUCCESS)
+		{
+			return Result::InvalidArgs;
+		}
+
+		// dedicated memory as committed resource.
+		VkMemoryRequirements reqs;
+		vkGetImageMemoryRequirements(device_, image_, &reqs);
+		auto properties = is_host ? (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		u32 type_index = pDevice->FindMemoryType(reqs.memoryTypeBits, properties);
+		if (type_index == ~0u)
+		{
+			type_index = pDevice->FindMemoryType(reqs.memoryTypeBits, 0);
+		}
+
+		VkMemoryAllocateInfo alloc_info{};
+		alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		alloc_info.allocationSize = reqs.size;
+		alloc_info.memoryTypeIndex = type_index;
+		if (vkAllocateMemory(device_, &alloc_info, nullptr, &memory_) != VK_SUCCESS)
+		{
+			return Result::OutOfMemory;
+		}
+		if (vkBindImageMemory(device_, image_, memory_, 0) != VK_SUCCESS)
+		{
+			return Result::InvalidOperation;
+		}
+
+		SetMemoryFootprint(desc.heap, reqs.size);
+
+		pDevice->InitializeImageLayout(image_, aspect_, GetRestingState());
+
+		return Result::Ok;
+	}
+
+	//-----------------------------------------------------------
+	// destroy native image.
+	//-----------------------------------------------------------
+	void Texture::Destroy()
+	{
+		if (image_ != VK_NULL_HANDLE)
+		{
+			vkDestroyImage(device_, image_, nullptr);
+			image_ = VK_NULL_HANDLE;
+		}
+		if (memory_ != VK_NULL_HANDLE)
+		{
+			vkFreeMemory(device_, memory_, nullptr);
+			memory_ = VK_NULL_HANDLE;
+		}
+	}
+
+
+#define Self()	static_cast<Texture*>(this)
+
+	//-----------------------------------------------------------
+	// get bindless index of shader resource view.
+	//-----------------------------------------------------------
+	u32 ITexture::GetBindlessSrvIndex() const
+	{
+		// views are not allocated in bindless descriptor heap.
+		return kInvalidBindlessIndex;
+	}
+
+	//-----------------------------------------------------------
+	// get bindless index of unordered access view.
+	//-----------------------------------------------------------
+	u32 ITexture::GetBindlessUavIndex() const
+	{
+		// views are not allocated in bindless descriptor heap.
+		return kInvalidBindlessIndex;
+	}
+
+#undef Self
+
+}
+//	EOF
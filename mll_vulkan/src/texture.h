@@ -0,0 +1,113 @@
+﻿#pragma once
+
+#include "native.h"
+
+
+namespace mll
+{
+	class Device;
+
+	//-----------------------------------------------------------
+	//! @brief texture resource.
+	//!
+	//! Subresource index is (mip + arraySlice * mipLevels) as D3D12.
+	//! Image rests in layout of initial state.
+	//-----------------------------------------------------------
+	class Texture
+		: public ITexture
+	{
+		MLL_DECLARE_POOL_ALLOCATOR();
+
+		friend class IDevice;
+
+	public:
+		// getter
+		VkImage GetNativeImage()
+		{
+			return image_;
+		}
+		VkImageAspectFlags GetNativeAspect() const
+		{
+			return aspect_;
+		}
+		u32 GetMipLevels() const
+		{
+			return mipLevels_;
+		}
+
+		/**
+		 * @brief get resting layout, access and stage.
+		*/
+		const NativeResourceState& GetRestingState() const
+		{
+			return GetNativeResourceState(desc_.initialState);
+		}
+
+		/**
+		 * @brief get vulkan subresource from subresource index.
+		*/
+		VkImageSubresourceLayers GetSubresourceLayers(u32 subresource) const
+		{
+			VkImageSubresourceLayers ret;
+			ret.aspectMask = aspect_;
+			ret.mipLevel = subresource % mipLevels_;
+			ret.baseArrayLayer = subresource / mipLevels_;
+			ret.layerCount = 1;
+			return ret;
+		}
+		VkImageSubresourceRange GetSubresourceRange(u32 subresource) const
+		{
+			VkImageSubresourceRange ret;
+			ret.aspectMask = aspect_;
+			ret.baseMipLevel = subresource % mipLevels_;
+			ret.levelCount = 1;
+			ret.baseArrayLayer = subresource / mipLevels_;
+			ret.layerCount = 1;
+			return ret;
+		}
+
+		/**
+		 * @brief get extent of mip level.
+		*/
+		VkExtent3D GetMipExtent(u32 mip) const
+		{
+			VkExtent3D ret;
+			ret.width = (extent_.width >> mip) > 0 ? (extent_.width >> mip) : 1;
+			ret.height = (extent_.height >> mip) > 0 ? (extent_.height >> mip) : 1;
+			ret.depth = (extent_.depth >> mip) > 0 ? (extent_.depth >> mip) : 1;
+			return ret;
+		}
+
+	private:
+		Texture()
+			: ITexture()
+		{}
+		~Texture()
+		{
+			Destroy();
+		}
+
+		Result::Type Initialize(Device* pDevice, const TextureDesc& desc);
+		void Destroy();
+
+		/**
+		 * @brief Release self.
+		*/
+		void Release() override;
+
+		/**
+		 * @brief Propagate object name to native object.
+		*/
+		void OnObjectNameChanged() override;
+
+	private:
+		VkDevice				device_ = VK_NULL_HANDLE;
+		VkImage					image_ = VK_NULL_HANDLE;
+		VkDeviceMemory			memory_ = VK_NULL_HANDLE;
+		VkImageAspectFlags		aspect_ = 0;
+		VkExtent3D				extent_ = {};
+		u32						mipLevels_ = 1;
+	};	// class Texture
+
+}
+//	EOF
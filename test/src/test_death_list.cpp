@@ -0,0 +1,86 @@
+﻿#include "mll/mll_defines.h"
+#include "mll/mll_interfaces.h"
+
+#include <cstdio>
+
+
+namespace
+{
+	int g_failCount = 0;
+
+	void Check(bool b, const char* what)
+	{
+		if (!b)
+		{
+			printf("FAILED: %s\n", what);
+			g_failCount++;
+		}
+	}
+
+	mll::ObjectTypeStats GetTextureStats(mll::IDevice* pDevice)
+	{
+		return pDevice->GetStats().objectTypes[mll::ObjectType::Texture];
+	}
+}
+
+//-----------------------------------------------------------
+// texture released after recording lives until submissions using it are completed.
+//-----------------------------------------------------------
+int main()
+{
+	using namespace mll;
+
+	auto device = IDevice::CreateGraphicsDevice(DeviceDesc());
+	if (!device.IsValid())
+	{
+		printf("failed to create device.\n");
+		return 1;
+	}
+
+	TextureDesc desc;
+	desc.SetDimension(ResourceDimension::Texture2D)
+		.SetWidth(64).SetHeight(64)
+		.SetFormat(ResourceFormat::R8G8B8A8_Unorm)
+		.SetUsageFlags(ResourceUsageFlag::RenderTarget);
+	ObjPtr<ITexture> src, dst;
+	device->CreateTexture(desc, src);
+	device->CreateTexture(desc, dst);
+
+	ObjPtr<ICommandList> cmd;
+	device->CreateCommandList(CommandListDesc(), cmd);
+
+	// record, release, process death list, then submit.
+	const f32 kColor[] = { 1.0f, 0.0f, 0.0f, 1.0f };
+	cmd->Begin();
+	cmd->ClearTexture(src, 0, kColor);
+	cmd->CopyTexture(dst, 0, src, 0);
+	cmd->End();
+	src.Reset();
+	dst.Reset();
+	device->ProcDeathList();
+	Check(GetTextureStats(device).totalDestroyedCount == 0, "recorded textures are destroyed before submission");
+
+	ICommandList* p_cmd = cmd;
+	auto ticket = device->Submit(CommandQueueType::Graphics, &p_cmd, 1);
+	device->WaitTicket(ticket);
+	device->ProcDeathList();
+	Check(GetTextureStats(device).totalDestroyedCount == 0, "recorded textures are destroyed while command list keeps stream");
+
+	// resubmission still uses the textures.
+	ticket = device->Submit(CommandQueueType::Graphics, &p_cmd, 1);
+	device->WaitTicket(ticket);
+
+	// next recording releases them, they are destroyed after completed submissions.
+	cmd->Begin();
+	cmd->End();
+	device->ProcDeathList();
+	Check(GetTextureStats(device).totalDestroyedCount == 2, "released textures are not destroyed after submissions");
+
+	cmd.Reset();
+	device.Reset();
+
+	printf("%s\n", (g_failCount == 0) ? "passed" : "failed");
+	return (g_failCount == 0) ? 0 : 1;
+}
+
+//	EOF